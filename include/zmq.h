@@ -215,19 +215,29 @@ ZMQ_EXPORT int zmq_ctx_destroy (void *context_);
  * alignment and raise sigbus on violations. Make sure applications allocate
  * zmq_msg_t on addresses aligned on a pointer-size boundary to avoid this issue.
  */
+
+/* Size of zmq_msg_t in bytes. Messages up to roughly this size minus 31
+ * bytes are stored inline rather than on the heap. libzmq can be built with
+ * 128 or 256 instead, in which case applications must be compiled with the
+ * same value; pkg-config and the CMake targets provide it.
+ */
+#ifndef ZMQ_MSG_T_BYTES
+#define ZMQ_MSG_T_BYTES 64
+#endif
+
 typedef struct zmq_msg_t
 {
 #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
-    __declspec(align (8)) unsigned char _[64];
+    __declspec(align (8)) unsigned char _[ZMQ_MSG_T_BYTES];
 #elif defined(_MSC_VER)                                                        \
   && (defined(_M_IX86) || defined(_M_ARM_ARMV7VE) || defined(_M_ARM))
-    __declspec(align (4)) unsigned char _[64];
+    __declspec(align (4)) unsigned char _[ZMQ_MSG_T_BYTES];
 #elif defined(__GNUC__) || defined(__INTEL_COMPILER)                           \
   || (defined(__SUNPRO_C) && __SUNPRO_C >= 0x590)                              \
   || (defined(__SUNPRO_CC) && __SUNPRO_CC >= 0x590)
-    unsigned char _[64] __attribute__ ((aligned (sizeof (void *))));
+    unsigned char _[ZMQ_MSG_T_BYTES] __attribute__ ((aligned (sizeof (void *))));
 #else
-    unsigned char _[64];
+    unsigned char _[ZMQ_MSG_T_BYTES];
 #endif
 } zmq_msg_t;
 
@@ -662,6 +672,20 @@ ZMQ_EXPORT void zmq_threadclose (void *thread_);
 #define ZMQ_NORM_NUM_PARITY 122
 #define ZMQ_NORM_NUM_AUTOPARITY 123
 #define ZMQ_NORM_PUSH 124
+#define ZMQ_CONFLATE_KEY_SIZE 125
+#define ZMQ_SNDHWM_BYTES 126
+#define ZMQ_RCVHWM_BYTES 127
+#define ZMQ_XPUB_SPILL_DIR 128
+#define ZMQ_WS_DEFLATE 129
+#define ZMQ_WS_DEFLATE_THRESHOLD 130
+#define ZMQ_WS_DEFLATE_NO_CONTEXT_TAKEOVER 131
+#define ZMQ_WS_FRAGMENT_SIZE 132
+#define ZMQ_CURVE_TICKET_LIFETIME 133
+#define ZMQ_CURVE_CIPHER 134
+#define ZMQ_ZAP_CACHE_TTL 135
+#define ZMQ_ZAP_CACHE_SIZE 136
+#define ZMQ_ZMTP_V3_ONLY 137
+#define ZMQ_TCP_FASTOPEN 138
 
 /*  DRAFT ZMQ_NORM_MODE options                                               */
 #define ZMQ_NORM_FIXED 0
@@ -670,6 +694,10 @@ ZMQ_EXPORT void zmq_threadclose (void *thread_);
 #define ZMQ_NORM_CCE 3
 #define ZMQ_NORM_CCE_ECNONLY 4
 
+/*  DRAFT ZMQ_CURVE_CIPHER options                                            */
+#define ZMQ_CURVE_CIPHER_XSALSA20POLY1305 0
+#define ZMQ_CURVE_CIPHER_AES256GCM 1
+
 /*  DRAFT ZMQ_RECONNECT_STOP options                                          */
 #define ZMQ_RECONNECT_STOP_CONN_REFUSED 0x1
 #define ZMQ_RECONNECT_STOP_HANDSHAKE_FAILED 0x2
@@ -677,6 +705,14 @@ ZMQ_EXPORT void zmq_threadclose (void *thread_);
 
 /*  DRAFT Context options                                                     */
 #define ZMQ_ZERO_COPY_RECV 10
+#define ZMQ_MAX_QUEUED_BYTES 11
+#define ZMQ_HUGEPAGES 12
+#define ZMQ_MSG_PIPE_GRANULARITY 13
+#define ZMQ_CMD_PIPE_GRANULARITY 14
+#define ZMQ_PIPE_CHUNK_CACHE 15
+#define ZMQ_CRYPTO_THREADS 16
+#define ZMQ_DNS_CACHE_TTL 17
+#define ZMQ_DNS_CACHE_NEGATIVE_TTL 18
 
 /*  DRAFT Context methods.                                                    */
 ZMQ_EXPORT int zmq_ctx_set_ext (void *context_,
@@ -688,6 +724,12 @@ ZMQ_EXPORT int zmq_ctx_get_ext (void *context_,
                                 void *optval_,
                                 size_t *optvallen_);
 
+typedef void *(zmq_alloc_fn) (size_t size_, void *hint_);
+ZMQ_EXPORT int zmq_ctx_set_allocator (void *context_,
+                                      zmq_alloc_fn *alloc_fn_,
+                                      zmq_free_fn *free_fn_,
+                                      void *hint_);
+
 /*  DRAFT Socket methods.                                                     */
 ZMQ_EXPORT int zmq_join (void *s, const char *group);
 ZMQ_EXPORT int zmq_leave (void *s, const char *group);
@@ -700,6 +742,8 @@ ZMQ_EXPORT int zmq_msg_set_group (zmq_msg_t *msg, const char *group);
 ZMQ_EXPORT const char *zmq_msg_group (zmq_msg_t *msg);
 ZMQ_EXPORT int
 zmq_msg_init_buffer (zmq_msg_t *msg_, const void *buf_, size_t size_);
+ZMQ_EXPORT int
+zmq_msg_init_static (zmq_msg_t *msg_, const void *data_, size_t size_);
 
 /*  DRAFT Msg property names.                                                 */
 #define ZMQ_MSG_PROPERTY_ROUTING_ID "Routing-Id"
@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.hpp"
+
+#ifdef ZMQ_HAVE_WS
+
+#include "msg.hpp"
+#include "random.hpp"
+#include "ws_decoder.hpp"
+#include "ws_encoder.hpp"
+#include "ws_mask.hpp"
+
+#include <vector>
+
+/*
+   WebSocket codec benchmark.
+
+   Measures, for a range of message sizes, how fast payloads are masked
+   by ws_mask and by the plain byte loop it replaced, how fast a client's
+   encoder turns messages into masked frames, and how fast a server's
+   decoder turns such frames back into messages. Figures are in MB/s of
+   payload.
+*/
+
+static const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+
+//  Bytes to process per measurement.
+static const size_t volume = 256 * 1024 * 1024;
+
+static void mask_bytewise (unsigned char *data_, size_t size_)
+{
+    for (size_t i = 0; i < size_; i++)
+        data_[i] = data_[i] ^ mask[i % 4];
+}
+
+static double mb_per_s (size_t bytes_, unsigned long elapsed_)
+{
+    if (!elapsed_)
+        elapsed_ = 1;
+    return static_cast<double> (bytes_) / elapsed_;
+}
+
+static double benchmark_mask (size_t size_, bool bytewise_)
+{
+    std::vector<unsigned char> data (size_);
+    const size_t rounds = volume / size_;
+    void *watch = zmq_stopwatch_start ();
+    for (size_t r = 0; r != rounds; r++) {
+        if (bytewise_)
+            mask_bytewise (&data[0], size_);
+        else
+            zmq::ws_mask (&data[0], &data[0], size_, mask, 0);
+    }
+    const unsigned long elapsed = zmq_stopwatch_stop (watch);
+    //  Keep the compiler from dropping the work.
+    if (data[0] == 0x42)
+        printf (" ");
+    return mb_per_s (rounds * size_, elapsed);
+}
+
+static double benchmark_encoder (size_t size_,
+                                 std::vector<unsigned char> *stream_)
+{
+    const zmq::allocator_t hooks = {NULL, NULL, NULL};
+    zmq::ws_encoder_t encoder (8192, true, hooks);
+    const size_t rounds = volume / size_;
+    stream_->clear ();
+
+    void *watch = zmq_stopwatch_start ();
+    for (size_t r = 0; r != rounds; r++) {
+        zmq::msg_t msg;
+        const int rc = msg.init_size (size_);
+        if (rc != 0) {
+            printf ("error in init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        encoder.load_msg (&msg);
+        unsigned char *data = NULL;
+        size_t size;
+        while ((size = encoder.encode (&data, 0)) > 0) {
+            //  Keep one frame for the decoder.
+            if (r == 0)
+                stream_->insert (stream_->end (), data, data + size);
+            data = NULL;
+        }
+        msg.close ();
+    }
+    const unsigned long elapsed = zmq_stopwatch_stop (watch);
+    return mb_per_s (rounds * size_, elapsed);
+}
+
+static double benchmark_decoder (size_t size_,
+                                 const std::vector<unsigned char> &frame_)
+{
+    const zmq::allocator_t hooks = {NULL, NULL, NULL};
+    zmq::ws_decoder_t decoder (8192, -1, false, true, hooks);
+
+    //  Frames back to back, as read from the socket.
+    const size_t frames_per_batch = 1 + 1024 * 1024 / frame_.size ();
+    std::vector<unsigned char> batch;
+    for (size_t f = 0; f != frames_per_batch; f++)
+        batch.insert (batch.end (), frame_.begin (), frame_.end ());
+    const size_t rounds = 1 + volume / (size_ * frames_per_batch);
+
+    void *watch = zmq_stopwatch_start ();
+    for (size_t r = 0; r != rounds; r++) {
+        size_t pos = 0;
+        while (pos < batch.size ()) {
+            size_t used = 0;
+            const int rc =
+              decoder.decode (&batch[pos], batch.size () - pos, used);
+            if (rc < 0) {
+                printf ("error in decode: %s\n", zmq_strerror (errno));
+                exit (1);
+            }
+            pos += used;
+        }
+    }
+    const unsigned long elapsed = zmq_stopwatch_stop (watch);
+    return mb_per_s (rounds * frames_per_batch * size_, elapsed);
+}
+
+int main ()
+{
+    zmq::random_open ();
+
+    const size_t sizes[] = {16, 128, 1024, 16 * 1024, 256 * 1024,
+                            4 * 1024 * 1024};
+
+    printf ("%10s %12s %12s %12s %12s\n", "size [B]", "bytewise", "ws_mask",
+            "encoder", "decoder");
+    for (size_t i = 0; i != sizeof sizes / sizeof sizes[0]; i++) {
+        const size_t size = sizes[i];
+        std::vector<unsigned char> frame;
+        const double bytewise = benchmark_mask (size, true);
+        const double masked = benchmark_mask (size, false);
+        const double encoder = benchmark_encoder (size, &frame);
+        const double decoder = benchmark_decoder (size, frame);
+        printf ("%10d %12.0f %12.0f %12.0f %12.0f\n", static_cast<int> (size),
+                bytewise, masked, encoder, decoder);
+    }
+    printf ("all figures in [MB/s] of payload\n");
+
+    zmq::random_close ();
+    return 0;
+}
+
+#else
+
+int main ()
+{
+    printf ("built without WebSocket support\n");
+    return 0;
+}
+
+#endif
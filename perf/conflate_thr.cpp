@@ -0,0 +1,331 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+/*
+   Conflated throughput benchmark.
+
+   A PUSH socket floods a PULL socket, both with ZMQ_CONFLATE set, over
+   inproc or tcp. Each message carries its sequence number, the receiver
+   reads until it gets the last one. The interesting figure is the rate
+   at which the sender can write into the conflating pipes, the number of
+   messages actually delivered shows how much was conflated.
+
+   The sender waits for the connection before it starts sending, and keeps
+   its socket open until the receiver is done, as closing it would write
+   the pipe delimiter over the last message.
+*/
+
+static int message_count;
+static size_t message_size;
+static const char *endpoint;
+static unsigned long send_elapsed;
+
+#if defined ZMQ_HAVE_WINDOWS
+static unsigned int __stdcall worker (void *ctx_)
+#else
+static void *worker (void *ctx_)
+#endif
+{
+    void *s;
+    void *done;
+    int rc;
+    int i;
+    int conflate = 1;
+    int immediate = 1;
+    zmq_msg_t msg;
+    void *watch;
+
+    done = zmq_socket (ctx_, ZMQ_PAIR);
+    if (!done) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_connect (done, "inproc://conflate_thr_done");
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    s = zmq_socket (ctx_, ZMQ_PUSH);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_setsockopt (s, ZMQ_CONFLATE, &conflate, sizeof (conflate));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_setsockopt (s, ZMQ_IMMEDIATE, &immediate, sizeof (immediate));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_connect (s, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    watch = zmq_stopwatch_start ();
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, message_size);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        memcpy (zmq_msg_data (&msg), &i, sizeof (i));
+
+        rc = zmq_sendmsg (s, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_sendmsg: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        rc = zmq_msg_close (&msg);
+        if (rc != 0) {
+            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+
+    send_elapsed = zmq_stopwatch_stop (watch);
+
+    rc = zmq_recv (done, NULL, 0, 0);
+    if (rc < 0) {
+        printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_close (done);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main        zmq_perf_conflate_thr_main
+#endif
+
+int main(int argc, const char **argv)
+{
+#if defined ZMQ_HAVE_WINDOWS
+    HANDLE local_thread;
+#else
+    pthread_t local_thread;
+#endif
+    void *ctx;
+    void *s;
+    void *done;
+    int rc;
+    int conflate = 1;
+    int linger = 0;
+    int seq = -1;
+    int received = 0;
+    zmq_msg_t msg;
+    void *watch;
+    unsigned long elapsed;
+    unsigned long throughput;
+
+    if (argc != 4) {
+        printf ("usage: conflate_thr <inproc|tcp> <message-size> "
+                "<message-count>\n");
+        return 1;
+    }
+
+    if (strcmp (argv[1], "inproc") == 0)
+        endpoint = "inproc://conflate_thr_test";
+    else if (strcmp (argv[1], "tcp") == 0)
+        endpoint = "tcp://127.0.0.1:5556";
+    else {
+        printf ("unknown transport: %s\n", argv[1]);
+        return 1;
+    }
+    message_size = atoi (argv[2]);
+    message_count = atoi (argv[3]);
+    if (message_size < sizeof (int) || message_count < 1) {
+        printf ("message size must be at least %d [B]\n", (int) sizeof (int));
+        return 1;
+    }
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    s = zmq_socket (ctx, ZMQ_PULL);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_setsockopt (s, ZMQ_CONFLATE, &conflate, sizeof (conflate));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_setsockopt (s, ZMQ_LINGER, &linger, sizeof (linger));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_bind (s, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    done = zmq_socket (ctx, ZMQ_PAIR);
+    if (!done) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_bind (done, "inproc://conflate_thr_done");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    printf ("transport: %s\n", argv[1]);
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+
+    watch = zmq_stopwatch_start ();
+
+#if defined ZMQ_HAVE_WINDOWS
+    local_thread = (HANDLE) _beginthreadex (NULL, 0, worker, ctx, 0, NULL);
+    if (local_thread == 0) {
+        printf ("error in _beginthreadex\n");
+        return -1;
+    }
+#else
+    rc = pthread_create (&local_thread, NULL, worker, ctx);
+    if (rc != 0) {
+        printf ("error in pthread_create: %s\n", zmq_strerror (rc));
+        return -1;
+    }
+#endif
+
+    while (seq != message_count - 1) {
+        rc = zmq_recvmsg (s, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_recvmsg: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        if (zmq_msg_size (&msg) != message_size) {
+            printf ("message of incorrect size received\n");
+            return -1;
+        }
+        memcpy (&seq, zmq_msg_data (&msg), sizeof (seq));
+        received++;
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_send (done, NULL, 0, 0);
+    if (rc < 0) {
+        printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    DWORD rc2 = WaitForSingleObject (local_thread, INFINITE);
+    if (rc2 == WAIT_FAILED) {
+        printf ("error in WaitForSingleObject\n");
+        return -1;
+    }
+    BOOL rc3 = CloseHandle (local_thread);
+    if (rc3 == 0) {
+        printf ("error in CloseHandle\n");
+        return -1;
+    }
+#else
+    rc = pthread_join (local_thread, NULL);
+    if (rc != 0) {
+        printf ("error in pthread_join: %s\n", zmq_strerror (rc));
+        return -1;
+    }
+#endif
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_close (done);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    if (send_elapsed == 0)
+        send_elapsed = 1;
+    throughput =
+      (unsigned long) ((double) message_count / (double) send_elapsed * 1000000);
+    printf ("mean send throughput: %d [msg/s]\n", (int) throughput);
+
+    throughput =
+      (unsigned long) ((double) received / (double) elapsed * 1000000);
+    printf ("messages received: %d (%.3f%%)\n", received,
+            (double) received * 100 / (double) message_count);
+    printf ("mean receive throughput: %d [msg/s]\n", (int) throughput);
+
+    return 0;
+}
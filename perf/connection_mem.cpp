@@ -0,0 +1,330 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/*
+   Memory per connection benchmark.
+
+   A number of DEALER sockets connect to a ROUTER over tcp, each sends one
+   message and waits for it to come back. The memory in use is sampled
+   before the connections are made, once every connection has seen
+   traffic, and again once they were idle long enough for the engines to
+   release their buffers. Both ends of every connection live in this
+   process, so the figures cover two engines per connection.
+
+   Memory is reported as the bytes handed out through the context's
+   allocator hooks, which is exactly what the data path holds, and as the
+   resident set size where the platform makes it available. The latter
+   also includes sockets, pipes and file descriptors, and depends on the
+   C library returning freed memory to the system.
+*/
+
+//  Bytes currently allocated through the hooks. Blocks carry their size in
+//  front of the data so that they can be accounted for when freed.
+static size_t live_bytes;
+
+#if defined ZMQ_HAVE_WINDOWS
+static CRITICAL_SECTION live_bytes_sync;
+#else
+static pthread_mutex_t live_bytes_sync = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lock_live_bytes ()
+{
+#if defined ZMQ_HAVE_WINDOWS
+    EnterCriticalSection (&live_bytes_sync);
+#else
+    pthread_mutex_lock (&live_bytes_sync);
+#endif
+}
+
+static void unlock_live_bytes ()
+{
+#if defined ZMQ_HAVE_WINDOWS
+    LeaveCriticalSection (&live_bytes_sync);
+#else
+    pthread_mutex_unlock (&live_bytes_sync);
+#endif
+}
+
+static const size_t block_header_size = 16;
+
+static size_t get_live_bytes ()
+{
+    lock_live_bytes ();
+    const size_t bytes = live_bytes;
+    unlock_live_bytes ();
+    return bytes;
+}
+
+#ifdef ZMQ_BUILD_DRAFT_API
+static void *counting_alloc (size_t size_, void *)
+{
+    unsigned char *block =
+      static_cast<unsigned char *> (malloc (block_header_size + size_));
+    if (!block)
+        return NULL;
+    memcpy (block, &size_, sizeof (size_));
+    lock_live_bytes ();
+    live_bytes += size_;
+    unlock_live_bytes ();
+    return block + block_header_size;
+}
+
+static void counting_free (void *data_, void *)
+{
+    unsigned char *block = static_cast<unsigned char *> (data_)
+                           - block_header_size;
+    size_t size;
+    memcpy (&size, block, sizeof (size));
+    lock_live_bytes ();
+    live_bytes -= size;
+    unlock_live_bytes ();
+    free (block);
+}
+#endif
+
+//  Returns the resident set size in bytes, or 0 if it is not available.
+static size_t get_rss ()
+{
+#if defined ZMQ_HAVE_LINUX
+    FILE *f = fopen ("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int n = fscanf (f, "%lu %lu", &size, &resident);
+    fclose (f);
+    if (n != 2)
+        return 0;
+    return (size_t) resident * (size_t) sysconf (_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+static void report (const char *stage_,
+                    size_t bytes_,
+                    size_t base_bytes_,
+                    size_t rss_,
+                    size_t base_rss_,
+                    int connection_count_)
+{
+    printf ("%s: allocator %d [B/connection]", stage_,
+            (int) ((bytes_ - base_bytes_) / connection_count_));
+    if (rss_ && base_rss_)
+        printf (", rss %d [B/connection]",
+                rss_ > base_rss_
+                  ? (int) ((rss_ - base_rss_) / connection_count_)
+                  : 0);
+    printf ("\n");
+}
+
+//  Sends a message from every dealer and echoes it back from the router.
+static int round_trip (void *router_,
+                       void **dealers_,
+                       int connection_count_,
+                       char *buf_,
+                       size_t message_size_)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i != connection_count_; i++) {
+        rc = zmq_send (dealers_[i], buf_, message_size_, 0);
+        if (rc < 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    for (i = 0; i != connection_count_; i++) {
+        zmq_msg_t routing_id;
+        zmq_msg_t msg;
+        zmq_msg_init (&routing_id);
+        zmq_msg_init (&msg);
+        if (zmq_msg_recv (&routing_id, router_, 0) < 0
+            || zmq_msg_recv (&msg, router_, 0) < 0) {
+            printf ("error in zmq_msg_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        if (zmq_msg_send (&routing_id, router_, ZMQ_SNDMORE) < 0
+            || zmq_msg_send (&msg, router_, 0) < 0) {
+            printf ("error in zmq_msg_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    for (i = 0; i != connection_count_; i++) {
+        rc = zmq_recv (dealers_[i], buf_, message_size_ + 1, 0);
+        if (rc != (int) message_size_) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#if defined(BUILD_MONOLITHIC)
+#define main zmq_perf_connection_mem_main
+#endif
+
+int main (int argc, const char **argv)
+{
+    const char *endpoint = "tcp://127.0.0.1:5557";
+    int connection_count;
+    size_t message_size;
+    void *ctx;
+    void *router;
+    void **dealers;
+    char *buf;
+    int linger = 0;
+    int rc;
+    int i;
+
+    if (argc != 3) {
+        printf ("usage: connection_mem <connection-count> <message-size>\n");
+        return 1;
+    }
+    connection_count = atoi (argv[1]);
+    message_size = atoi (argv[2]);
+    if (connection_count < 1) {
+        printf ("connection count must be at least 1\n");
+        return 1;
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    InitializeCriticalSection (&live_bytes_sync);
+#endif
+
+    ctx = zmq_ctx_new ();
+    if (!ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+#ifdef ZMQ_BUILD_DRAFT_API
+    rc = zmq_ctx_set_allocator (ctx, counting_alloc, counting_free, NULL);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set_allocator: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+#else
+    printf ("allocator hooks not available, built without draft API\n");
+#endif
+
+    rc = zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, connection_count + 16);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    router = zmq_socket (ctx, ZMQ_ROUTER);
+    if (!router) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_setsockopt (router, ZMQ_LINGER, &linger, sizeof (linger));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_bind (router, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    dealers = (void **) malloc (connection_count * sizeof (void *));
+    buf = (char *) malloc (message_size + 1);
+    if (!dealers || !buf) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+    memset (buf, 'x', message_size);
+
+    printf ("connection count: %d\n", connection_count);
+    printf ("message size: %d [B]\n", (int) message_size);
+
+    const size_t base_bytes = get_live_bytes ();
+    const size_t base_rss = get_rss ();
+
+    for (i = 0; i != connection_count; i++) {
+        dealers[i] = zmq_socket (ctx, ZMQ_DEALER);
+        if (!dealers[i]) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_setsockopt (dealers[i], ZMQ_LINGER, &linger, sizeof (linger));
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_connect (dealers[i], endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    //  Setting up many connections takes a while, so the first round trip
+    //  only makes sure that all of them are established. The second one
+    //  has every connection see traffic at about the same time.
+    if (round_trip (router, dealers, connection_count, buf, message_size) != 0
+        || round_trip (router, dealers, connection_count, buf, message_size)
+             != 0)
+        return -1;
+
+    report ("active", get_live_bytes (), base_bytes, get_rss (), base_rss,
+            connection_count);
+
+    //  Leave the connections alone for a while.
+    zmq_sleep (3);
+
+    report ("idle", get_live_bytes (), base_bytes, get_rss (), base_rss,
+            connection_count);
+
+    for (i = 0; i != connection_count; i++) {
+        rc = zmq_close (dealers[i]);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    rc = zmq_close (router);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    free (buf);
+    free (dealers);
+
+#if defined ZMQ_HAVE_WINDOWS
+    DeleteCriticalSection (&live_bytes_sync);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../include/zmq.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+   CURVE handshake rate benchmark.
+
+   A number of DEALER sockets connect to a ROUTER over tcp with CURVE
+   security. Once all of them are connected, the ROUTER drops every
+   connection by unbinding and binding again, and the time it takes until
+   all the clients have reconnected and finished the handshake is
+   measured. This is repeated for a number of rounds, like a server that
+   sees its clients come back after a network outage.
+
+   With resume set, the sockets use ZMQ_CURVE_TICKET_LIFETIME, so that the
+   reconnecting clients resume their sessions with the short handshake.
+
+   The server and the clients use separate contexts, so that the handshake
+   work of either side runs on its own io thread.
+*/
+
+const char *endpoint = "tcp://127.0.0.1:5558";
+
+//  Waits for count_ handshakes on the server and returns the number of
+//  those that failed. Polling the server lets it process the commands
+//  that drop its connections meanwhile.
+static int wait_for_handshakes (void *server_, void *monitor_, int count_)
+{
+    zmq_pollitem_t items[] = {{monitor_, 0, ZMQ_POLLIN, 0},
+                              {server_, 0, ZMQ_POLLIN, 0}};
+    int failed = 0;
+
+    while (count_ > 0) {
+        if (zmq_poll (items, 2, -1) < 0) {
+            printf ("error in zmq_poll: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        if (!(items[0].revents & ZMQ_POLLIN))
+            continue;
+
+        zmq_msg_t msg;
+        zmq_msg_init (&msg);
+        if (zmq_msg_recv (&msg, monitor_, 0) < 0) {
+            printf ("error in zmq_msg_recv: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        unsigned short event;
+        memcpy (&event, zmq_msg_data (&msg), sizeof (event));
+        //  Drop the endpoint
+        zmq_msg_recv (&msg, monitor_, 0);
+        zmq_msg_close (&msg);
+
+        if (event != ZMQ_EVENT_HANDSHAKE_SUCCEEDED)
+            failed++;
+        else
+            count_--;
+    }
+    return failed;
+}
+
+static void set_int (void *socket_, int option_, int value_)
+{
+    if (zmq_setsockopt (socket_, option_, &value_, sizeof (value_)) != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+static void set_key (void *socket_, int option_, const char *key_)
+{
+    if (zmq_setsockopt (socket_, option_, key_, 41) != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+#if defined(BUILD_MONOLITHIC)
+#define main zmq_perf_curve_handshake_thr_main
+#endif
+
+int main (int argc, const char **argv)
+{
+    int connection_count;
+    int round_count;
+    int resume = 0;
+    char server_public[41];
+    char server_secret[41];
+    char client_public[41];
+    char client_secret[41];
+    void *server_ctx;
+    void *client_ctx;
+    void *server;
+    void *monitor;
+    void **clients;
+    void *watch;
+    unsigned long elapsed;
+    int failed = 0;
+    int rc;
+    int i;
+
+    if (argc != 3 && argc != 4) {
+        printf ("usage: curve_handshake_thr <connection-count> <round-count> "
+                "[<resume>]\n");
+        return 1;
+    }
+    connection_count = atoi (argv[1]);
+    round_count = atoi (argv[2]);
+    if (argc == 4)
+        resume = atoi (argv[3]);
+    if (connection_count < 1 || round_count < 1) {
+        printf ("connection and round counts must be at least 1\n");
+        return 1;
+    }
+    if (!zmq_has ("curve")) {
+        printf ("CURVE encryption not available\n");
+        return 1;
+    }
+#ifndef ZMQ_CURVE_TICKET_LIFETIME
+    if (resume) {
+        printf ("resumption not available, built without draft API\n");
+        return 1;
+    }
+#endif
+
+    if (zmq_curve_keypair (server_public, server_secret) != 0
+        || zmq_curve_keypair (client_public, client_secret) != 0) {
+        printf ("error in zmq_curve_keypair: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    server_ctx = zmq_ctx_new ();
+    client_ctx = zmq_ctx_new ();
+    if (!server_ctx || !client_ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_ctx_set (client_ctx, ZMQ_MAX_SOCKETS, connection_count + 16);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    server = zmq_socket (server_ctx, ZMQ_ROUTER);
+    if (!server) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    set_int (server, ZMQ_LINGER, 0);
+    set_int (server, ZMQ_CURVE_SERVER, 1);
+    set_key (server, ZMQ_CURVE_SECRETKEY, server_secret);
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+    if (resume)
+        set_int (server, ZMQ_CURVE_TICKET_LIFETIME, 3600 * 1000);
+#endif
+
+    rc = zmq_socket_monitor (server, "inproc://handshakes",
+                             ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+                               | ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL
+                               | ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL
+                               | ZMQ_EVENT_HANDSHAKE_FAILED_AUTH);
+    if (rc != 0) {
+        printf ("error in zmq_socket_monitor: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    monitor = zmq_socket (server_ctx, ZMQ_PAIR);
+    if (!monitor || zmq_connect (monitor, "inproc://handshakes") != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_bind (server, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    clients = (void **) malloc (connection_count * sizeof (void *));
+    if (!clients) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+    for (i = 0; i != connection_count; i++) {
+        clients[i] = zmq_socket (client_ctx, ZMQ_DEALER);
+        if (!clients[i]) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        set_int (clients[i], ZMQ_LINGER, 0);
+        //  Come back right away once the server drops the connection
+        set_int (clients[i], ZMQ_RECONNECT_IVL, 1);
+        set_key (clients[i], ZMQ_CURVE_SERVERKEY, server_public);
+        set_key (clients[i], ZMQ_CURVE_PUBLICKEY, client_public);
+        set_key (clients[i], ZMQ_CURVE_SECRETKEY, client_secret);
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+        if (resume)
+            set_int (clients[i], ZMQ_CURVE_TICKET_LIFETIME, 1);
+#endif
+        rc = zmq_connect (clients[i], endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    printf ("connection count: %d\n", connection_count);
+    printf ("round count: %d\n", round_count);
+    printf ("resume: %s\n", resume ? "yes" : "no");
+
+    //  The first handshakes set up the connections (and hand out the
+    //  tickets), they are not measured.
+    failed += wait_for_handshakes (server, monitor, connection_count);
+
+    watch = zmq_stopwatch_start ();
+
+    for (int round = 0; round != round_count; round++) {
+        rc = zmq_unbind (server, endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_unbind: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        //  The listener is closed in the background
+        while (zmq_bind (server, endpoint) != 0) {
+            if (errno != EADDRINUSE) {
+                printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+        failed += wait_for_handshakes (server, monitor, connection_count);
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    const double rate = (double) connection_count * round_count
+                        / ((double) elapsed / 1000000);
+    printf ("failed handshakes: %d\n", failed);
+    printf ("mean handshake rate: %d [connections/s]\n", (int) rate);
+
+    for (i = 0; i != connection_count; i++)
+        zmq_close (clients[i]);
+    zmq_close (monitor);
+    zmq_close (server);
+    zmq_ctx_term (client_ctx);
+    zmq_ctx_term (server_ctx);
+    free (clients);
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_ALLOCATOR_HPP_INCLUDED__
+#define __ZMQ_ALLOCATOR_HPP_INCLUDED__
+
+#include <stdlib.h>
+
+#include "../include/zmq.h"
+#include "zmq_draft.h"
+#include "msg_pool.hpp"
+
+namespace zmq
+{
+//  Memory allocation hooks set on a context with zmq_ctx_set_allocator.
+//  Sockets copy them at creation and hand them to their engines, which use
+//  them for message content, the decoders' receive buffers and the
+//  encoders' send buffers. Wherever such memory is freed, possibly from
+//  another thread, the hooks are copied next to it, so blocks can outlive
+//  the context. With no hooks set, the built-in message pool is used if it
+//  was enabled at build time, malloc and free otherwise.
+
+struct allocator_t
+{
+    zmq_alloc_fn *alloc_fn;
+    zmq_free_fn *free_fn;
+    void *hint;
+};
+
+inline void *default_allocate (size_t size_)
+{
+#ifdef ZMQ_USE_MSG_POOL
+    return msg_pool_t::allocate (size_);
+#else
+    return malloc (size_);
+#endif
+}
+
+inline void default_deallocate (void *ptr_)
+{
+#ifdef ZMQ_USE_MSG_POOL
+    msg_pool_t::deallocate (ptr_);
+#else
+    free (ptr_);
+#endif
+}
+
+inline void *allocate (const allocator_t &allocator_, size_t size_)
+{
+    if (allocator_.alloc_fn)
+        return allocator_.alloc_fn (size_, allocator_.hint);
+    return default_allocate (size_);
+}
+
+inline void deallocate (const allocator_t &allocator_, void *ptr_)
+{
+    if (allocator_.free_fn)
+        allocator_.free_fn (ptr_, allocator_.hint);
+    else
+        default_deallocate (ptr_);
+}
+}
+
+#endif
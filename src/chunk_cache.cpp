@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "chunk_cache.hpp"
+#include "err.hpp"
+#include "hugepage_pool.hpp"
+
+#include <new>
+#include <stdlib.h>
+
+zmq::chunk_cache_t::chunk_cache_t (size_t chunk_size_,
+                                   size_t max_bytes_,
+                                   bool hugepages_) :
+    _chunk_size (chunk_size_),
+    _hugepages (hugepages_),
+    _slot_count (
+      static_cast<atomic_counter_t::integer_t> (max_bytes_ / chunk_size_)),
+    _height (0),
+    _slots (NULL)
+{
+    if (_slot_count) {
+        _slots = new (std::nothrow) atomic_ptr_t<void>[_slot_count];
+        alloc_assert (_slots);
+    }
+}
+
+zmq::chunk_cache_t::~chunk_cache_t ()
+{
+    for (atomic_counter_t::integer_t i = 0; i < _slot_count; i++)
+        free_chunk (_slots[i].xchg (NULL));
+    delete[] _slots;
+}
+
+void *zmq::chunk_cache_t::allocate ()
+{
+    if (_slot_count) {
+        const atomic_counter_t::integer_t height =
+          _height.add (static_cast<atomic_counter_t::integer_t> (-1));
+        if (height == 0 || height > _slot_count) {
+            //  Empty, or another pop is backing off.
+            _height.add (1);
+        } else {
+            //  The slot is empty if the push that claimed it has not
+            //  stored its chunk yet.
+            void *chunk = _slots[height - 1].xchg (NULL);
+            if (chunk)
+                return chunk;
+        }
+    }
+    return allocate_chunk ();
+}
+
+void zmq::chunk_cache_t::deallocate (void *chunk_)
+{
+    if (!chunk_)
+        return;
+
+    if (_slot_count) {
+        const atomic_counter_t::integer_t height = _height.add (1);
+        if (height < _slot_count) {
+            //  The slot may still hold a chunk that a racing pop missed,
+            //  in which case the slot stays counted.
+            if (_slots[height].cas (NULL, chunk_) == NULL)
+                return;
+        } else
+            _height.sub (1);
+    }
+    free_chunk (chunk_);
+}
+
+void *zmq::chunk_cache_t::allocate_chunk ()
+{
+    if (_hugepages)
+        return hugepage_pool_t::allocate (_chunk_size, NULL);
+#if defined HAVE_POSIX_MEMALIGN
+    void *chunk;
+    if (posix_memalign (&chunk, ZMQ_CACHELINE_SIZE, _chunk_size) == 0)
+        return chunk;
+    return NULL;
+#else
+    return malloc (_chunk_size);
+#endif
+}
+
+void zmq::chunk_cache_t::free_chunk (void *chunk_)
+{
+    if (_hugepages)
+        hugepage_pool_t::deallocate (chunk_, NULL);
+    else
+        free (chunk_);
+}
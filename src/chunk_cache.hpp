@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_CHUNK_CACHE_HPP_INCLUDED__
+#define __ZMQ_CHUNK_CACHE_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "atomic_counter.hpp"
+#include "atomic_ptr.hpp"
+#include "macros.hpp"
+
+namespace zmq
+{
+//  Free yqueue chunks of a single size, shared by all message pipes of a
+//  context. A pipe that drains after a burst hands its chunks to the
+//  cache instead of freeing them, and the next pipe to grow takes them
+//  from there instead of allocating.
+//
+//  The cache is a stack of slots with an atomic height. Chunks are put
+//  into and taken out of slots with CAS and exchange, so concurrent pushes
+//  and pops never hand out a chunk twice. Under contention a chunk may be
+//  freed although there was room, or allocated although one was cached,
+//  which only costs an allocation. Chunks left in the cache are freed
+//  when it is destroyed.
+//
+//  Chunks are aligned to the cache line size, and taken from the hugepage
+//  pool if requested. Both functions are thread safe.
+
+class chunk_cache_t
+{
+  public:
+    chunk_cache_t (size_t chunk_size_, size_t max_bytes_, bool hugepages_);
+    ~chunk_cache_t ();
+
+    size_t chunk_size () const { return _chunk_size; }
+
+    //  Returns NULL if memory is exhausted.
+    void *allocate ();
+
+    void deallocate (void *chunk_);
+
+  private:
+    void *allocate_chunk ();
+    void free_chunk (void *chunk_);
+
+    const size_t _chunk_size;
+    const bool _hugepages;
+
+    //  Number of slots and the number of them in use. The height goes
+    //  below zero, that is wraps, while a pop on an empty cache backs off.
+    const atomic_counter_t::integer_t _slot_count;
+    atomic_counter_t _height;
+    atomic_ptr_t<void> *_slots;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (chunk_cache_t)
+};
+}
+
+#endif
@@ -46,6 +46,7 @@ struct command_t
         conn_failed,
         pipe_peer_stats,
         pipe_stats_publish,
+        resolved,
         done
     } type;
 
@@ -89,10 +90,11 @@ struct command_t
         } activate_read;
 
         //  Sent by pipe reader to inform pipe writer about how many
-        //  messages it has read so far.
+        //  messages and bytes it has read so far.
         struct
         {
             uint64_t msgs_read;
+            uint64_t bytes_read;
         } activate_write;
 
         //  Sent by pipe reader to writer after creating a new inpipe.
@@ -176,6 +178,13 @@ struct command_t
             endpoint_uri_pair_t *endpoint_pair;
         } pipe_stats_publish;
 
+        //  Sent by the context's DNS cache to a connecter once the address
+        //  it waits for has been looked up. Error is 0 on success.
+        struct
+        {
+            int error;
+        } resolved;
+
         //  Sent by reaper thread to the term thread when all the sockets
         //  are successfully deallocated.
         struct
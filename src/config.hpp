@@ -31,6 +31,31 @@ enum
     //  Maximum number of events the I/O thread can process in one go.
     max_io_events = 256,
 
+    //  Number of bytes a pipe may queue or dequeue before it reports them
+    //  to the context-wide ZMQ_MAX_QUEUED_BYTES accounting.
+    queued_bytes_batch = 8192,
+
+    //  Interval in milliseconds at which a blocked send re-checks the
+    //  context-wide ZMQ_MAX_QUEUED_BYTES budget.
+    queued_bytes_poll_interval = 10,
+
+    //  Bytes of free blocks per size class that each thread keeps in its
+    //  own message pool cache, and that the pool keeps in the cache shared
+    //  by all threads.
+    msg_pool_thread_cache_size = 256 * 1024,
+    msg_pool_shared_cache_size = 1024 * 1024,
+
+    //  Bytes of free blocks per size class that each thread keeps in its
+    //  own hugepage pool cache, and number of completely free regions per
+    //  size class that the pool keeps mapped.
+    hugepage_pool_thread_cache_size = 256 * 1024,
+    hugepage_pool_free_regions = 1,
+
+    //  Time in milliseconds without I/O after which a connection's engine
+    //  releases its encoder and decoder buffers. They are allocated again
+    //  on the next read or write.
+    engine_buffer_idle_interval = 1000,
+
     //  Maximal batch size of packets forwarded by a ZMQ proxy.
     //  Increasing this value improves throughput at the expense of
     //  latency and fairness.
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "crypto_pool.hpp"
+#include "stream_engine_base.hpp"
+#include "thread.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+
+zmq::crypto_job_t::crypto_job_t () : _state (idle), _done (NULL)
+{
+}
+
+zmq::crypto_job_t::~crypto_job_t ()
+{
+    zmq_assert (_state == idle);
+}
+
+zmq::crypto_pool_t::crypto_pool_t () : _stopping (false)
+{
+}
+
+zmq::crypto_pool_t::~crypto_pool_t ()
+{
+    _sync.lock ();
+    zmq_assert (_jobs.empty ());
+    _stopping = true;
+    _work_cond.broadcast ();
+    _sync.unlock ();
+
+    for (size_t i = 0, size = _threads.size (); i != size; i++) {
+        _threads[i]->stop ();
+        LIBZMQ_DELETE (_threads[i]);
+    }
+}
+
+bool zmq::crypto_pool_t::start (const thread_ctx_t &ctx_, int thread_count_)
+{
+    for (int i = 0; i != thread_count_; i++) {
+        thread_t *thread = new (std::nothrow) thread_t;
+        if (!thread) {
+            errno = ENOMEM;
+            return false;
+        }
+        try {
+            _threads.push_back (thread);
+        }
+        catch (const std::bad_alloc &) {
+            delete thread;
+            errno = ENOMEM;
+            return false;
+        }
+        char name[16] = "";
+        snprintf (name, sizeof (name), "Crypto/%d", i);
+        ctx_.start_thread (*thread, worker_routine, this, name);
+    }
+    return true;
+}
+
+void zmq::crypto_pool_t::post (crypto_job_t *job_, signaler_t *done_)
+{
+    scoped_lock_t locker (_sync);
+    zmq_assert (job_->_state == crypto_job_t::idle);
+    job_->_state = crypto_job_t::queued;
+    job_->_done = done_;
+    _jobs.push_back (job_);
+    _work_cond.broadcast ();
+}
+
+void zmq::crypto_pool_t::cancel (crypto_job_t *job_)
+{
+    scoped_lock_t locker (_sync);
+    if (job_->_state == crypto_job_t::queued) {
+        _jobs.erase (std::find (_jobs.begin (), _jobs.end (), job_));
+        job_->_state = crypto_job_t::idle;
+    }
+    while (job_->_state == crypto_job_t::running)
+        _done_cond.wait (&_sync, -1);
+}
+
+void zmq::crypto_pool_t::worker_routine (void *arg_)
+{
+    static_cast<crypto_pool_t *> (arg_)->work ();
+}
+
+void zmq::crypto_pool_t::work ()
+{
+    _sync.lock ();
+    while (true) {
+        while (_jobs.empty () && !_stopping)
+            _work_cond.wait (&_sync, -1);
+        if (_stopping)
+            break;
+
+        crypto_job_t *job = _jobs.front ();
+        _jobs.pop_front ();
+        job->_state = crypto_job_t::running;
+        _sync.unlock ();
+
+        job->run_crypto ();
+
+        //  Signal while still holding the lock, so that a job that is
+        //  cancelled meanwhile can't take the signaler away under us.
+        _sync.lock ();
+        job->_state = crypto_job_t::idle;
+        job->_done->send ();
+        _done_cond.broadcast ();
+    }
+    _sync.unlock ();
+}
+
+zmq::crypto_notifier_t::crypto_notifier_t (crypto_pool_t *pool_,
+                                           stream_engine_base_t *engine_) :
+    _pool (pool_),
+    _engine (engine_),
+    _handle (static_cast<handle_t> (NULL)),
+    _plugged (false)
+{
+}
+
+zmq::crypto_notifier_t::~crypto_notifier_t ()
+{
+    zmq_assert (!_plugged);
+}
+
+bool zmq::crypto_notifier_t::valid () const
+{
+    return _signaler.valid ();
+}
+
+void zmq::crypto_notifier_t::plug (io_thread_t *io_thread_)
+{
+    zmq_assert (!_plugged);
+    _plugged = true;
+    io_object_t::plug (io_thread_);
+    _handle = add_fd (_signaler.get_fd ());
+    set_pollin (_handle);
+}
+
+void zmq::crypto_notifier_t::unplug ()
+{
+    zmq_assert (_plugged);
+    _plugged = false;
+    rm_fd (_handle);
+    io_object_t::unplug ();
+}
+
+void zmq::crypto_notifier_t::post (crypto_job_t *job_)
+{
+    _pool->post (job_, &_signaler);
+}
+
+void zmq::crypto_notifier_t::cancel (crypto_job_t *job_)
+{
+    _pool->cancel (job_);
+
+    //  Drop the signal of a job that finished in the meantime, as the
+    //  signaler holds only one.
+    _signaler.recv_failable ();
+}
+
+void zmq::crypto_notifier_t::in_event ()
+{
+    _signaler.recv ();
+    _engine->crypto_job_done ();
+}
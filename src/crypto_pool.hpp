@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_CRYPTO_POOL_HPP_INCLUDED__
+#define __ZMQ_CRYPTO_POOL_HPP_INCLUDED__
+
+#include <deque>
+#include <vector>
+
+#include "macros.hpp"
+#include "mutex.hpp"
+#include "condition_variable.hpp"
+#include "io_object.hpp"
+#include "signaler.hpp"
+
+namespace zmq
+{
+class io_thread_t;
+class thread_t;
+class thread_ctx_t;
+class stream_engine_base_t;
+
+//  A piece of CPU bound work, e.g. the public key operations of a
+//  security handshake, that can be run on the crypto pool.
+
+class crypto_job_t
+{
+  public:
+    crypto_job_t ();
+    virtual ~crypto_job_t ();
+
+    //  Does the work. With a pool, this is called on one of its threads
+    //  and must not touch anything the io thread uses meanwhile.
+    virtual void run_crypto () = 0;
+
+  private:
+    friend class crypto_pool_t;
+
+    enum
+    {
+        idle,
+        queued,
+        running
+    } _state;
+
+    //  Signalled once the job has run.
+    signaler_t *_done;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (crypto_job_t)
+};
+
+//  Threads shared by all the engines of a context to run crypto jobs
+//  on, so that expensive handshakes don't hold up the io threads.
+
+class crypto_pool_t
+{
+  public:
+    crypto_pool_t ();
+
+    //  Stops the threads. No job may be queued or running.
+    ~crypto_pool_t ();
+
+    //  Starts thread_count_ threads with the context's thread settings.
+    //  Returns false if not all of them could be created.
+    bool start (const thread_ctx_t &ctx_, int thread_count_);
+
+    //  Queues job_ and signals done_ once it has run. The job must not be
+    //  queued or running already.
+    void post (crypto_job_t *job_, signaler_t *done_);
+
+    //  Makes sure job_ is neither queued nor running when this returns,
+    //  waiting for it to finish if it has started.
+    void cancel (crypto_job_t *job_);
+
+  private:
+    static void worker_routine (void *arg_);
+    void work ();
+
+    std::deque<crypto_job_t *> _jobs;
+    std::vector<thread_t *> _threads;
+    bool _stopping;
+
+    mutex_t _sync;
+
+    //  Woken when a job is queued or the pool stops.
+    condition_variable_t _work_cond;
+
+    //  Woken when a job has run.
+    condition_variable_t _done_cond;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (crypto_pool_t)
+};
+
+//  An engine's end of the pool. Posts the mechanism's jobs and, once one
+//  has run, lets the engine know in its io thread.
+
+class crypto_notifier_t ZMQ_FINAL : public io_object_t
+{
+  public:
+    crypto_notifier_t (crypto_pool_t *pool_, stream_engine_base_t *engine_);
+    ~crypto_notifier_t ();
+
+    //  False if the signaler couldn't be created, e.g. out of handles.
+    bool valid () const;
+
+    void plug (io_thread_t *io_thread_);
+    void unplug ();
+
+    void post (crypto_job_t *job_);
+    void cancel (crypto_job_t *job_);
+
+    //  i_poll_events interface implementation.
+    void in_event () ZMQ_OVERRIDE;
+
+  private:
+    crypto_pool_t *const _pool;
+    stream_engine_base_t *const _engine;
+
+    signaler_t _signaler;
+    handle_t _handle;
+    bool _plugged;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (crypto_notifier_t)
+};
+}
+
+#endif
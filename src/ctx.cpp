@@ -20,6 +20,11 @@
 #include "err.hpp"
 #include "msg.hpp"
 #include "random.hpp"
+#include "hugepage_pool.hpp"
+#include "chunk_cache.hpp"
+#include "crypto_pool.hpp"
+#include "dns_cache.hpp"
+#include "yqueue.hpp"
 
 #ifdef ZMQ_HAVE_VMCI
 #include <vmci_sockets.h>
@@ -56,11 +61,28 @@ zmq::ctx_t::ctx_t () :
     _io_thread_count (ZMQ_IO_THREADS_DFLT),
     _blocky (true),
     _ipv6 (false),
-    _zero_copy (true)
+    _zero_copy (true),
+    _hugepages (false),
+    _msg_pipe_granularity (message_pipe_granularity),
+    _cmd_pipe_granularity (command_pipe_granularity),
+    _pipe_chunk_cache_size (0),
+    _msg_chunk_cache (NULL),
+    _started (false),
+    _crypto_thread_count (0),
+    _crypto_pool (NULL),
+    _dns_cache_ttl (0),
+    _dns_cache_negative_ttl (0),
+    _dns_cache (NULL),
+    _max_queued_bytes (0),
+    _queued_bytes (0),
+    _queued_bytes_exceeded (0)
 {
 #ifdef HAVE_FORK
     _pid = getpid ();
 #endif
+    _allocator.alloc_fn = NULL;
+    _allocator.free_fn = NULL;
+    _allocator.hint = NULL;
 #ifdef ZMQ_HAVE_VMCI
     _vmci_fd = -1;
     _vmci_family = -1;
@@ -103,6 +125,15 @@ zmq::ctx_t::~ctx_t ()
     //  Deallocate the reaper thread object.
     LIBZMQ_DELETE (_reaper);
 
+    //  The engines that posted jobs are gone with the I/O threads.
+    LIBZMQ_DELETE (_crypto_pool);
+
+    //  So are the connecters that waited for lookups.
+    LIBZMQ_DELETE (_dns_cache);
+
+    //  All pipes are gone by now.
+    LIBZMQ_DELETE (_msg_chunk_cache);
+
     //  The mailboxes in _slots themselves were deallocated with their
     //  corresponding io_thread/socket objects.
 
@@ -284,6 +315,82 @@ int zmq::ctx_t::set (int option_, const void *optval_, size_t optvallen_)
             }
             break;
 
+        case ZMQ_MAX_QUEUED_BYTES:
+            if (optvallen_ == sizeof (uint64_t) || (is_int && value >= 0)) {
+                {
+                    scoped_lock_t locker (_opt_sync);
+                    if (optvallen_ == sizeof (uint64_t))
+                        memcpy (&_max_queued_bytes, optval_, sizeof (uint64_t));
+                    else
+                        _max_queued_bytes = static_cast<uint64_t> (value);
+                }
+                //  Sockets held back by the previous budget see the new one
+                //  right away, not only once more bytes are queued.
+                scoped_lock_t locker (_queued_bytes_sync);
+                update_queued_bytes_exceeded ();
+                return 0;
+            }
+            break;
+
+        case ZMQ_HUGEPAGES:
+            if (is_int && value >= 0) {
+                scoped_lock_t locker (_opt_sync);
+                _hugepages = (value != 0);
+                return 0;
+            }
+            break;
+
+        case ZMQ_MSG_PIPE_GRANULARITY:
+        case ZMQ_CMD_PIPE_GRANULARITY:
+        case ZMQ_PIPE_CHUNK_CACHE:
+            if (is_int && value >= (option_ == ZMQ_PIPE_CHUNK_CACHE ? 0 : 1)) {
+                scoped_lock_t locker (_opt_sync);
+                if (_started)
+                    break;
+                if (option_ == ZMQ_MSG_PIPE_GRANULARITY)
+                    _msg_pipe_granularity = value;
+                else if (option_ == ZMQ_CMD_PIPE_GRANULARITY)
+                    _cmd_pipe_granularity = value;
+                else
+                    _pipe_chunk_cache_size = static_cast<size_t> (value);
+                return 0;
+            }
+            break;
+
+        case ZMQ_CRYPTO_THREADS:
+#ifdef ZMQ_USE_CV_IMPL_NONE
+            if (is_int && value == 0)
+#else
+            if (is_int && value >= 0)
+#endif
+            {
+                scoped_lock_t locker (_opt_sync);
+                if (_started)
+                    break;
+                _crypto_thread_count = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_DNS_CACHE_TTL:
+        case ZMQ_DNS_CACHE_NEGATIVE_TTL:
+#ifdef ZMQ_USE_CV_IMPL_NONE
+            if (is_int && value == 0)
+#else
+            if (is_int && value >= 0)
+#endif
+            {
+                scoped_lock_t locker (_opt_sync);
+                if (_started)
+                    break;
+                if (option_ == ZMQ_DNS_CACHE_TTL)
+                    _dns_cache_ttl = value;
+                else
+                    _dns_cache_negative_ttl = value;
+                return 0;
+            }
+            break;
+
         default: {
             return thread_ctx_t::set (option_, optval_, optvallen_);
         }
@@ -362,6 +469,79 @@ int zmq::ctx_t::get (int option_, void *optval_, const size_t *optvallen_)
             }
             break;
 
+        case ZMQ_MAX_QUEUED_BYTES:
+            if (*optvallen_ == sizeof (uint64_t)) {
+                scoped_lock_t locker (_opt_sync);
+                *static_cast<uint64_t *> (optval_) = _max_queued_bytes;
+                return 0;
+            }
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _max_queued_bytes < INT_MAX
+                           ? static_cast<int> (_max_queued_bytes)
+                           : INT_MAX;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CRYPTO_THREADS:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _crypto_thread_count;
+                return 0;
+            }
+            break;
+
+        case ZMQ_DNS_CACHE_TTL:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _dns_cache_ttl;
+                return 0;
+            }
+            break;
+
+        case ZMQ_DNS_CACHE_NEGATIVE_TTL:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _dns_cache_negative_ttl;
+                return 0;
+            }
+            break;
+
+        case ZMQ_HUGEPAGES:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _hugepages;
+                return 0;
+            }
+            break;
+
+        case ZMQ_MSG_PIPE_GRANULARITY:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _msg_pipe_granularity;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CMD_PIPE_GRANULARITY:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _cmd_pipe_granularity;
+                return 0;
+            }
+            break;
+
+        case ZMQ_PIPE_CHUNK_CACHE:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _pipe_chunk_cache_size < INT_MAX
+                           ? static_cast<int> (_pipe_chunk_cache_size)
+                           : INT_MAX;
+                return 0;
+            }
+            break;
+
         default: {
             return thread_ctx_t::get (option_, optval_, optvallen_);
         }
@@ -371,6 +551,35 @@ int zmq::ctx_t::get (int option_, void *optval_, const size_t *optvallen_)
     return -1;
 }
 
+int zmq::ctx_t::set_allocator (zmq_alloc_fn *alloc_fn_,
+                               zmq_free_fn *free_fn_,
+                               void *hint_)
+{
+    if ((alloc_fn_ == NULL) != (free_fn_ == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    scoped_lock_t locker (_opt_sync);
+    _allocator.alloc_fn = alloc_fn_;
+    _allocator.free_fn = free_fn_;
+    _allocator.hint = hint_;
+    return 0;
+}
+
+zmq::allocator_t zmq::ctx_t::get_allocator ()
+{
+    scoped_lock_t locker (_opt_sync);
+    if (_hugepages && !_allocator.alloc_fn) {
+        allocator_t hugepages;
+        hugepages.alloc_fn = hugepage_pool_t::allocate;
+        hugepages.free_fn = hugepage_pool_t::deallocate;
+        hugepages.hint = NULL;
+        return hugepages;
+    }
+    return _allocator;
+}
+
 int zmq::ctx_t::get (int option_)
 {
     int optval = 0;
@@ -391,7 +600,42 @@ bool zmq::ctx_t::start ()
     const int term_and_reaper_threads_count = 2;
     const int mazmq = _max_sockets;
     const int ios = _io_thread_count;
+    _started = true;
+    const size_t chunk_size =
+      yqueue_t<msg_t, message_pipe_granularity>::chunk_size (
+        _msg_pipe_granularity);
+    _msg_chunk_cache = new (std::nothrow)
+      chunk_cache_t (chunk_size, _pipe_chunk_cache_size, _hugepages);
+    const int crypto_threads = _crypto_thread_count;
+    const int dns_cache_ttl = _dns_cache_ttl;
+    const int dns_cache_negative_ttl = _dns_cache_negative_ttl;
     _opt_sync.unlock ();
+    if (!_msg_chunk_cache) {
+        errno = ENOMEM;
+        return false;
+    }
+    if (crypto_threads > 0) {
+        _crypto_pool = new (std::nothrow) crypto_pool_t;
+        if (!_crypto_pool)
+            errno = ENOMEM;
+        if (!_crypto_pool || !_crypto_pool->start (*this, crypto_threads)) {
+            LIBZMQ_DELETE (_crypto_pool);
+            LIBZMQ_DELETE (_msg_chunk_cache);
+            return false;
+        }
+    }
+    if (dns_cache_ttl > 0) {
+        _dns_cache = new (std::nothrow)
+          dns_cache_t (this, dns_cache_ttl, dns_cache_negative_ttl);
+        if (!_dns_cache) {
+            errno = ENOMEM;
+            LIBZMQ_DELETE (_crypto_pool);
+            LIBZMQ_DELETE (_msg_chunk_cache);
+            return false;
+        }
+        _dns_cache->start (*this);
+    }
+
     const int slot_count = mazmq + ios + term_and_reaper_threads_count;
     try {
         _slots.reserve (slot_count);
@@ -452,6 +696,9 @@ fail_cleanup_reaper:
 
 fail_cleanup_slots:
     _slots.clear ();
+    LIBZMQ_DELETE (_msg_chunk_cache);
+    LIBZMQ_DELETE (_crypto_pool);
+    LIBZMQ_DELETE (_dns_cache);
     return false;
 }
 
@@ -774,6 +1021,33 @@ void zmq::ctx_t::connect_pending (const char *addr_,
     _pending_connections.erase (pending.first, pending.second);
 }
 
+uint64_t zmq::ctx_t::get_max_queued_bytes ()
+{
+    scoped_lock_t locker (_opt_sync);
+    return _max_queued_bytes;
+}
+
+void zmq::ctx_t::add_queued_bytes (int64_t delta_)
+{
+    scoped_lock_t locker (_queued_bytes_sync);
+
+    if (delta_ >= 0)
+        _queued_bytes += static_cast<uint64_t> (delta_);
+    else if (_queued_bytes > static_cast<uint64_t> (-delta_))
+        _queued_bytes -= static_cast<uint64_t> (-delta_);
+    else
+        _queued_bytes = 0;
+
+    update_queued_bytes_exceeded ();
+}
+
+void zmq::ctx_t::update_queued_bytes_exceeded ()
+{
+    const uint64_t max_queued_bytes = get_max_queued_bytes ();
+    _queued_bytes_exceeded.store (
+      max_queued_bytes > 0 && _queued_bytes >= max_queued_bytes ? 1 : 0);
+}
+
 void zmq::ctx_t::connect_inproc_sockets (
   zmq::socket_base_t *bind_socket_,
   const options_t &bind_options_,
@@ -803,6 +1077,23 @@ void zmq::ctx_t::connect_inproc_sockets (
           pending_connection_.endpoint.options.sndhwm);
         pending_connection_.bind_pipe->set_hwms (bind_options_.rcvhwm,
                                                  bind_options_.sndhwm);
+
+        //  As with the message limits, the byte limits of an inproc
+        //  connection are the sum of both sides, unless either is unlimited.
+        const options_t &connect_options =
+          pending_connection_.endpoint.options;
+        const uint64_t sndhwm_bytes =
+          connect_options.sndhwm_bytes != 0 && bind_options_.rcvhwm_bytes != 0
+            ? connect_options.sndhwm_bytes + bind_options_.rcvhwm_bytes
+            : 0;
+        const uint64_t rcvhwm_bytes =
+          connect_options.rcvhwm_bytes != 0 && bind_options_.sndhwm_bytes != 0
+            ? connect_options.rcvhwm_bytes + bind_options_.sndhwm_bytes
+            : 0;
+        pending_connection_.connect_pipe->set_hwms_bytes (rcvhwm_bytes,
+                                                          sndhwm_bytes);
+        pending_connection_.bind_pipe->set_hwms_bytes (sndhwm_bytes,
+                                                       rcvhwm_bytes);
     } else {
         pending_connection_.connect_pipe->set_hwms (-1, -1);
         pending_connection_.bind_pipe->set_hwms (-1, -1);
@@ -15,6 +15,8 @@
 #include "stdint.hpp"
 #include "options.hpp"
 #include "atomic_counter.hpp"
+#include "atomic_ptr.hpp"
+#include "allocator.hpp"
 #include "thread.hpp"
 
 namespace zmq
@@ -24,6 +26,9 @@ class io_thread_t;
 class socket_base_t;
 class reaper_t;
 class pipe_t;
+class chunk_cache_t;
+class crypto_pool_t;
+class dns_cache_t;
 
 //  Information associated with inproc endpoint. Note that endpoint options
 //  are registered as well so that the peer can access them without a need
@@ -92,6 +97,26 @@ class ctx_t ZMQ_FINAL : public thread_ctx_t
     int get (int option_, void *optval_, const size_t *optvallen_);
     int get (int option_);
 
+    //  Set and get the memory allocation hooks. Either both functions are
+    //  given, or none to go back to malloc and free.
+    int set_allocator (zmq_alloc_fn *alloc_fn_,
+                       zmq_free_fn *free_fn_,
+                       void *hint_);
+    allocator_t get_allocator ();
+
+    //  Settings of the pipes, fixed once the first socket was created.
+    int msg_pipe_granularity () const { return _msg_pipe_granularity; }
+    int cmd_pipe_granularity () const { return _cmd_pipe_granularity; }
+    chunk_cache_t *msg_chunk_cache () const { return _msg_chunk_cache; }
+
+    //  Threads to run handshake crypto on, NULL if it runs in the io
+    //  threads.
+    crypto_pool_t *get_crypto_pool () const { return _crypto_pool; }
+
+    //  Looks up the addresses of the TCP connecters, NULL if they resolve
+    //  them in the io threads.
+    dns_cache_t *get_dns_cache () const { return _dns_cache; }
+
     //  Create and destroy a socket.
     zmq::socket_base_t *create_socket (int type_);
     void destroy_socket (zmq::socket_base_t *socket_);
@@ -118,6 +143,19 @@ class ctx_t ZMQ_FINAL : public thread_ctx_t
                           pipe_t **pipes_);
     void connect_pending (const char *addr_, zmq::socket_base_t *bind_socket_);
 
+    //  Context-wide budget for the bytes queued in pipes. Returns 0 if
+    //  the queued bytes are not limited.
+    uint64_t get_max_queued_bytes ();
+
+    //  Adds delta_ to the number of bytes queued in pipes.
+    void add_queued_bytes (int64_t delta_);
+
+    //  Returns true if the queued bytes reached the budget.
+    bool queued_bytes_exceeded () const
+    {
+        return _queued_bytes_exceeded.load () != 0;
+    }
+
 #ifdef ZMQ_HAVE_VMCI
     // Return family for the VMCI socket or -1 if it's not available.
     int get_vmci_socket_family ();
@@ -215,6 +253,53 @@ class ctx_t ZMQ_FINAL : public thread_ctx_t
     // Should we use zero copy message decoding in this context?
     bool _zero_copy;
 
+    //  Memory allocation hooks handed to new sockets.
+    allocator_t _allocator;
+
+    //  Should pipes, codec buffers and messages use the hugepage pool?
+    bool _hugepages;
+
+    //  Number of elements per chunk of message and command pipes.
+    int _msg_pipe_granularity;
+    int _cmd_pipe_granularity;
+
+    //  Bytes of free message pipe chunks kept for reuse.
+    size_t _pipe_chunk_cache_size;
+
+    //  Chunks of all message pipes, created with the first socket.
+    chunk_cache_t *_msg_chunk_cache;
+
+    //  Set under _opt_sync when the first socket starts the context. From
+    //  then on the options read by start () can't be changed.
+    bool _started;
+
+    //  Number of crypto pool threads, and the pool started with the
+    //  first socket if there are any.
+    int _crypto_thread_count;
+    crypto_pool_t *_crypto_pool;
+
+    //  How long to keep successful and failed lookups, and the cache
+    //  started with the first socket if the former is set.
+    int _dns_cache_ttl;
+    int _dns_cache_negative_ttl;
+    dns_cache_t *_dns_cache;
+
+    //  Maximum number of bytes queued in all pipes of the context,
+    //  0 if not limited.
+    uint64_t _max_queued_bytes;
+
+    //  Number of bytes currently queued, as reported by the pipes.
+    uint64_t _queued_bytes;
+    mutex_t _queued_bytes_sync;
+
+    //  Set while _queued_bytes is at or above _max_queued_bytes, so that
+    //  sockets can check the budget without taking the lock.
+    atomic_value_t _queued_bytes_exceeded;
+
+    //  Compares the queued bytes with the budget again. Must be called
+    //  with _queued_bytes_sync held.
+    void update_queued_bytes_exceeded ();
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (ctx_t)
 
 #ifdef HAVE_FORK
@@ -23,14 +23,29 @@ zmq::curve_client_t::curve_client_t (session_base_t *session_,
                             "CurveZMQMESSAGES",
                             downgrade_sub_),
     _state (send_hello),
+    _aes256gcm (false),
     _tools (options_.curve_public_key,
             options_.curve_secret_key,
             options_.curve_server_key)
 {
+    memset (_ticket, 0, sizeof _ticket);
+
+    //  Resume the session of the previous connection if it left a ticket.
+    //  A ticket is tried once: should the server turn it down, the next
+    //  connection does the full handshake.
+    blob_t &ticket = session_->curve_ticket ();
+    if (options_.curve_ticket_lifetime > 0 && ticket.size () == sizeof _ticket) {
+        memcpy (_ticket, ticket.data (), sizeof _ticket);
+        _state = send_resume;
+    }
+    if (ticket.size ())
+        sodium_memzero (ticket.data (), ticket.size ());
+    ticket.clear ();
 }
 
 zmq::curve_client_t::~curve_client_t ()
 {
+    sodium_memzero (_ticket, sizeof _ticket);
 }
 
 int zmq::curve_client_t::next_handshake_command (msg_t *msg_)
@@ -48,6 +63,11 @@ int zmq::curve_client_t::next_handshake_command (msg_t *msg_)
             if (rc == 0)
                 _state = expect_ready;
             break;
+        case send_resume:
+            rc = produce_resume (msg_);
+            if (rc == 0)
+                _state = expect_resumed;
+            break;
         default:
             errno = EAGAIN;
             rc = -1;
@@ -67,6 +87,9 @@ int zmq::curve_client_t::process_handshake_command (msg_t *msg_)
     else if (curve_client_tools_t::is_handshake_command_ready (msg_data,
                                                                msg_size))
         rc = process_ready (msg_data, msg_size);
+    else if (curve_client_tools_t::is_handshake_command_resumed (msg_data,
+                                                                 msg_size))
+        rc = process_resumed (msg_data, msg_size);
     else if (curve_client_tools_t::is_handshake_command_error (msg_data,
                                                                msg_size))
         rc = process_error (msg_data, msg_size);
@@ -151,11 +174,15 @@ int zmq::curve_client_t::process_welcome (const uint8_t *msg_data_,
 
 int zmq::curve_client_t::produce_initiate (msg_t *msg_)
 {
-    const size_t metadata_length = basic_properties_len ();
+    const size_t metadata_length =
+      basic_properties_len () + curve_properties_len ();
     std::vector<unsigned char, secure_allocator_t<unsigned char> >
       metadata_plaintext (metadata_length);
 
-    add_basic_properties (&metadata_plaintext[0], metadata_length);
+    unsigned char *ptr = &metadata_plaintext[0];
+    ptr += add_basic_properties (ptr, metadata_length);
+    add_curve_properties (ptr,
+                          metadata_length - (ptr - &metadata_plaintext[0]));
 
     const size_t msg_size =
       113 + 128 + crypto_box_BOXZEROBYTES + metadata_length;
@@ -179,7 +206,81 @@ int zmq::curve_client_t::produce_initiate (msg_t *msg_)
 int zmq::curve_client_t::process_ready (const uint8_t *msg_data_,
                                         size_t msg_size_)
 {
-    if (msg_size_ < 30) {
+    return open_ready (msg_data_, msg_size_, 14, "CurveZMQREADY---");
+}
+
+int zmq::curve_client_t::produce_resume (msg_t *msg_)
+{
+    const uint8_t *const secret = _ticket;
+    const uint8_t *const ticket = _ticket + curve_ticket_secret_size;
+
+    const size_t metadata_length =
+      basic_properties_len () + curve_properties_len ();
+    std::vector<uint8_t, secure_allocator_t<uint8_t> > resume_plaintext (
+      crypto_secretbox_ZEROBYTES + 32 + metadata_length);
+
+    //  Create Box [C' + metadata](R)
+    memcpy (&resume_plaintext[crypto_secretbox_ZEROBYTES], _tools.cn_public,
+            32);
+    uint8_t *ptr = &resume_plaintext[crypto_secretbox_ZEROBYTES + 32];
+    ptr += add_basic_properties (ptr, metadata_length);
+    add_curve_properties (ptr, metadata_length - basic_properties_len ());
+
+    uint8_t resume_nonce[crypto_secretbox_NONCEBYTES];
+    memcpy (resume_nonce, "CurveZMQRESUME--", 16);
+    put_uint64 (resume_nonce + 16, get_and_inc_nonce ());
+
+    std::vector<uint8_t> resume_box (resume_plaintext.size ());
+    int rc = crypto_secretbox (&resume_box[0], &resume_plaintext[0],
+                               resume_plaintext.size (), resume_nonce, secret);
+    zmq_assert (rc == 0);
+
+    const size_t box_size = resume_box.size () - crypto_secretbox_BOXZEROBYTES;
+    rc = msg_->init_size (161 + box_size);
+    errno_assert (rc == 0);
+
+    uint8_t *resume = static_cast<uint8_t *> (msg_->data ());
+
+    memcpy (resume, "\x06RESUME", 7);
+    //  CurveZMQ major and minor version numbers
+    memcpy (resume + 7, "\1\0", 2);
+    //  Client short-term public key (C')
+    memcpy (resume + 9, _tools.cn_public, 32);
+    //  Ticket as issued by the server
+    memcpy (resume + 41, ticket, curve_ticket_size);
+    //  Short nonce, prefixed by "CurveZMQRESUME--"
+    memcpy (resume + 153, resume_nonce + 16, 8);
+    //  Box [C' + metadata](R)
+    memcpy (resume + 161, &resume_box[crypto_secretbox_BOXZEROBYTES],
+            box_size);
+
+    return 0;
+}
+
+int zmq::curve_client_t::process_resumed (const uint8_t *msg_data_,
+                                          size_t msg_size_)
+{
+    if (_state != expect_resumed || msg_size_ < 64) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (),
+          ZMQ_PROTOCOL_ERROR_ZMTP_MALFORMED_COMMAND_UNSPECIFIED);
+        errno = EPROTO;
+        return -1;
+    }
+
+    //  The session key mixes the server's new short-term key (S') in.
+    precompute_resumed (msg_data_ + 8, _tools.cn_secret, _ticket);
+    sodium_memzero (_ticket, sizeof _ticket);
+
+    return open_ready (msg_data_, msg_size_, 48, "CurveZMQRESUMED-");
+}
+
+int zmq::curve_client_t::open_ready (const uint8_t *msg_data_,
+                                     size_t msg_size_,
+                                     size_t header_size_,
+                                     const char *nonce_prefix_)
+{
+    if (msg_size_ < header_size_ + 16) {
         session->get_socket ()->event_handshake_failed_protocol (
           session->get_endpoint (),
           ZMQ_PROTOCOL_ERROR_ZMTP_MALFORMED_COMMAND_READY);
@@ -187,7 +288,8 @@ int zmq::curve_client_t::process_ready (const uint8_t *msg_data_,
         return -1;
     }
 
-    const size_t clen = (msg_size_ - 14) + crypto_box_BOXZEROBYTES;
+    const size_t clen = (msg_size_ - header_size_) + crypto_box_BOXZEROBYTES;
+    const uint8_t *const short_nonce = msg_data_ + header_size_ - 8;
 
     uint8_t ready_nonce[crypto_box_NONCEBYTES];
     std::vector<uint8_t, secure_allocator_t<uint8_t> > ready_plaintext (
@@ -196,12 +298,12 @@ int zmq::curve_client_t::process_ready (const uint8_t *msg_data_,
 
     std::fill (ready_box.begin (), ready_box.begin () + crypto_box_BOXZEROBYTES,
                0);
-    memcpy (&ready_box[crypto_box_BOXZEROBYTES], msg_data_ + 14,
+    memcpy (&ready_box[crypto_box_BOXZEROBYTES], msg_data_ + header_size_,
             clen - crypto_box_BOXZEROBYTES);
 
-    memcpy (ready_nonce, "CurveZMQREADY---", 16);
-    memcpy (ready_nonce + 16, msg_data_ + 6, 8);
-    set_peer_nonce (get_uint64 (msg_data_ + 6));
+    memcpy (ready_nonce, nonce_prefix_, 16);
+    memcpy (ready_nonce + 16, short_nonce, 8);
+    set_peer_nonce (get_uint64 (short_nonce));
 
     int rc = crypto_box_open_afternm (&ready_plaintext[0], &ready_box[0], clen,
                                       ready_nonce, get_precom_buffer ());
@@ -216,9 +318,13 @@ int zmq::curve_client_t::process_ready (const uint8_t *msg_data_,
     rc = parse_metadata (&ready_plaintext[crypto_box_ZEROBYTES],
                          clen - crypto_box_ZEROBYTES);
 
-    if (rc == 0)
+    if (rc == 0) {
+        //  Messages are sealed with the cipher the server agreed to from
+        //  here on.
+        if (_aes256gcm)
+            use_aes256gcm ();
         _state = connected;
-    else {
+    } else {
         session->get_socket ()->event_handshake_failed_protocol (
           session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_INVALID_METADATA);
         errno = EPROTO;
@@ -227,10 +333,70 @@ int zmq::curve_client_t::process_ready (const uint8_t *msg_data_,
     return rc;
 }
 
+int zmq::curve_client_t::property (const std::string &name_,
+                                   const void *value_,
+                                   size_t length_)
+{
+    if (name_ == ZMTP_PROPERTY_CURVE_CIPHER) {
+        //  The server agrees to the cipher we offered.
+        _aes256gcm = offers_aes256gcm ()
+                     && length_ == strlen (ZMTP_CURVE_CIPHER_AES256GCM)
+                     && memcmp (value_, ZMTP_CURVE_CIPHER_AES256GCM, length_)
+                          == 0;
+        return 1;
+    }
+    if (name_ != ZMTP_PROPERTY_CURVE_TICKET)
+        return 0;
+
+    //  Keep the ticket for the next connection of the session.
+    if (options.curve_ticket_lifetime > 0
+        && length_ == curve_ticket_secret_size + curve_ticket_size)
+        session->curve_ticket ().set (
+          static_cast<const unsigned char *> (value_), length_);
+    return 1;
+}
+
+bool zmq::curve_client_t::offers_aes256gcm () const
+{
+    return options.curve_cipher == ZMQ_CURVE_CIPHER_AES256GCM
+           && aes256gcm_available ();
+}
+
+size_t zmq::curve_client_t::curve_properties_len () const
+{
+    size_t len = 0;
+    if (options.curve_ticket_lifetime > 0)
+        len += property_len (ZMTP_PROPERTY_CURVE_TICKET, 0);
+    if (offers_aes256gcm ())
+        len += property_len (ZMTP_PROPERTY_CURVE_CIPHER,
+                             strlen (ZMTP_CURVE_CIPHER_AES256GCM));
+    return len;
+}
+
+size_t zmq::curve_client_t::add_curve_properties (unsigned char *ptr_,
+                                                  size_t ptr_capacity_) const
+{
+    unsigned char *ptr = ptr_;
+
+    //  Ask for a ticket
+    if (options.curve_ticket_lifetime > 0)
+        ptr += add_property (ptr, ptr_capacity_, ZMTP_PROPERTY_CURVE_TICKET,
+                             "", 0);
+
+    //  Offer the faster cipher
+    if (offers_aes256gcm ())
+        ptr += add_property (ptr, ptr_capacity_ - (ptr - ptr_),
+                             ZMTP_PROPERTY_CURVE_CIPHER,
+                             ZMTP_CURVE_CIPHER_AES256GCM,
+                             strlen (ZMTP_CURVE_CIPHER_AES256GCM));
+    return ptr - ptr_;
+}
+
 int zmq::curve_client_t::process_error (const uint8_t *msg_data_,
                                         size_t msg_size_)
 {
-    if (_state != expect_welcome && _state != expect_ready) {
+    if (_state != expect_welcome && _state != expect_ready
+        && _state != expect_resumed) {
         session->get_socket ()->event_handshake_failed_protocol (
           session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_UNEXPECTED_COMMAND);
         errno = EPROTO;
@@ -29,6 +29,11 @@ class curve_client_t ZMQ_FINAL : public curve_mechanism_base_t
     int decode (msg_t *msg_) ZMQ_FINAL;
     status_t status () const ZMQ_FINAL;
 
+  protected:
+    int property (const std::string &name_,
+                  const void *value_,
+                  size_t length_) ZMQ_FINAL;
+
   private:
     enum state_t
     {
@@ -36,6 +41,8 @@ class curve_client_t ZMQ_FINAL : public curve_mechanism_base_t
         expect_welcome,
         send_initiate,
         expect_ready,
+        send_resume,
+        expect_resumed,
         error_received,
         connected
     };
@@ -43,13 +50,29 @@ class curve_client_t ZMQ_FINAL : public curve_mechanism_base_t
     //  Current FSM state
     state_t _state;
 
+    //  True if the server agreed to seal messages with AES-256-GCM.
+    bool _aes256gcm;
+
     //  CURVE protocol tools
     curve_client_tools_t _tools;
 
+    //  Secret R and ticket to resume a session with, from the session.
+    uint8_t _ticket[curve_ticket_secret_size + curve_ticket_size];
+
     int produce_hello (msg_t *msg_);
     int process_welcome (const uint8_t *msg_data_, size_t msg_size_);
     int produce_initiate (msg_t *msg_);
     int process_ready (const uint8_t *msg_data_, size_t msg_size_);
+    int produce_resume (msg_t *msg_);
+    int process_resumed (const uint8_t *msg_data_, size_t msg_size_);
+    int open_ready (const uint8_t *msg_data_,
+                    size_t msg_size_,
+                    size_t header_size_,
+                    const char *nonce_prefix_);
+    bool offers_aes256gcm () const;
+    size_t curve_properties_len () const;
+    size_t add_curve_properties (unsigned char *ptr_,
+                                 size_t ptr_capacity_) const;
     int process_error (const uint8_t *msg_data_, size_t msg_size_);
 };
 }
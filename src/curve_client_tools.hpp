@@ -216,6 +216,12 @@ struct curve_client_tools_t
         return is_handshake_command (msg_data_, msg_size_, "\5ERROR");
     }
 
+    static bool is_handshake_command_resumed (const uint8_t *msg_data_,
+                                              const size_t msg_size_)
+    {
+        return is_handshake_command (msg_data_, msg_size_, "\7RESUMED");
+    }
+
     //  non-static functions
     curve_client_tools_t (
       const uint8_t (&curve_public_key_)[crypto_box_PUBLICKEYBYTES],
@@ -35,6 +35,21 @@ int zmq::curve_mechanism_base_t::encode (msg_t *msg_)
     return curve_encoding_t::encode (msg_);
 }
 
+void zmq::curve_mechanism_base_t::precompute_resumed (
+  const uint8_t *public_key_,
+  const uint8_t *secret_key_,
+  const uint8_t *ticket_secret_)
+{
+    uint8_t shared[crypto_box_BEFORENMBYTES];
+    int rc = crypto_box_beforenm (shared, public_key_, secret_key_);
+    zmq_assert (rc == 0);
+    rc = crypto_generichash (get_writable_precom_buffer (),
+                             crypto_box_BEFORENMBYTES, shared, sizeof shared,
+                             ticket_secret_, curve_ticket_secret_size);
+    zmq_assert (rc == 0);
+    sodium_memzero (shared, sizeof shared);
+}
+
 int zmq::curve_mechanism_base_t::decode (msg_t *msg_)
 {
     int rc = check_basic_command_structure (msg_);
@@ -58,10 +73,56 @@ zmq::curve_encoding_t::curve_encoding_t (const char *encode_nonce_prefix_,
     _decode_nonce_prefix (decode_nonce_prefix_),
     _cn_nonce (1),
     _cn_peer_nonce (1),
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+    _aes256gcm_state (NULL),
+#endif
     _downgrade_sub (downgrade_sub_)
 {
 }
 
+zmq::curve_encoding_t::~curve_encoding_t ()
+{
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+    if (_aes256gcm_state) {
+        sodium_memzero (_aes256gcm_state, sizeof *_aes256gcm_state);
+        LIBZMQ_DELETE (_aes256gcm_state);
+    }
+#endif
+}
+
+bool zmq::curve_encoding_t::aes256gcm_available ()
+{
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+    return crypto_aead_aes256gcm_is_available () == 1;
+#else
+    return false;
+#endif
+}
+
+void zmq::curve_encoding_t::use_aes256gcm ()
+{
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+    zmq_assert (!_aes256gcm_state);
+
+    //  The box key itself is not reused for another cipher.
+    static const char label[] = "CurveZMQAES256GCM";
+    uint8_t key[crypto_aead_aes256gcm_KEYBYTES];
+    int rc = crypto_generichash (key, sizeof key,
+                                 reinterpret_cast<const uint8_t *> (label),
+                                 sizeof label - 1, _cn_precom,
+                                 sizeof _cn_precom);
+    zmq_assert (rc == 0);
+
+    _aes256gcm_state = new (std::nothrow) crypto_aead_aes256gcm_state;
+    alloc_assert (_aes256gcm_state);
+    rc = crypto_aead_aes256gcm_beforenm (_aes256gcm_state, key);
+    zmq_assert (rc == 0);
+    sodium_memzero (key, sizeof key);
+#else
+    zmq_assert (false);
+#endif
+}
+
 //  Right now, we only transport the lower two bit flags of zmq::msg_t, so they
 //  are binary identical, and we can just use a bitmask to select them. If we
 //  happened to add more flags, this might change.
@@ -73,6 +134,13 @@ static const size_t message_command_len = sizeof (message_command) - 1;
 static const size_t message_header_len =
   message_command_len + sizeof (zmq::curve_encoding_t::nonce_t);
 
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+//  AES-256-GCM takes the last bytes of the nonce, that is the end of the
+//  prefix, which differs between the directions, and the counter.
+static const size_t aes256gcm_nonce_offset =
+  crypto_box_NONCEBYTES - crypto_aead_aes256gcm_NPUBBYTES;
+#endif
+
 #ifndef ZMQ_USE_LIBSODIUM
 static const size_t crypto_box_MACBYTES = 16;
 #endif
@@ -124,20 +192,18 @@ int zmq::curve_encoding_t::encode (msg_t *msg_)
                                : zmq::msg_t::sub_cmd_name_size;
     }
 
-#ifdef ZMQ_HAVE_CRYPTO_BOX_EASY_FNS
+    //  The plaintext is written to the new message where its ciphertext
+    //  goes, behind the command header and the MAC, and encrypted in
+    //  place.
     const size_t mlen = flags_len + sub_cancel_len + msg_->size ();
-    std::vector<uint8_t> message_plaintext (mlen);
-#else
-    const size_t mlen =
-      crypto_box_ZEROBYTES + flags_len + sub_cancel_len + msg_->size ();
-    std::vector<uint8_t> message_plaintext_with_zerobytes (mlen);
-    uint8_t *const message_plaintext =
-      &message_plaintext_with_zerobytes[crypto_box_ZEROBYTES];
+    msg_t msg_box;
+    int rc =
+      msg_box.init_size (message_header_len + crypto_box_MACBYTES + mlen);
+    zmq_assert (rc == 0);
 
-    std::fill (message_plaintext_with_zerobytes.begin (),
-               message_plaintext_with_zerobytes.begin () + crypto_box_ZEROBYTES,
-               0);
-#endif
+    uint8_t *const message = static_cast<uint8_t *> (msg_box.data ());
+    uint8_t *const message_plaintext =
+      message + message_header_len + crypto_box_MACBYTES;
 
     const uint8_t flags = msg_->flags () & flag_mask;
     message_plaintext[0] = flags;
@@ -157,50 +223,41 @@ int zmq::curve_encoding_t::encode (msg_t *msg_)
                 zmq::msg_t::cancel_cmd_name_size);
     }
 
-    // this is copying the data from insecure memory, so there is no point in
-    // using secure_allocator_t for message_plaintext
     if (msg_->size () > 0)
         memcpy (&message_plaintext[flags_len + sub_cancel_len], msg_->data (),
                 msg_->size ());
 
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+    if (_aes256gcm_state) {
+        rc = crypto_aead_aes256gcm_encrypt_detached_afternm (
+          message_plaintext, message + message_header_len, NULL,
+          message_plaintext, mlen, NULL, 0, NULL,
+          message_nonce + aes256gcm_nonce_offset, _aes256gcm_state);
+    } else
+#endif
+    {
 #ifdef ZMQ_HAVE_CRYPTO_BOX_EASY_FNS
-    msg_t msg_box;
-    int rc =
-      msg_box.init_size (message_header_len + mlen + crypto_box_MACBYTES);
-    zmq_assert (rc == 0);
-
-    rc = crypto_box_easy_afternm (
-      static_cast<uint8_t *> (msg_box.data ()) + message_header_len,
-      &message_plaintext[0], mlen, message_nonce, _cn_precom);
-    zmq_assert (rc == 0);
-
-    msg_->move (msg_box);
-
-    uint8_t *const message = static_cast<uint8_t *> (msg_->data ());
+        rc = crypto_box_easy_afternm (message + message_header_len,
+                                      message_plaintext, mlen, message_nonce,
+                                      _cn_precom);
 #else
-    std::vector<uint8_t> message_box (mlen);
-
-    int rc =
-      crypto_box_afternm (&message_box[0], &message_plaintext_with_zerobytes[0],
-                          mlen, message_nonce, _cn_precom);
-    zmq_assert (rc == 0);
-
-    rc = msg_->close ();
-    zmq_assert (rc == 0);
-
-    rc = msg_->init_size (16 + mlen - crypto_box_BOXZEROBYTES);
-    zmq_assert (rc == 0);
-
-    uint8_t *const message = static_cast<uint8_t *> (msg_->data ());
-
-    memcpy (message + message_header_len, &message_box[crypto_box_BOXZEROBYTES],
-            mlen - crypto_box_BOXZEROBYTES);
+        //  The zero bytes the NaCl API wants ahead of the plaintext take
+        //  the place of the header and the MAC, which then start the box.
+        memset (message, 0, crypto_box_ZEROBYTES);
+        rc = crypto_box_afternm (message, message,
+                                 crypto_box_ZEROBYTES + mlen, message_nonce,
+                                 _cn_precom);
 #endif
+    }
+    zmq_assert (rc == 0);
 
     memcpy (message, message_command, message_command_len);
     memcpy (message + message_command_len, message_nonce + nonce_prefix_len,
             sizeof (nonce_t));
 
+    //  Small messages are stored in the msg_t itself, so this comes last.
+    msg_->move (msg_box);
+
     return 0;
 }
 
@@ -218,38 +275,37 @@ int zmq::curve_encoding_t::decode (msg_t *msg_, int *error_event_code_)
     memcpy (message_nonce + nonce_prefix_len, message + message_command_len,
             sizeof (nonce_t));
 
-#ifdef ZMQ_HAVE_CRYPTO_BOX_EASY_FNS
+    //  Decrypted in place, the plaintext ends up behind the MAC.
     const size_t clen = msg_->size () - message_header_len;
-
-    uint8_t *const message_plaintext = message + message_header_len;
-
-    rc = crypto_box_open_easy_afternm (message_plaintext,
-                                       message + message_header_len, clen,
-                                       message_nonce, _cn_precom);
-#else
-    const size_t clen =
-      crypto_box_BOXZEROBYTES + msg_->size () - message_header_len;
-
-    std::vector<uint8_t> message_plaintext_with_zerobytes (clen);
-    std::vector<uint8_t> message_box (clen);
-
-    std::fill (message_box.begin (),
-               message_box.begin () + crypto_box_BOXZEROBYTES, 0);
-    memcpy (&message_box[crypto_box_BOXZEROBYTES], message + message_header_len,
-            msg_->size () - message_header_len);
-
-    rc = crypto_box_open_afternm (&message_plaintext_with_zerobytes[0],
-                                  &message_box[0], clen, message_nonce,
-                                  _cn_precom);
-
     const uint8_t *const message_plaintext =
-      &message_plaintext_with_zerobytes[crypto_box_ZEROBYTES];
+      message + message_header_len + crypto_box_MACBYTES;
+
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+    if (_aes256gcm_state) {
+        rc = crypto_aead_aes256gcm_decrypt_detached_afternm (
+          message + message_header_len + crypto_box_MACBYTES, NULL,
+          message_plaintext, clen - crypto_box_MACBYTES,
+          message + message_header_len, NULL, 0,
+          message_nonce + aes256gcm_nonce_offset, _aes256gcm_state);
+    } else
+#endif
+    {
+#ifdef ZMQ_HAVE_CRYPTO_BOX_EASY_FNS
+        rc = crypto_box_open_easy_afternm (
+          message + message_header_len + crypto_box_MACBYTES,
+          message + message_header_len, clen, message_nonce, _cn_precom);
+#else
+        //  The NaCl API wants zero bytes ahead of the MAC, where the header
+        //  was.
+        memset (message, 0, crypto_box_BOXZEROBYTES);
+        rc = crypto_box_open_afternm (message, message,
+                                      crypto_box_BOXZEROBYTES + clen,
+                                      message_nonce, _cn_precom);
 #endif
+    }
 
     if (rc == 0) {
         const uint8_t flags = message_plaintext[0];
-
-#ifdef ZMQ_HAVE_CRYPTO_BOX_EASY_FNS
         const size_t plaintext_size = clen - flags_len - crypto_box_MACBYTES;
 
         if (plaintext_size > 0) {
@@ -258,21 +314,6 @@ int zmq::curve_encoding_t::decode (msg_t *msg_, int *error_event_code_)
         }
 
         msg_->shrink (plaintext_size);
-#else
-        rc = msg_->close ();
-        zmq_assert (rc == 0);
-
-        rc = msg_->init_size (clen - flags_len - crypto_box_ZEROBYTES);
-        zmq_assert (rc == 0);
-
-        // this is copying the data to insecure memory, so there is no point in
-        // using secure_allocator_t for message_plaintext
-        if (msg_->size () > 0) {
-            memcpy (msg_->data (), &message_plaintext[flags_len],
-                    msg_->size ());
-        }
-#endif
-
         msg_->set_flags (flags & flag_mask);
     } else {
         // CURVE I : connection key used for MESSAGE is wrong
@@ -16,6 +16,10 @@
 #error "CURVE library not built properly"
 #endif
 
+#if defined(ZMQ_USE_LIBSODIUM) && defined(crypto_aead_aes256gcm_KEYBYTES)
+#define ZMQ_HAVE_CURVE_AES256GCM 1
+#endif
+
 #include "mechanism_base.hpp"
 #include "options.hpp"
 
@@ -23,12 +27,29 @@
 
 namespace zmq
 {
+//  Session resumption. A server hands a client that asks for it a secret
+//  R along with a ticket, nonce and Box [C + R + expiry](T), sealed with
+//  a key T only the server knows. Both travel in the Curve-Ticket
+//  property of READY or RESUMED.
+#define ZMTP_PROPERTY_CURVE_TICKET "Curve-Ticket"
+const size_t curve_ticket_secret_size = 32;
+const size_t curve_ticket_size = crypto_secretbox_NONCEBYTES
+                                 + crypto_secretbox_MACBYTES + 32
+                                 + curve_ticket_secret_size + 8;
+
+//  Cipher negotiation. A client that would rather have its messages sealed
+//  with AES-256-GCM offers it in the Curve-Cipher property of INITIATE or
+//  RESUME, and a server that agrees echoes it in READY or RESUMED.
+#define ZMTP_PROPERTY_CURVE_CIPHER "Curve-Cipher"
+#define ZMTP_CURVE_CIPHER_AES256GCM "AES-256-GCM"
+
 class curve_encoding_t
 {
   public:
     curve_encoding_t (const char *encode_nonce_prefix_,
                       const char *decode_nonce_prefix_,
                       const bool downgrade_sub_);
+    ~curve_encoding_t ();
 
     int encode (msg_t *msg_);
     int decode (msg_t *msg_, int *error_event_code_);
@@ -41,6 +62,14 @@ class curve_encoding_t
     nonce_t get_and_inc_nonce () { return _cn_nonce++; }
     void set_peer_nonce (nonce_t peer_nonce_) { _cn_peer_nonce = peer_nonce_; };
 
+    //  True if the library has AES-256-GCM and the CPU runs it in
+    //  hardware.
+    static bool aes256gcm_available ();
+
+    //  Seals the messages from now on with AES-256-GCM, under a key
+    //  derived from the precomputed one.
+    void use_aes256gcm ();
+
   private:
     int check_validity (msg_t *msg_, int *error_event_code_);
 
@@ -53,6 +82,11 @@ class curve_encoding_t
     //  Intermediary buffer used to speed up boxing and unboxing.
     uint8_t _cn_precom[crypto_box_BEFORENMBYTES];
 
+#ifdef ZMQ_HAVE_CURVE_AES256GCM
+    //  Expanded AES-256-GCM key, once the cipher is in use.
+    crypto_aead_aes256gcm_state *_aes256gcm_state;
+#endif
+
     const bool _downgrade_sub;
 
     ZMQ_NON_COPYABLE_NOR_MOVABLE (curve_encoding_t)
@@ -71,6 +105,13 @@ class curve_mechanism_base_t : public virtual mechanism_base_t,
     // mechanism implementation
     int encode (msg_t *msg_) ZMQ_OVERRIDE;
     int decode (msg_t *msg_) ZMQ_OVERRIDE;
+
+  protected:
+    //  Precomputes the key of a resumed session, which depends on both
+    //  sides' short-term keys and on the ticket's secret.
+    void precompute_resumed (const uint8_t *public_key_,
+                             const uint8_t *secret_key_,
+                             const uint8_t *ticket_secret_);
 };
 }
 
@@ -10,12 +10,14 @@
 #include "err.hpp"
 #include "curve_server.hpp"
 #include "wire.hpp"
+#include "clock.hpp"
 #include "secure_allocator.hpp"
 
 zmq::curve_server_t::curve_server_t (session_base_t *session_,
                                      const std::string &peer_address_,
                                      const options_t &options_,
-                                     const bool downgrade_sub_) :
+                                     const bool downgrade_sub_,
+                                     crypto_notifier_t *crypto_notifier_) :
     mechanism_base_t (session_, options_),
     zap_client_common_handshake_t (
       session_, peer_address_, options_, sending_ready),
@@ -23,21 +25,28 @@ zmq::curve_server_t::curve_server_t (session_base_t *session_,
                             options_,
                             "CurveZMQMESSAGES",
                             "CurveZMQMESSAGEC",
-                            downgrade_sub_)
+                            downgrade_sub_),
+    _crypto_notifier (crypto_notifier_),
+    _crypto_step (hello_step),
+    _crypto_pending (false),
+    _crypto_error (0),
+    _resumed (false),
+    _ticket_requested (false),
+    _aes256gcm (false)
 {
-    int rc;
     //  Fetch our secret key from socket options
     memcpy (_secret_key, options_.curve_secret_key, crypto_box_SECRETKEYBYTES);
 
-    //  Generate short-term key pair
+    //  The short-term key pair is generated along with WELCOME.
     memset (_cn_secret, 0, crypto_box_SECRETKEYBYTES);
     memset (_cn_public, 0, crypto_box_PUBLICKEYBYTES);
-    rc = crypto_box_keypair (_cn_public, _cn_secret);
-    zmq_assert (rc == 0);
+    memset (_client_key, 0, crypto_box_PUBLICKEYBYTES);
 }
 
 zmq::curve_server_t::~curve_server_t ()
 {
+    if (_crypto_pending)
+        _crypto_notifier->cancel (this);
 }
 
 int zmq::curve_server_t::next_handshake_command (msg_t *msg_)
@@ -70,11 +79,21 @@ int zmq::curve_server_t::next_handshake_command (msg_t *msg_)
 
 int zmq::curve_server_t::process_handshake_command (msg_t *msg_)
 {
+    //  Leave the command to the engine until the previous one is done.
+    if (_crypto_pending) {
+        errno = EAGAIN;
+        return -1;
+    }
+
     int rc = 0;
 
     switch (state) {
         case waiting_for_hello:
-            rc = process_hello (msg_);
+            if (options.curve_ticket_lifetime > 0 && msg_->size () >= 7
+                && !memcmp (msg_->data (), "\x06RESUME", 7))
+                rc = process_resume (msg_);
+            else
+                rc = process_hello (msg_);
             break;
         case waiting_for_initiate:
             rc = process_initiate (msg_);
@@ -114,9 +133,69 @@ int zmq::curve_server_t::decode (msg_t *msg_)
     return curve_mechanism_base_t::decode (msg_);
 }
 
+int zmq::curve_server_t::crypto_job_done ()
+{
+    zmq_assert (_crypto_pending);
+    _crypto_pending = false;
+    return finish_crypto ();
+}
+
+void zmq::curve_server_t::run_crypto ()
+{
+    if (_crypto_step == hello_step) {
+        //  HELLO and WELCOME are both boxed between C' and S, so that
+        //  the key they share is computed once.
+        std::vector<uint8_t, secure_allocator_t<uint8_t> > hello_key (
+          crypto_box_BEFORENMBYTES);
+        if (crypto_box_beforenm (&hello_key[0], _cn_client, _secret_key) != 0)
+            _crypto_error = ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+        else {
+            _crypto_error = open_hello (&hello_key[0]);
+            if (_crypto_error == 0)
+                _crypto_error = seal_welcome (&hello_key[0]);
+        }
+    } else if (_crypto_step == initiate_step)
+        _crypto_error = open_initiate ();
+    else
+        _crypto_error = open_resume ();
+}
+
+int zmq::curve_server_t::start_crypto (crypto_step_t step_,
+                                       const uint8_t *command_,
+                                       size_t size_)
+{
+    _crypto_step = step_;
+    _command.assign (command_, command_ + size_);
+
+    if (_crypto_notifier) {
+        _crypto_pending = true;
+        _crypto_notifier->post (this);
+        return 0;
+    }
+    run_crypto ();
+    return finish_crypto ();
+}
+
+int zmq::curve_server_t::finish_crypto ()
+{
+    std::vector<uint8_t> ().swap (_command);
+
+    if (_crypto_error != 0) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), _crypto_error);
+        errno = EPROTO;
+        return -1;
+    }
+    if (_crypto_step == hello_step) {
+        state = sending_welcome;
+        return 0;
+    }
+    return accept_client ();
+}
+
 int zmq::curve_server_t::process_hello (msg_t *msg_)
 {
-    int rc = check_basic_command_structure (msg_);
+    const int rc = check_basic_command_structure (msg_);
     if (rc == -1)
         return -1;
 
@@ -153,6 +232,15 @@ int zmq::curve_server_t::process_hello (msg_t *msg_)
     //  Save client's short-term public key (C')
     memcpy (_cn_client, hello + 80, 32);
 
+    set_peer_nonce (get_uint64 (hello + 112));
+
+    return start_crypto (hello_step, hello, size);
+}
+
+int zmq::curve_server_t::open_hello (const uint8_t *hello_key_)
+{
+    const uint8_t *const hello = &_command[0];
+
     uint8_t hello_nonce[crypto_box_NONCEBYTES];
     std::vector<uint8_t, secure_allocator_t<uint8_t> > hello_plaintext (
       crypto_box_ZEROBYTES + 64);
@@ -160,28 +248,27 @@ int zmq::curve_server_t::process_hello (msg_t *msg_)
 
     memcpy (hello_nonce, "CurveZMQHELLO---", 16);
     memcpy (hello_nonce + 16, hello + 112, 8);
-    set_peer_nonce (get_uint64 (hello + 112));
 
     memset (hello_box, 0, crypto_box_BOXZEROBYTES);
     memcpy (hello_box + crypto_box_BOXZEROBYTES, hello + 120, 80);
 
     //  Open Box [64 * %x0](C'->S)
-    rc = crypto_box_open (&hello_plaintext[0], hello_box, sizeof hello_box,
-                          hello_nonce, _cn_client, _secret_key);
+    const int rc =
+      crypto_box_open_afternm (&hello_plaintext[0], hello_box,
+                               sizeof hello_box, hello_nonce, hello_key_);
     if (rc != 0) {
         // CURVE I: cannot open client HELLO -- wrong server key?
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
-        return -1;
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
     }
-
-    state = sending_welcome;
-    return rc;
+    return 0;
 }
 
-int zmq::curve_server_t::produce_welcome (msg_t *msg_)
+int zmq::curve_server_t::seal_welcome (const uint8_t *hello_key_)
 {
+    //  Generate short-term key pair
+    int rc = crypto_box_keypair (_cn_public, _cn_secret);
+    zmq_assert (rc == 0);
+
     uint8_t cookie_nonce[crypto_secretbox_NONCEBYTES];
     std::vector<uint8_t, secure_allocator_t<uint8_t> > cookie_plaintext (
       crypto_secretbox_ZEROBYTES + 64);
@@ -204,9 +291,8 @@ int zmq::curve_server_t::produce_welcome (msg_t *msg_)
     randombytes (_cookie_key, crypto_secretbox_KEYBYTES);
 
     //  Encrypt using symmetric cookie key
-    int rc =
-      crypto_secretbox (cookie_ciphertext, &cookie_plaintext[0],
-                        cookie_plaintext.size (), cookie_nonce, _cookie_key);
+    rc = crypto_secretbox (cookie_ciphertext, &cookie_plaintext[0],
+                           cookie_plaintext.size (), cookie_nonce, _cookie_key);
     zmq_assert (rc == 0);
 
     uint8_t welcome_nonce[crypto_box_NONCEBYTES];
@@ -229,9 +315,9 @@ int zmq::curve_server_t::produce_welcome (msg_t *msg_)
     memcpy (&welcome_plaintext[crypto_box_ZEROBYTES + 48],
             cookie_ciphertext + crypto_secretbox_BOXZEROBYTES, 80);
 
-    rc = crypto_box (welcome_ciphertext, &welcome_plaintext[0],
-                     welcome_plaintext.size (), welcome_nonce, _cn_client,
-                     _secret_key);
+    rc = crypto_box_afternm (welcome_ciphertext, &welcome_plaintext[0],
+                             welcome_plaintext.size (), welcome_nonce,
+                             hello_key_);
 
     //  TODO I think we should change this back to zmq_assert (rc == 0);
     //  as it was before https://github.com/zeromq/libzmq/pull/1832
@@ -240,22 +326,26 @@ int zmq::curve_server_t::produce_welcome (msg_t *msg_)
     //  not have opened the client's hello box with a 0ed key.
 
     if (rc == -1)
-        return -1;
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
 
-    rc = msg_->init_size (168);
-    errno_assert (rc == 0);
+    memcpy (_welcome, "\x07WELCOME", 8);
+    memcpy (_welcome + 8, welcome_nonce + 8, 16);
+    memcpy (_welcome + 24, welcome_ciphertext + crypto_box_BOXZEROBYTES, 144);
 
-    uint8_t *const welcome = static_cast<uint8_t *> (msg_->data ());
-    memcpy (welcome, "\x07WELCOME", 8);
-    memcpy (welcome + 8, welcome_nonce + 8, 16);
-    memcpy (welcome + 24, welcome_ciphertext + crypto_box_BOXZEROBYTES, 144);
+    return 0;
+}
 
+int zmq::curve_server_t::produce_welcome (msg_t *msg_)
+{
+    const int rc = msg_->init_size (sizeof _welcome);
+    errno_assert (rc == 0);
+    memcpy (msg_->data (), _welcome, sizeof _welcome);
     return 0;
 }
 
 int zmq::curve_server_t::process_initiate (msg_t *msg_)
 {
-    int rc = check_basic_command_structure (msg_);
+    const int rc = check_basic_command_structure (msg_);
     if (rc == -1)
         return -1;
 
@@ -277,6 +367,16 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
         return -1;
     }
 
+    set_peer_nonce (get_uint64 (initiate + 105));
+
+    return start_crypto (initiate_step, initiate, size);
+}
+
+int zmq::curve_server_t::open_initiate ()
+{
+    const size_t size = _command.size ();
+    const uint8_t *initiate = &_command[0];
+
     uint8_t cookie_nonce[crypto_secretbox_NONCEBYTES];
     uint8_t cookie_plaintext[crypto_secretbox_ZEROBYTES + 64];
     uint8_t cookie_box[crypto_secretbox_BOXZEROBYTES + 80];
@@ -288,14 +388,12 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
     memcpy (cookie_nonce, "COOKIE--", 8);
     memcpy (cookie_nonce + 8, initiate + 9, 16);
 
-    rc = crypto_secretbox_open (cookie_plaintext, cookie_box, sizeof cookie_box,
-                                cookie_nonce, _cookie_key);
+    int rc = crypto_secretbox_open (cookie_plaintext, cookie_box,
+                                    sizeof cookie_box, cookie_nonce,
+                                    _cookie_key);
     if (rc != 0) {
         // CURVE I: cannot open client INITIATE cookie
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
-        return -1;
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
     }
 
     //  Check cookie plain text is as expected [C' + s']
@@ -306,10 +404,7 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
         //  client that knows the server's secret temporary cookie key
 
         // CURVE I: client INITIATE cookie is not valid
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
-        return -1;
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
     }
 
     const size_t clen = (size - 113) + crypto_box_BOXZEROBYTES;
@@ -327,7 +422,6 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
 
     memcpy (initiate_nonce, "CurveZMQINITIATE", 16);
     memcpy (initiate_nonce + 16, initiate + 105, 8);
-    set_peer_nonce (get_uint64 (initiate + 105));
 
     const uint8_t *client_key = &initiate_plaintext[crypto_box_ZEROBYTES];
 
@@ -335,10 +429,7 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
                           initiate_nonce, _cn_client, _cn_secret);
     if (rc != 0) {
         // CURVE I: cannot open client INITIATE
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
-        return -1;
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
     }
 
     uint8_t vouch_nonce[crypto_box_NONCEBYTES];
@@ -360,10 +451,7 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
                           vouch_nonce, client_key, _cn_secret);
     if (rc != 0) {
         // CURVE I: cannot open client INITIATE vouch
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
-        return -1;
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
     }
 
     //  What we decrypted must be the client's short-term public key
@@ -372,10 +460,7 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
         //  client that knows the server's secret short-term key
 
         // CURVE I: invalid handshake from client (public key)
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_KEY_EXCHANGE);
-        errno = EPROTO;
-        return -1;
+        return ZMQ_PROTOCOL_ERROR_ZMTP_KEY_EXCHANGE;
     }
 
     //  Precompute connection secret from client key
@@ -383,13 +468,132 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
                               _cn_secret);
     zmq_assert (rc == 0);
 
+    memcpy (_client_key, client_key, crypto_box_PUBLICKEYBYTES);
+    _metadata.assign (initiate_plaintext.begin () + crypto_box_ZEROBYTES + 128,
+                      initiate_plaintext.begin () + clen);
+    return 0;
+}
+
+int zmq::curve_server_t::process_resume (msg_t *msg_)
+{
+    const int rc = check_basic_command_structure (msg_);
+    if (rc == -1)
+        return -1;
+
+    const size_t size = msg_->size ();
+    const uint8_t *const resume = static_cast<uint8_t *> (msg_->data ());
+
+    //  RESUME is the command name, version, C', the ticket, a short nonce
+    //  and Box [C' + metadata](R).
+    if (size < 161 + crypto_secretbox_BOXZEROBYTES + 32 || resume[7] != 1
+        || resume[8] != 0) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (),
+          ZMQ_PROTOCOL_ERROR_ZMTP_MALFORMED_COMMAND_UNSPECIFIED);
+        errno = EPROTO;
+        return -1;
+    }
+
+    //  Save client's short-term public key (C')
+    memcpy (_cn_client, resume + 9, 32);
+
+    set_peer_nonce (get_uint64 (resume + 153));
+    _resumed = true;
+
+    return start_crypto (resume_step, resume, size);
+}
+
+int zmq::curve_server_t::open_resume ()
+{
+    const size_t size = _command.size ();
+    const uint8_t *const resume = &_command[0];
+    const uint8_t *const ticket = resume + 41;
+
+    std::vector<uint8_t, secure_allocator_t<uint8_t> > ticket_plaintext (
+      crypto_secretbox_ZEROBYTES + 72);
+    uint8_t ticket_box[crypto_secretbox_BOXZEROBYTES + 88];
+
+    //  Open Box [C + R + expiry](T)
+    memset (ticket_box, 0, crypto_secretbox_BOXZEROBYTES);
+    memcpy (ticket_box + crypto_secretbox_BOXZEROBYTES,
+            ticket + crypto_secretbox_NONCEBYTES, 88);
+
+    int rc = crypto_secretbox_open (&ticket_plaintext[0], ticket_box,
+                                    sizeof ticket_box, ticket,
+                                    options.curve_ticket_key);
+    if (rc != 0) {
+        //  Not issued by this socket, or before its key was renewed.
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+    }
+
+    const uint8_t *const client_key =
+      &ticket_plaintext[crypto_secretbox_ZEROBYTES];
+    const uint8_t *const secret = client_key + 32;
+
+    const uint64_t expiry = get_uint64 (secret + curve_ticket_secret_size);
+    if (expiry < clock_t::now_us () / 1000) {
+        //  The ticket has expired.
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+    }
+
+    const size_t clen = (size - 161) + crypto_secretbox_BOXZEROBYTES;
+
+    uint8_t resume_nonce[crypto_secretbox_NONCEBYTES];
+    std::vector<uint8_t, secure_allocator_t<uint8_t> > resume_plaintext (clen);
+    std::vector<uint8_t> resume_box (clen);
+
+    //  Open Box [C' + metadata](R)
+    std::fill (resume_box.begin (),
+               resume_box.begin () + crypto_secretbox_BOXZEROBYTES, 0);
+    memcpy (&resume_box[crypto_secretbox_BOXZEROBYTES], resume + 161,
+            clen - crypto_secretbox_BOXZEROBYTES);
+
+    memcpy (resume_nonce, "CurveZMQRESUME--", 16);
+    memcpy (resume_nonce + 16, resume + 153, 8);
+
+    rc = crypto_secretbox_open (&resume_plaintext[0], &resume_box[0], clen,
+                                resume_nonce, secret);
+    if (rc != 0) {
+        // CURVE I: cannot open client RESUME
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+    }
+
+    //  Only the holder of R can vouch for the short-term key.
+    if (memcmp (&resume_plaintext[crypto_secretbox_ZEROBYTES], _cn_client,
+                32)) {
+        return ZMQ_PROTOCOL_ERROR_ZMTP_KEY_EXCHANGE;
+    }
+
+    //  A ticket is used once, or a RESUME captured on the wire could be
+    //  replayed to take over the client's routing id.
+    if (!session->get_socket ()->curve_tickets ().use (
+          ticket, crypto_secretbox_NONCEBYTES, expiry)) {
+        return ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+    }
+
+    //  Generate short-term key pair and the key of the resumed session
+    rc = crypto_box_keypair (_cn_public, _cn_secret);
+    zmq_assert (rc == 0);
+    precompute_resumed (_cn_client, _cn_secret, secret);
+
+    memcpy (_client_key, client_key, crypto_box_PUBLICKEYBYTES);
+    _metadata.assign (resume_plaintext.begin () + crypto_secretbox_ZEROBYTES
+                        + 32,
+                      resume_plaintext.end ());
+    return 0;
+}
+
+int zmq::curve_server_t::accept_client ()
+{
+    int rc;
+
     //  Given this is a backward-incompatible change, it's behind a socket
     //  option disabled by default.
     if (zap_required () || !options.zap_enforce_domain) {
         //  Use ZAP protocol (RFC 27) to authenticate the user.
         rc = session->zap_connect ();
         if (rc == 0) {
-            send_zap_request (client_key);
+            send_zap_request (_client_key);
             state = waiting_for_zap_reply;
 
             //  TODO actually, it is quite unlikely that we can read the ZAP
@@ -412,13 +616,80 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
         state = sending_ready;
     }
 
-    return parse_metadata (&initiate_plaintext[crypto_box_ZEROBYTES + 128],
-                           clen - crypto_box_ZEROBYTES - 128);
+    rc = _metadata.empty () ? 0
+                            : parse_metadata (&_metadata[0], _metadata.size ());
+    std::vector<uint8_t, secure_allocator_t<uint8_t> > ().swap (_metadata);
+    return rc;
+}
+
+int zmq::curve_server_t::property (const std::string &name_,
+                                   const void *value_,
+                                   size_t length_)
+{
+    if (name_ == ZMTP_PROPERTY_CURVE_TICKET) {
+        _ticket_requested = true;
+        return 1;
+    }
+    if (name_ == ZMTP_PROPERTY_CURVE_CIPHER) {
+        //  Agree to the client's cipher if we would rather use it too.
+        _aes256gcm = options.curve_cipher == ZMQ_CURVE_CIPHER_AES256GCM
+                     && aes256gcm_available ()
+                     && length_ == strlen (ZMTP_CURVE_CIPHER_AES256GCM)
+                     && memcmp (value_, ZMTP_CURVE_CIPHER_AES256GCM, length_)
+                          == 0;
+        return 1;
+    }
+    return 0;
+}
+
+size_t zmq::curve_server_t::add_ticket (unsigned char *ptr_,
+                                        size_t ptr_capacity_) const
+{
+    //  R followed by the ticket
+    std::vector<uint8_t, secure_allocator_t<uint8_t> > value (
+      curve_ticket_secret_size + curve_ticket_size);
+    uint8_t *const secret = &value[0];
+    uint8_t *const ticket = secret + curve_ticket_secret_size;
+
+    randombytes (secret, curve_ticket_secret_size);
+    randombytes (ticket, crypto_secretbox_NONCEBYTES);
+
+    std::vector<uint8_t, secure_allocator_t<uint8_t> > ticket_plaintext (
+      crypto_secretbox_ZEROBYTES + 72);
+    uint8_t ticket_box[crypto_secretbox_BOXZEROBYTES + 88];
+
+    //  Create Box [C + R + expiry](T)
+    memcpy (&ticket_plaintext[crypto_secretbox_ZEROBYTES], _client_key, 32);
+    memcpy (&ticket_plaintext[crypto_secretbox_ZEROBYTES + 32], secret,
+            curve_ticket_secret_size);
+    put_uint64 (&ticket_plaintext[crypto_secretbox_ZEROBYTES + 64],
+                clock_t::now_us () / 1000 + options.curve_ticket_lifetime);
+
+    const int rc =
+      crypto_secretbox (ticket_box, &ticket_plaintext[0],
+                        ticket_plaintext.size (), ticket, options.curve_ticket_key);
+    zmq_assert (rc == 0);
+    memcpy (ticket + crypto_secretbox_NONCEBYTES,
+            ticket_box + crypto_secretbox_BOXZEROBYTES, 88);
+
+    return add_property (ptr_, ptr_capacity_, ZMTP_PROPERTY_CURVE_TICKET,
+                         &value[0], value.size ());
 }
 
 int zmq::curve_server_t::produce_ready (msg_t *msg_)
 {
-    const size_t metadata_length = basic_properties_len ();
+    const bool with_ticket =
+      _ticket_requested && options.curve_ticket_lifetime > 0;
+    const size_t ticket_length =
+      with_ticket ? property_len (ZMTP_PROPERTY_CURVE_TICKET,
+                                  curve_ticket_secret_size + curve_ticket_size)
+                  : 0;
+    const size_t cipher_length =
+      _aes256gcm ? property_len (ZMTP_PROPERTY_CURVE_CIPHER,
+                                 strlen (ZMTP_CURVE_CIPHER_AES256GCM))
+                 : 0;
+    const size_t metadata_length =
+      basic_properties_len () + ticket_length + cipher_length;
     uint8_t ready_nonce[crypto_box_NONCEBYTES];
 
     std::vector<uint8_t, secure_allocator_t<uint8_t> > ready_plaintext (
@@ -430,9 +701,17 @@ int zmq::curve_server_t::produce_ready (msg_t *msg_)
     uint8_t *ptr = &ready_plaintext[crypto_box_ZEROBYTES];
 
     ptr += add_basic_properties (ptr, metadata_length);
+    if (with_ticket)
+        ptr += add_ticket (ptr, ticket_length);
+    if (_aes256gcm)
+        ptr += add_property (ptr, cipher_length, ZMTP_PROPERTY_CURVE_CIPHER,
+                             ZMTP_CURVE_CIPHER_AES256GCM,
+                             strlen (ZMTP_CURVE_CIPHER_AES256GCM));
     const size_t mlen = ptr - &ready_plaintext[0];
 
-    memcpy (ready_nonce, "CurveZMQREADY---", 16);
+    //  A resumed session is confirmed with RESUMED, which also carries S'.
+    memcpy (ready_nonce, _resumed ? "CurveZMQRESUMED-" : "CurveZMQREADY---",
+            16);
     put_uint64 (ready_nonce + 16, get_and_inc_nonce ());
 
     std::vector<uint8_t> ready_box (crypto_box_BOXZEROBYTES + 16
@@ -442,18 +721,27 @@ int zmq::curve_server_t::produce_ready (msg_t *msg_)
                                  ready_nonce, get_precom_buffer ());
     zmq_assert (rc == 0);
 
-    rc = msg_->init_size (14 + mlen - crypto_box_BOXZEROBYTES);
+    const size_t header_size = _resumed ? 48 : 14;
+    rc = msg_->init_size (header_size + mlen - crypto_box_BOXZEROBYTES);
     errno_assert (rc == 0);
 
     uint8_t *ready = static_cast<uint8_t *> (msg_->data ());
 
-    memcpy (ready, "\x05READY", 6);
-    //  Short nonce, prefixed by "CurveZMQREADY---"
-    memcpy (ready + 6, ready_nonce + 16, 8);
+    if (_resumed) {
+        memcpy (ready, "\x07RESUMED", 8);
+        memcpy (ready + 8, _cn_public, 32);
+    } else
+        memcpy (ready, "\x05READY", 6);
+    //  Short nonce, prefixed by "CurveZMQREADY---" or "CurveZMQRESUMED-"
+    memcpy (ready + header_size - 8, ready_nonce + 16, 8);
     //  Box [metadata](S'->C')
-    memcpy (ready + 14, &ready_box[crypto_box_BOXZEROBYTES],
+    memcpy (ready + header_size, &ready_box[crypto_box_BOXZEROBYTES],
             mlen - crypto_box_BOXZEROBYTES);
 
+    //  Messages are sealed with the agreed cipher from here on.
+    if (_aes256gcm)
+        use_aes256gcm ();
+
     return 0;
 }
 
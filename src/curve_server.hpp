@@ -6,7 +6,9 @@
 #ifdef ZMQ_HAVE_CURVE
 
 #include "curve_mechanism_base.hpp"
+#include "crypto_pool.hpp"
 #include "options.hpp"
+#include "secure_allocator.hpp"
 #include "zap_client.hpp"
 
 namespace zmq
@@ -16,13 +18,18 @@ namespace zmq
 #pragma warning(disable : 4250)
 #endif
 class curve_server_t ZMQ_FINAL : public zap_client_common_handshake_t,
-                                 public curve_mechanism_base_t
+                                 public curve_mechanism_base_t,
+                                 public crypto_job_t
 {
   public:
+    //  With a crypto_notifier_, the public key operations of the
+    //  handshake run on the context's crypto pool. The notifier only has
+    //  to outlive the handshake.
     curve_server_t (session_base_t *session_,
                     const std::string &peer_address_,
                     const options_t &options_,
-                    const bool downgrade_sub_);
+                    const bool downgrade_sub_,
+                    crypto_notifier_t *crypto_notifier_ = NULL);
     ~curve_server_t ();
 
     // mechanism implementation
@@ -30,6 +37,14 @@ class curve_server_t ZMQ_FINAL : public zap_client_common_handshake_t,
     int process_handshake_command (msg_t *msg_);
     int encode (msg_t *msg_);
     int decode (msg_t *msg_);
+    int crypto_job_done ();
+
+    //  crypto_job_t implementation
+    void run_crypto ();
+
+  protected:
+    int
+    property (const std::string &name_, const void *value_, size_t length_);
 
   private:
     //  Our secret key (s)
@@ -47,9 +62,57 @@ class curve_server_t ZMQ_FINAL : public zap_client_common_handshake_t,
     //  Key used to produce cookie
     uint8_t _cookie_key[crypto_secretbox_KEYBYTES];
 
+    //  Handshake steps that need public key crypto. They run on the
+    //  crypto pool, if any, and must not use the session.
+    enum crypto_step_t
+    {
+        hello_step,
+        initiate_step,
+        resume_step
+    };
+
+    crypto_notifier_t *const _crypto_notifier;
+    crypto_step_t _crypto_step;
+
+    //  True while the step runs on the crypto pool.
+    bool _crypto_pending;
+
+    //  The command the step works on.
+    std::vector<uint8_t> _command;
+
+    //  Outcome of the step: 0 or the ZMQ_PROTOCOL_ERROR_* to report.
+    int _crypto_error;
+
+    //  WELCOME, made by the hello step.
+    uint8_t _welcome[168];
+
+    //  Client's public key (C) and metadata, from INITIATE or RESUME.
+    uint8_t _client_key[crypto_box_PUBLICKEYBYTES];
+    std::vector<uint8_t, secure_allocator_t<uint8_t> > _metadata;
+
+    //  True if the client resumes a session with a ticket.
+    bool _resumed;
+
+    //  True if the client asked for a ticket to resume this session.
+    bool _ticket_requested;
+
+    //  True if the client offered AES-256-GCM and we agreed to it.
+    bool _aes256gcm;
+
+    int
+    start_crypto (crypto_step_t step_, const uint8_t *command_, size_t size_);
+    int finish_crypto ();
+
     int process_hello (msg_t *msg_);
+    int open_hello (const uint8_t *hello_key_);
+    int seal_welcome (const uint8_t *hello_key_);
     int produce_welcome (msg_t *msg_);
     int process_initiate (msg_t *msg_);
+    int open_initiate ();
+    int process_resume (msg_t *msg_);
+    int open_resume ();
+    int accept_client ();
+    size_t add_ticket (unsigned char *ptr_, size_t ptr_capacity_) const;
     int produce_ready (msg_t *msg_);
     int produce_error (msg_t *msg_) const;
 
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "curve_tickets.hpp"
+#include "clock.hpp"
+
+zmq::curve_tickets_t::curve_tickets_t ()
+{
+}
+
+bool zmq::curve_tickets_t::use (const uint8_t *nonce_,
+                                size_t size_,
+                                uint64_t expiry_)
+{
+    scoped_lock_t locker (_sync);
+
+    purge (clock_t::now_us () / 1000);
+
+    const std::string nonce (reinterpret_cast<const char *> (nonce_), size_);
+    if (_nonces.size () >= max_tickets || !_nonces.insert (nonce).second)
+        return false;
+    _expiries.insert (std::make_pair (expiry_, nonce));
+    return true;
+}
+
+void zmq::curve_tickets_t::clear ()
+{
+    scoped_lock_t locker (_sync);
+
+    _nonces.clear ();
+    _expiries.clear ();
+}
+
+void zmq::curve_tickets_t::purge (uint64_t now_)
+{
+    while (!_expiries.empty () && _expiries.begin ()->first < now_) {
+        _nonces.erase (_expiries.begin ()->second);
+        _expiries.erase (_expiries.begin ());
+    }
+}
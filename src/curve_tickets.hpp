@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_CURVE_TICKETS_HPP_INCLUDED__
+#define __ZMQ_CURVE_TICKETS_HPP_INCLUDED__
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "macros.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  The CURVE tickets a server socket has accepted, kept until they
+//  expire, so that a RESUME captured on the wire cannot be replayed.
+//
+//  Tickets are told apart by their nonce. At most max_tickets unexpired
+//  tickets are kept; beyond that, tickets are turned down and clients
+//  fall back to the full handshake. All the functions are thread safe, as
+//  the sessions of a socket may run in different io threads.
+
+class curve_tickets_t
+{
+  public:
+    enum
+    {
+        max_tickets = 65536
+    };
+
+    curve_tickets_t ();
+
+    //  Records the ticket with nonce nonce_, valid till expiry_ msec, as
+    //  used. Returns false if it has been used before, or if there is no
+    //  room to record it.
+    bool use (const uint8_t *nonce_, size_t size_, uint64_t expiry_);
+
+    //  Forgets all tickets, once they cannot be opened anymore.
+    void clear ();
+
+  private:
+    //  Drops the tickets that have expired.
+    void purge (uint64_t now_);
+
+    std::set<std::string> _nonces;
+
+    //  Nonces by expiry, the earliest first.
+    std::multimap<uint64_t, std::string> _expiries;
+
+    mutex_t _sync;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (curve_tickets_t)
+};
+}
+
+#endif
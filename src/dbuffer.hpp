@@ -7,55 +7,58 @@
 #include <stddef.h>
 #include <algorithm>
 
-#include "mutex.hpp"
+#include "atomic_ptr.hpp"
 #include "msg.hpp"
 
 namespace zmq
 {
-//  dbuffer is a single-producer single-consumer double-buffer
-//  implementation.
+//  dbuffer is a wait-free single-producer single-consumer buffer keeping
+//  only the latest value written. It is a triple buffer: the producer owns
+//  a back slot, the consumer owns a front slot, and the third slot sits in
+//  between, published by atomically swapping slot indices.
 //
-//  The producer writes to a back buffer and then tries to swap
-//  pointers between the back and front buffers. If it fails,
-//  due to the consumer reading from the front buffer, it just
-//  gives up, which is ok since writes are many and redundant.
+//  The producer writes to its back slot and swaps it with the middle one,
+//  marking it as fresh. A value which was still in the middle unread is
+//  thereby handed back to the producer and dropped on its next write,
+//  which is ok since writes are many and redundant.
 //
-//  The reader simply reads from the front buffer.
+//  The consumer swaps its front slot with the middle one whenever the
+//  middle one is fresh, and reads from the front slot.
 //
-//  has_msg keeps track of whether there has been a not yet read
-//  value written, it is used by ypipe_conflate to mimic ypipe
-//  functionality regarding a reader being asleep
+//  has_msg keeps track of whether there is a not yet read value in the
+//  front slot, it is used by ypipe_conflate to mimic ypipe functionality
+//  regarding a reader being asleep
 
 template <typename T> class dbuffer_t;
 
 template <> class dbuffer_t<msg_t>
 {
   public:
-    dbuffer_t () : _back (&_storage[0]), _front (&_storage[1]), _has_msg (false)
+    dbuffer_t () : _back (0), _middle (1), _front (2), _has_msg (false)
     {
-        _back->init ();
-        _front->init ();
+        for (int i = 0; i != slots; ++i)
+            _storage[i].init ();
     }
 
     ~dbuffer_t ()
     {
-        _back->close ();
-        _front->close ();
+        for (int i = 0; i != slots; ++i)
+            _storage[i].close ();
     }
 
     void write (const msg_t &value_)
     {
         zmq_assert (value_.check ());
-        *_back = value_;
 
-        zmq_assert (_back->check ());
+        //  The back slot holds nothing, or a value the reader never got.
+        msg_t &back = _storage[_back];
+        const int rc = back.close ();
+        errno_assert (rc == 0);
+        back = value_;
 
-        if (_sync.try_lock ()) {
-            _front->move (*_back);
-            _has_msg = true;
+        zmq_assert (back.check ());
 
-            _sync.unlock ();
-        }
+        _back = _middle.xchg (_back | fresh) & index_mask;
     }
 
     bool read (msg_t *value_)
@@ -63,41 +66,65 @@ template <> class dbuffer_t<msg_t>
         if (!value_)
             return false;
 
-        {
-            scoped_lock_t lock (_sync);
-            if (!_has_msg)
-                return false;
+        //  Prefer a value published since the last check_read.
+        acquire_fresh ();
+        if (!_has_msg)
+            return false;
 
-            zmq_assert (_front->check ());
+        msg_t &front = _storage[_front];
+        zmq_assert (front.check ());
 
-            *value_ = *_front;
-            _front->init (); // avoid double free
+        *value_ = front;
+        front.init (); // avoid double free
 
-            _has_msg = false;
-            return true;
-        }
+        _has_msg = false;
+        return true;
     }
 
 
     bool check_read ()
     {
-        scoped_lock_t lock (_sync);
+        if (!_has_msg)
+            acquire_fresh ();
 
         return _has_msg;
     }
 
     bool probe (bool (*fn_) (const msg_t &))
     {
-        scoped_lock_t lock (_sync);
-        return (*fn_) (*_front);
+        return (*fn_) (_storage[_front]);
     }
 
 
   private:
-    msg_t _storage[2];
-    msg_t *_back, *_front;
+    //  If the middle slot holds a fresh value, swaps it with the front
+    //  one. An unread value in the front slot is handed to the producer,
+    //  which will drop it.
+    void acquire_fresh ()
+    {
+        if (_middle.load () & fresh) {
+            _front = _middle.xchg (_front) & index_mask;
+            _has_msg = true;
+        }
+    }
+
+    enum
+    {
+        slots = 3,
+        index_mask = 3,
+        fresh = 4
+    };
+
+    msg_t _storage[slots];
+
+    //  Slot owned by the producer.
+    int _back;
+
+    //  Slot in between, and whether it holds a fresh value.
+    atomic_value_t _middle;
 
-    mutex_t _sync;
+    //  Slot owned by the consumer.
+    int _front;
     bool _has_msg;
 
     ZMQ_NON_COPYABLE_NOR_MOVABLE (dbuffer_t)
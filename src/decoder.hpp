@@ -30,10 +30,13 @@ template <typename T, typename A = c_single_allocator>
 class decoder_base_t : public i_decoder
 {
   public:
-    explicit decoder_base_t (const size_t buf_size_) :
-        _next (NULL), _read_pos (NULL), _to_read (0), _allocator (buf_size_)
+    decoder_base_t (const size_t buf_size_, const allocator_t &hooks_) :
+        _next (NULL),
+        _read_pos (NULL),
+        _to_read (0),
+        _allocator (buf_size_, hooks_),
+        _buf (NULL)
     {
-        _buf = _allocator.allocate ();
     }
 
     ~decoder_base_t () ZMQ_OVERRIDE { _allocator.deallocate (); }
@@ -61,6 +64,29 @@ class decoder_base_t : public i_decoder
         *size_ = _allocator.size ();
     }
 
+    //  While the body of a message that does not fit in a msg_t is being
+    //  read, the rest of it goes straight into the message and whatever
+    //  follows into the buffer, so that nothing has to be copied out of the
+    //  buffer and a single read can finish the body and pick up the frames
+    //  after it. Headers are short enough to never take this path.
+    void get_buffers (unsigned char **data_,
+                      std::size_t *size_,
+                      unsigned char **next_data_,
+                      std::size_t *next_size_) ZMQ_FINAL
+    {
+        get_buffer (data_, size_);
+        *next_data_ = NULL;
+        *next_size_ = 0;
+
+        if (_to_read > msg_t::max_vsm_size
+            && (_read_pos < _buf || _read_pos >= _buf + _allocator.size ())) {
+            *data_ = _read_pos;
+            *size_ = _to_read;
+            *next_data_ = _buf;
+            *next_size_ = _allocator.size ();
+        }
+    }
+
     //  Processes the data in the buffer previously allocated using
     //  get_buffer function. size_ argument specifies number of bytes
     //  actually filled into the buffer. Function returns 1 when the
@@ -122,6 +148,12 @@ class decoder_base_t : public i_decoder
         _allocator.resize (new_size_);
     }
 
+    void release_buffer () ZMQ_FINAL
+    {
+        _allocator.deallocate ();
+        _buf = NULL;
+    }
+
   protected:
     //  Prototype of state machine action. Action should return false if
     //  it is unable to push the data to the system.
@@ -6,7 +6,8 @@
 #include "msg.hpp"
 
 zmq::shared_message_memory_allocator::shared_message_memory_allocator (
-  std::size_t bufsize_) :
+  std::size_t bufsize_, const allocator_t &hooks_) :
+    _hooks (hooks_),
     _buf (NULL),
     _buf_size (0),
     _max_size (bufsize_),
@@ -16,7 +17,10 @@ zmq::shared_message_memory_allocator::shared_message_memory_allocator (
 }
 
 zmq::shared_message_memory_allocator::shared_message_memory_allocator (
-  std::size_t bufsize_, std::size_t max_messages_) :
+  std::size_t bufsize_,
+  std::size_t max_messages_,
+  const allocator_t &hooks_) :
+    _hooks (hooks_),
     _buf (NULL),
     _buf_size (0),
     _max_size (bufsize_),
@@ -34,8 +38,7 @@ unsigned char *zmq::shared_message_memory_allocator::allocate ()
 {
     if (_buf) {
         // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (_buf);
+        zmq::atomic_counter_t *c = counter (_buf);
 
         // if refcnt drops to 0, there are no message using the buffer
         // because either all messages have been closed or only vsm-messages
@@ -51,32 +54,35 @@ unsigned char *zmq::shared_message_memory_allocator::allocate ()
     if (!_buf) {
         // allocate memory for reference counters together with reception buffer
         std::size_t const allocationsize =
-          _max_size + sizeof (zmq::atomic_counter_t)
+          header_size + _max_size
           + _max_counters * sizeof (zmq::msg_t::content_t);
 
-        _buf = static_cast<unsigned char *> (std::malloc (allocationsize));
+        _buf = static_cast<unsigned char *> (
+          zmq::allocate (_hooks, allocationsize));
         alloc_assert (_buf);
 
-        new (_buf) atomic_counter_t (1);
+        new (_buf) allocator_t (_hooks);
+        new (counter (_buf)) atomic_counter_t (1);
     } else {
         // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (_buf);
+        zmq::atomic_counter_t *c = counter (_buf);
         c->set (1);
     }
 
     _buf_size = _max_size;
     _msg_content = reinterpret_cast<zmq::msg_t::content_t *> (
-      _buf + sizeof (atomic_counter_t) + _max_size);
-    return _buf + sizeof (zmq::atomic_counter_t);
+      _buf + header_size + _max_size);
+    return _buf + header_size;
 }
 
 void zmq::shared_message_memory_allocator::deallocate ()
 {
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (_buf);
-    if (_buf && !c->sub (1)) {
-        c->~atomic_counter_t ();
-        std::free (_buf);
+    if (_buf) {
+        zmq::atomic_counter_t *c = counter (_buf);
+        if (!c->sub (1)) {
+            c->~atomic_counter_t ();
+            zmq::deallocate (_hooks, _buf);
+        }
     }
     clear ();
 }
@@ -97,18 +103,20 @@ void zmq::shared_message_memory_allocator::clear ()
 
 void zmq::shared_message_memory_allocator::inc_ref ()
 {
-    (reinterpret_cast<zmq::atomic_counter_t *> (_buf))->add (1);
+    counter (_buf)->add (1);
 }
 
 void zmq::shared_message_memory_allocator::call_dec_ref (void *, void *hint_)
 {
     zmq_assert (hint_);
     unsigned char *buf = static_cast<unsigned char *> (hint_);
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (buf);
+    zmq::atomic_counter_t *c = counter (buf);
 
     if (!c->sub (1)) {
         c->~atomic_counter_t ();
-        std::free (buf);
+        //  The decoder may be gone, use the hooks stored with the buffer.
+        const allocator_t hooks = *reinterpret_cast<allocator_t *> (buf);
+        zmq::deallocate (hooks, buf);
         buf = NULL;
     }
 }
@@ -121,5 +129,5 @@ std::size_t zmq::shared_message_memory_allocator::size () const
 
 unsigned char *zmq::shared_message_memory_allocator::data ()
 {
-    return _buf + sizeof (zmq::atomic_counter_t);
+    return _buf + header_size;
 }
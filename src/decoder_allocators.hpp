@@ -6,35 +6,52 @@
 #include <cstddef>
 #include <cstdlib>
 
+#include "allocator.hpp"
 #include "atomic_counter.hpp"
 #include "msg.hpp"
 #include "err.hpp"
 
 namespace zmq
 {
-// Static buffer policy.
+// Static buffer policy. The buffer is allocated on first use and kept
+// until deallocate is called.
 class c_single_allocator
 {
   public:
-    explicit c_single_allocator (std::size_t bufsize_) :
-        _buf_size (bufsize_),
-        _buf (static_cast<unsigned char *> (std::malloc (_buf_size)))
+    c_single_allocator (std::size_t bufsize_, const allocator_t &hooks_) :
+        _hooks (hooks_), _buf_size (bufsize_), _buf (NULL)
     {
-        alloc_assert (_buf);
     }
 
-    ~c_single_allocator () { std::free (_buf); }
+    ~c_single_allocator () { deallocate (); }
 
-    unsigned char *allocate () { return _buf; }
+    unsigned char *allocate ()
+    {
+        if (!_buf) {
+            _buf =
+              static_cast<unsigned char *> (zmq::allocate (_hooks, _buf_size));
+            alloc_assert (_buf);
+        }
+        return _buf;
+    }
 
-    void deallocate () {}
+    void deallocate ()
+    {
+        if (_buf) {
+            zmq::deallocate (_hooks, _buf);
+            _buf = NULL;
+        }
+    }
 
     std::size_t size () const { return _buf_size; }
 
     //  This buffer is fixed, size must not be changed
     void resize (std::size_t new_size_) { LIBZMQ_UNUSED (new_size_); }
 
+    const allocator_t &hooks () const { return _hooks; }
+
   private:
+    const allocator_t _hooks;
     std::size_t _buf_size;
     unsigned char *_buf;
 
@@ -50,14 +67,19 @@ class c_single_allocator
 // from zero to one, gets passed to the user application, processed in the user thread and deleted
 // which would then deallocate the buffer. The drawback is that the buffer may be allocated longer
 // than necessary because it is only deleted when allocate is called the next time.
+//
+// The memory hooks are stored in front of the reference count, so that the
+// last message referring to the buffer can free it on any thread.
 class shared_message_memory_allocator
 {
   public:
-    explicit shared_message_memory_allocator (std::size_t bufsize_);
+    shared_message_memory_allocator (std::size_t bufsize_,
+                                     const allocator_t &hooks_);
 
     // Create an allocator for a maximum number of messages
     shared_message_memory_allocator (std::size_t bufsize_,
-                                     std::size_t max_messages_);
+                                     std::size_t max_messages_,
+                                     const allocator_t &hooks_);
 
     ~shared_message_memory_allocator ();
 
@@ -92,9 +114,22 @@ class shared_message_memory_allocator
 
     void advance_content () { _msg_content++; }
 
+    const allocator_t &hooks () const { return _hooks; }
+
   private:
     void clear ();
 
+    //  Size of the hooks and the reference count in front of the data.
+    static const std::size_t header_size =
+      sizeof (allocator_t) + sizeof (atomic_counter_t);
+
+    static atomic_counter_t *counter (unsigned char *buf_)
+    {
+        return reinterpret_cast<atomic_counter_t *> (buf_
+                                                     + sizeof (allocator_t));
+    }
+
+    const allocator_t _hooks;
     unsigned char *_buf;
     std::size_t _buf_size;
     const std::size_t _max_size;
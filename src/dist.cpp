@@ -152,7 +152,9 @@ void zmq::dist_t::distribute (msg_t *msg_)
         return;
     }
 
-    if (msg_->is_vsm ()) {
+    //  Small and static messages are copied by value, there is no reference
+    //  count to maintain.
+    if (msg_->is_vsm () || msg_->is_cmsg ()) {
         for (pipes_t::size_type i = 0; i < _matching;) {
             if (!write (_pipes[i], msg_)) {
                 //  Use same index again because entry will have been removed.
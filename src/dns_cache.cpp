@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "dns_cache.hpp"
+#include "command.hpp"
+#include "object.hpp"
+#include "clock.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+
+zmq::dns_cache_t::dns_cache_t (ctx_t *ctx_, int ttl_, int negative_ttl_) :
+    _ctx (ctx_), _ttl (ttl_), _negative_ttl (negative_ttl_), _stopping (false)
+{
+}
+
+zmq::dns_cache_t::~dns_cache_t ()
+{
+    _sync.lock ();
+    _stopping = true;
+    _cond.broadcast ();
+    _sync.unlock ();
+
+    _thread.stop ();
+
+    for (entries_t::iterator it = _entries.begin (), end = _entries.end ();
+         it != end; ++it)
+        zmq_assert (it->second.waiters.empty ());
+}
+
+void zmq::dns_cache_t::start (const thread_ctx_t &ctx_)
+{
+    ctx_.start_thread (_thread, worker_routine, this, "DNS");
+}
+
+int zmq::dns_cache_t::resolve (const std::string &address_,
+                               bool ipv6_,
+                               object_t *waiter_,
+                               tcp_address_t *addr_)
+{
+    scoped_lock_t locker (_sync);
+
+    const key_t key (address_, ipv6_);
+    entries_t::iterator it = _entries.find (key);
+    if (it != _entries.end () && !it->second.pending
+        && it->second.expiry <= clock_t::now_us () / 1000) {
+        _entries.erase (it);
+        it = _entries.end ();
+    }
+
+    if (it == _entries.end ()) {
+        it = _entries.insert (entries_t::value_type (key, entry_t ())).first;
+        it->second.pending = true;
+        it->second.error = 0;
+        it->second.expiry = 0;
+        _queue.push_back (key);
+        _cond.broadcast ();
+    }
+
+    entry_t &entry = it->second;
+    if (entry.pending) {
+        const waiter_t waiter = {waiter_, addr_};
+        entry.waiters.push_back (waiter);
+        errno = EINPROGRESS;
+        return -1;
+    }
+    if (entry.error != 0) {
+        errno = entry.error;
+        return -1;
+    }
+    *addr_ = entry.addr;
+    return 0;
+}
+
+bool zmq::dns_cache_t::cancel (object_t *waiter_)
+{
+    scoped_lock_t locker (_sync);
+
+    for (entries_t::iterator it = _entries.begin (), end = _entries.end ();
+         it != end; ++it) {
+        std::vector<waiter_t> &waiters = it->second.waiters;
+        for (size_t i = 0, size = waiters.size (); i != size; i++) {
+            if (waiters[i].object == waiter_) {
+                waiters.erase (waiters.begin () + i);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void zmq::dns_cache_t::worker_routine (void *arg_)
+{
+    static_cast<dns_cache_t *> (arg_)->work ();
+}
+
+void zmq::dns_cache_t::work ()
+{
+    _sync.lock ();
+    while (true) {
+        while (_queue.empty () && !_stopping)
+            _cond.wait (&_sync, -1);
+        if (_stopping)
+            break;
+
+        const key_t key = _queue.front ();
+        _queue.pop_front ();
+        _sync.unlock ();
+
+        tcp_address_t addr;
+        const int rc = addr.resolve (key.first.c_str (), false, key.second);
+        const int error = rc == 0 ? 0 : errno;
+
+        //  Notify the waiters while still holding the lock, so that a
+        //  connecter that is cancelled meanwhile knows whether to wait
+        //  for its command.
+        _sync.lock ();
+        const uint64_t now = clock_t::now_us () / 1000;
+        purge (now);
+
+        const entries_t::iterator it = _entries.find (key);
+        zmq_assert (it != _entries.end () && it->second.pending);
+        entry_t &entry = it->second;
+        entry.pending = false;
+        entry.error = error;
+        entry.addr = addr;
+        entry.expiry = now + (error == 0 ? _ttl : _negative_ttl);
+
+        for (size_t i = 0, size = entry.waiters.size (); i != size; i++) {
+            if (error == 0)
+                *entry.waiters[i].addr = addr;
+
+            command_t cmd;
+            cmd.destination = entry.waiters[i].object;
+            cmd.type = command_t::resolved;
+            cmd.args.resolved.error = error;
+            _ctx->send_command (cmd.destination->get_tid (), cmd);
+        }
+        entry.waiters.clear ();
+    }
+    _sync.unlock ();
+}
+
+void zmq::dns_cache_t::purge (uint64_t now_)
+{
+    entries_t::iterator it = _entries.begin ();
+    while (it != _entries.end ()) {
+        if (!it->second.pending && it->second.expiry <= now_)
+            _entries.erase (it++);
+        else
+            ++it;
+    }
+}
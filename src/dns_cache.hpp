@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_DNS_CACHE_HPP_INCLUDED__
+#define __ZMQ_DNS_CACHE_HPP_INCLUDED__
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "macros.hpp"
+#include "mutex.hpp"
+#include "condition_variable.hpp"
+#include "stdint.hpp"
+#include "tcp_address.hpp"
+#include "thread.hpp"
+
+namespace zmq
+{
+class ctx_t;
+class object_t;
+class thread_ctx_t;
+
+//  Resolves the addresses of the TCP connecters of a context on a thread
+//  of its own, so that a slow name server doesn't hold up the io threads,
+//  and keeps the results for a while.
+//
+//  Successful lookups are kept for the positive TTL and failed ones for
+//  the negative TTL, both in msec. Connecters asking for an address that
+//  is being looked up already wait for the same lookup. Once it is done,
+//  each of them gets a resolved command.
+
+class dns_cache_t
+{
+  public:
+    dns_cache_t (ctx_t *ctx_, int ttl_, int negative_ttl_);
+
+    //  Stops the thread. No connecter may be waiting.
+    ~dns_cache_t ();
+
+    //  Starts the thread with the context's thread settings.
+    void start (const thread_ctx_t &ctx_);
+
+    //  Looks the remote address address_ up. Returns 0 with the address
+    //  stored in addr_ if it is known, or -1 with errno set if it is
+    //  known not to resolve. Otherwise returns -1 with EINPROGRESS, and
+    //  stores the address in addr_ and sends a resolved command to
+    //  waiter_ once the lookup is done.
+    int resolve (const std::string &address_,
+                 bool ipv6_,
+                 object_t *waiter_,
+                 tcp_address_t *addr_);
+
+    //  Makes sure waiter_ is not sent a resolved command anymore, nor is
+    //  its address written to. Returns false if the command has been
+    //  sent already.
+    bool cancel (object_t *waiter_);
+
+  private:
+    typedef std::pair<std::string, bool> key_t;
+
+    struct waiter_t
+    {
+        object_t *object;
+        tcp_address_t *addr;
+    };
+
+    struct entry_t
+    {
+        //  Set while the address is being looked up.
+        bool pending;
+
+        //  The result of the lookup, valid till expiry.
+        int error;
+        tcp_address_t addr;
+        uint64_t expiry;
+
+        std::vector<waiter_t> waiters;
+    };
+    typedef std::map<key_t, entry_t> entries_t;
+
+    static void worker_routine (void *arg_);
+    void work ();
+
+    //  Drops the results that have expired.
+    void purge (uint64_t now_);
+
+    ctx_t *const _ctx;
+    const int _ttl;
+    const int _negative_ttl;
+
+    entries_t _entries;
+
+    //  Addresses waiting to be looked up.
+    std::deque<key_t> _queue;
+
+    thread_t _thread;
+    bool _stopping;
+
+    mutex_t _sync;
+    condition_variable_t _cond;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (dns_cache_t)
+};
+}
+
+#endif
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <algorithm>
 
+#include "allocator.hpp"
 #include "err.hpp"
 #include "i_encoder.hpp"
 #include "msg.hpp"
@@ -27,31 +28,35 @@ namespace zmq
 template <typename T> class encoder_base_t : public i_encoder
 {
   public:
-    explicit encoder_base_t (size_t bufsize_) :
+    encoder_base_t (size_t bufsize_, const allocator_t &hooks_) :
         _write_pos (0),
         _to_write (0),
         _next (NULL),
         _new_msg_flag (false),
+        _hooks (hooks_),
         _buf_size (bufsize_),
-        _buf (static_cast<unsigned char *> (malloc (bufsize_))),
+        _buf (NULL),
         _in_progress (NULL)
     {
-        alloc_assert (_buf);
     }
 
-    ~encoder_base_t () ZMQ_OVERRIDE { free (_buf); }
+    ~encoder_base_t () ZMQ_OVERRIDE { release_buffer (); }
 
     //  The function returns a batch of binary data. The data
     //  are filled to a supplied buffer. If no buffer is supplied (data_
     //  points to NULL) decoder object will provide buffer of its own.
     size_t encode (unsigned char **data_, size_t size_) ZMQ_FINAL
     {
-        unsigned char *buffer = !*data_ ? _buf : *data_;
-        const size_t buffersize = !*data_ ? _buf_size : size_;
-
         if (in_progress () == NULL)
             return 0;
 
+        if (!*data_ && !_buf) {
+            _buf = static_cast<unsigned char *> (allocate (_hooks, _buf_size));
+            alloc_assert (_buf);
+        }
+        unsigned char *buffer = !*data_ ? _buf : *data_;
+        const size_t buffersize = !*data_ ? _buf_size : size_;
+
         size_t pos = 0;
         while (pos < buffersize) {
             //  If there are no more data to return, run the state machine.
@@ -106,6 +111,14 @@ template <typename T> class encoder_base_t : public i_encoder
         (static_cast<T *> (this)->*_next) ();
     }
 
+    void release_buffer () ZMQ_FINAL
+    {
+        if (_buf) {
+            deallocate (_hooks, _buf);
+            _buf = NULL;
+        }
+    }
+
   protected:
     //  Prototype of state machine action.
     typedef void (T::*step_t) ();
@@ -138,9 +151,11 @@ template <typename T> class encoder_base_t : public i_encoder
 
     bool _new_msg_flag;
 
-    //  The buffer for encoded data.
+    //  The buffer for encoded data and the hooks it is allocated with.
+    //  It is only allocated once encode has to copy data into it.
+    const allocator_t _hooks;
     const size_t _buf_size;
-    unsigned char *const _buf;
+    unsigned char *_buf;
 
     msg_t *_in_progress;
 
@@ -0,0 +1,377 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "hugepage_pool.hpp"
+#include "macros.hpp"
+
+#include <stdlib.h>
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "config.hpp"
+#include "err.hpp"
+#include "likely.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+
+#if !defined MAP_ANONYMOUS && defined MAP_ANON
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+namespace
+{
+const size_t region_size = 2 * 1024 * 1024;
+
+//  Every mapping starts with this header, padded so that the blocks after
+//  it stay cache line aligned. A block finds its header by rounding its
+//  address down to the region size, so mappings are region aligned.
+struct region_t
+{
+    size_t size_class;
+    size_t length;
+
+    //  The rest is only used by regions carved into blocks, under the lock
+    //  of their size class. Blocks from unused on have never been handed
+    //  out, so that their pages are not touched before they are needed.
+    void *free_head;
+    unsigned char *unused;
+    size_t free_blocks;
+
+    //  Links in the list of regions of the class that have free blocks.
+    region_t *prev;
+    region_t *next;
+};
+const size_t header_size = 64;
+
+//  Blocks of 64, 128 and 256 bytes, then four classes per power of two up
+//  to max_block_size. Larger blocks have size class size_classes.
+const size_t size_classes = 3 + 11 * 4;
+const size_t max_block_size = 512 * 1024;
+
+size_t class_size (size_t size_class_)
+{
+    if (size_class_ < 3)
+        return static_cast<size_t> (64) << size_class_;
+    const size_t shift = 8 + (size_class_ - 3) / 4;
+    const size_t quarters = (size_class_ - 3) % 4 + 1;
+    return (static_cast<size_t> (1) << shift)
+           + quarters * (static_cast<size_t> (1) << (shift - 2));
+}
+
+size_t size_class_of (size_t size_)
+{
+    if (size_ <= 256)
+        return size_ <= 64 ? 0 : size_ <= 128 ? 1 : 2;
+    size_t shift = 8;
+    while ((static_cast<size_t> (2) << shift) < size_)
+        shift++;
+    const size_t step = static_cast<size_t> (1) << (shift - 2);
+    const size_t quarters =
+      (size_ - (static_cast<size_t> (1) << shift) + step - 1) / step;
+    return 3 + (shift - 8) * 4 + quarters - 1;
+}
+
+size_t region_blocks (size_t size_class_)
+{
+    return (region_size - header_size) / class_size (size_class_);
+}
+
+//  The regions of one size class with free blocks. Threads take blocks
+//  from them and give blocks back in batches, so the lock is off the
+//  path of most allocations.
+struct size_class_t
+{
+    zmq::mutex_t sync;
+    region_t *regions;
+
+    //  Number of regions without any block handed out.
+    size_t free_regions;
+};
+
+size_class_t classes[size_classes];
+
+//  Maps length_ bytes, a multiple of region_size, at a region aligned
+//  address.
+void *map_region (size_t length_)
+{
+#ifdef MAP_HUGETLB
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+    //  The default hugepage size may be larger than a region.
+    flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+    void *hugetlb = mmap (NULL, length_, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (hugetlb != MAP_FAILED)
+        return hugetlb;
+#endif
+
+    //  No hugepages reserved. Map an extra region to be able to align the
+    //  mapping, and ask for transparent hugepages.
+    const size_t mapped = length_ + region_size;
+    void *ptr = mmap (NULL, mapped, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+    unsigned char *const start = static_cast<unsigned char *> (ptr);
+    unsigned char *const aligned = reinterpret_cast<unsigned char *> (
+      (reinterpret_cast<uintptr_t> (start) + region_size - 1)
+      & ~static_cast<uintptr_t> (region_size - 1));
+    if (aligned > start)
+        munmap (start, aligned - start);
+    if (start + mapped > aligned + length_)
+        munmap (aligned + length_, start + mapped - (aligned + length_));
+#ifdef MADV_HUGEPAGE
+    madvise (aligned, length_, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+region_t *region_of (void *ptr_)
+{
+    return reinterpret_cast<region_t *> (reinterpret_cast<uintptr_t> (ptr_)
+                                         & ~static_cast<uintptr_t> (
+                                           region_size - 1));
+}
+
+void link_region (size_class_t &class_, region_t *region_)
+{
+    region_->prev = NULL;
+    region_->next = class_.regions;
+    if (class_.regions)
+        class_.regions->prev = region_;
+    class_.regions = region_;
+}
+
+void unlink_region (size_class_t &class_, region_t *region_)
+{
+    if (region_->prev)
+        region_->prev->next = region_->next;
+    else
+        class_.regions = region_->next;
+    if (region_->next)
+        region_->next->prev = region_->prev;
+}
+
+//  Takes up to count_ blocks of the class, linked through their first
+//  word, and stores their number in taken_. Fewer blocks are taken only
+//  if memory is exhausted.
+void *take_blocks (size_t size_class_, size_t count_, size_t *taken_)
+{
+    size_class_t &size_class = classes[size_class_];
+    const size_t block_size = class_size (size_class_);
+    const size_t blocks = region_blocks (size_class_);
+    zmq::scoped_lock_t lock (size_class.sync);
+
+    void *head = NULL;
+    size_t taken = 0;
+    while (taken < count_) {
+        region_t *region = size_class.regions;
+        if (!region) {
+            region = static_cast<region_t *> (map_region (region_size));
+            if (!region)
+                break;
+            region->size_class = size_class_;
+            region->length = region_size;
+            region->free_head = NULL;
+            region->unused =
+              reinterpret_cast<unsigned char *> (region) + header_size;
+            region->free_blocks = blocks;
+            link_region (size_class, region);
+        } else if (region->free_blocks == blocks)
+            size_class.free_regions--;
+
+        while (taken < count_ && region->free_blocks > 0) {
+            void *block = region->free_head;
+            if (block)
+                region->free_head = *static_cast<void **> (block);
+            else {
+                block = region->unused;
+                region->unused += block_size;
+            }
+            region->free_blocks--;
+            *static_cast<void **> (block) = head;
+            head = block;
+            taken++;
+        }
+        if (region->free_blocks == 0)
+            unlink_region (size_class, region);
+    }
+    *taken_ = taken;
+    return head;
+}
+
+//  Gives back the blocks linked from head_, all of the class. Regions
+//  that become free beyond the few kept for reuse are unmapped.
+void return_blocks (size_t size_class_, void *head_)
+{
+    size_class_t &size_class = classes[size_class_];
+    const size_t blocks = region_blocks (size_class_);
+    zmq::scoped_lock_t lock (size_class.sync);
+
+    while (head_) {
+        void *const block = head_;
+        head_ = *static_cast<void **> (block);
+
+        region_t *const region = region_of (block);
+        if (region->free_blocks == 0)
+            link_region (size_class, region);
+        *static_cast<void **> (block) = region->free_head;
+        region->free_head = block;
+        if (++region->free_blocks < blocks)
+            continue;
+
+        if (size_class.free_regions < zmq::hugepage_pool_free_regions)
+            size_class.free_regions++;
+        else {
+            unlink_region (size_class, region);
+            munmap (region, region->length);
+        }
+    }
+}
+
+struct thread_cache_t
+{
+    void *heads[size_classes];
+    size_t counts[size_classes];
+};
+
+pthread_key_t cache_key;
+pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+//  Runs when a thread that used the pool exits.
+void release_thread_cache (void *cache_)
+{
+    thread_cache_t *const cache = static_cast<thread_cache_t *> (cache_);
+    for (size_t size_class = 0; size_class < size_classes; size_class++)
+        if (cache->heads[size_class])
+            return_blocks (size_class, cache->heads[size_class]);
+    free (cache);
+}
+
+void create_cache_key ()
+{
+    const int rc = pthread_key_create (&cache_key, release_thread_cache);
+    posix_assert (rc);
+}
+
+//  Returns NULL if the cache could not be allocated.
+thread_cache_t *thread_cache ()
+{
+    int rc = pthread_once (&cache_key_once, create_cache_key);
+    posix_assert (rc);
+
+    thread_cache_t *cache =
+      static_cast<thread_cache_t *> (pthread_getspecific (cache_key));
+    if (unlikely (!cache)) {
+        cache =
+          static_cast<thread_cache_t *> (calloc (1, sizeof (thread_cache_t)));
+        if (!cache)
+            return NULL;
+        rc = pthread_setspecific (cache_key, cache);
+        if (rc != 0) {
+            free (cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+//  Blocks are moved between a thread's cache and the regions half a
+//  cache at a time.
+size_t thread_cache_limit (size_t size_class_)
+{
+    const size_t limit =
+      zmq::hugepage_pool_thread_cache_size / class_size (size_class_);
+    return limit < 2 ? 2 : limit;
+}
+}
+
+void *zmq::hugepage_pool_t::allocate (size_t size_, void *hint_)
+{
+    LIBZMQ_UNUSED (hint_);
+
+    if (size_ > max_block_size) {
+        const size_t length =
+          (header_size + size_ + region_size - 1) / region_size * region_size;
+        region_t *region = static_cast<region_t *> (map_region (length));
+        if (!region)
+            return NULL;
+        region->size_class = size_classes;
+        region->length = length;
+        return reinterpret_cast<unsigned char *> (region) + header_size;
+    }
+
+    const size_t size_class = size_class_of (size_ ? size_ : 1);
+    thread_cache_t *const cache = thread_cache ();
+    if (unlikely (!cache)) {
+        size_t taken;
+        return take_blocks (size_class, 1, &taken);
+    }
+
+    if (!cache->heads[size_class]) {
+        cache->heads[size_class] =
+          take_blocks (size_class, thread_cache_limit (size_class) / 2,
+                       &cache->counts[size_class]);
+        if (!cache->heads[size_class])
+            return NULL;
+    }
+    void *const block = cache->heads[size_class];
+    cache->heads[size_class] = *static_cast<void **> (block);
+    cache->counts[size_class]--;
+    return block;
+}
+
+void zmq::hugepage_pool_t::deallocate (void *ptr_, void *hint_)
+{
+    LIBZMQ_UNUSED (hint_);
+
+    if (!ptr_)
+        return;
+
+    region_t *region = region_of (ptr_);
+    if (region->size_class == size_classes) {
+        munmap (region, region->length);
+        return;
+    }
+
+    const size_t size_class = region->size_class;
+    thread_cache_t *const cache = thread_cache ();
+    if (unlikely (!cache)) {
+        *static_cast<void **> (ptr_) = NULL;
+        return_blocks (size_class, ptr_);
+        return;
+    }
+
+    const size_t limit = thread_cache_limit (size_class);
+    if (cache->counts[size_class] >= limit) {
+        void *const batch = cache->heads[size_class];
+        void *last = batch;
+        for (size_t i = 1; i < limit / 2; i++)
+            last = *static_cast<void **> (last);
+        cache->heads[size_class] = *static_cast<void **> (last);
+        *static_cast<void **> (last) = NULL;
+        cache->counts[size_class] -= limit / 2;
+        return_blocks (size_class, batch);
+    }
+    *static_cast<void **> (ptr_) = cache->heads[size_class];
+    cache->heads[size_class] = ptr_;
+    cache->counts[size_class]++;
+}
+
+#else
+
+void *zmq::hugepage_pool_t::allocate (size_t size_, void *hint_)
+{
+    LIBZMQ_UNUSED (hint_);
+    return malloc (size_);
+}
+
+void zmq::hugepage_pool_t::deallocate (void *ptr_, void *hint_)
+{
+    LIBZMQ_UNUSED (hint_);
+    free (ptr_);
+}
+
+#endif
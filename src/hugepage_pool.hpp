@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_HUGEPAGE_POOL_HPP_INCLUDED__
+#define __ZMQ_HUGEPAGE_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+namespace zmq
+{
+//  Process-wide pool of memory backed by 2 MB pages, used by contexts with
+//  ZMQ_HUGEPAGES set for pipe chunks, codec buffers and message content.
+//
+//  Memory is mapped in 2 MB regions, with MAP_HUGETLB if hugepages are
+//  reserved on the system and with MADV_HUGEPAGE otherwise, so that the
+//  kernel backs the region with a transparent hugepage where it can. Each
+//  region is carved into blocks of a single size class, with four classes
+//  per power of two. Each thread keeps a small cache of free blocks per
+//  class, which it fills from and empties into the regions half at a time
+//  under a lock per class. A region whose blocks have all been freed is
+//  unmapped, except for one per class kept for reuse. Blocks too large for
+//  a region get a mapping of their own, which is unmapped when they are
+//  freed. Blocks are aligned to 64 bytes.
+//
+//  On platforms without mmap the pool falls back to malloc and free.
+//
+//  The functions match zmq_alloc_fn and zmq_free_fn, the hint is ignored.
+//  Both are thread safe.
+
+class hugepage_pool_t
+{
+  public:
+    //  Returns NULL if memory is exhausted.
+    static void *allocate (size_t size_, void *hint_);
+
+    //  Releases a block returned by allocate. NULL is ignored.
+    static void deallocate (void *ptr_, void *hint_);
+};
+}
+
+#endif
@@ -19,7 +19,27 @@ class i_decoder
 
     virtual void get_buffer (unsigned char **data_, size_t *size_) = 0;
 
+    //  Like get_buffer, but may also return a second buffer for the data
+    //  that follows the first one, so that both can be filled with a single
+    //  read. The first buffer has to be filled completely before any data
+    //  goes to the second one, and each is passed to decode separately.
+    virtual void get_buffers (unsigned char **data_,
+                              size_t *size_,
+                              unsigned char **next_data_,
+                              size_t *next_size_)
+    {
+        get_buffer (data_, size_);
+        *next_data_ = NULL;
+        *next_size_ = 0;
+    }
+
     virtual void resize_buffer (size_t) = 0;
+
+    //  Frees the buffer returned by get_buffer, which must not hold any
+    //  data that was not decoded yet. It is allocated again by the next
+    //  call to get_buffer.
+    virtual void release_buffer () {}
+
     //  Decodes data pointed to by data_.
     //  When a message is decoded, 1 is returned.
     //  When the decoder needs more data, 0 is returned.
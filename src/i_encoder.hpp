@@ -25,6 +25,10 @@ struct i_encoder
 
     //  Load a new message into encoder.
     virtual void load_msg (msg_t *msg_) = 0;
+
+    //  Frees the buffer the encoder provides when no buffer is supplied to
+    //  encode. It is allocated again when next needed.
+    virtual void release_buffer () = 0;
 };
 }
 
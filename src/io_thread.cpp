@@ -11,6 +11,7 @@
 
 zmq::io_thread_t::io_thread_t (ctx_t *ctx_, uint32_t tid_) :
     object_t (ctx_, tid_),
+    _mailbox (ctx_->cmd_pipe_granularity ()),
     _mailbox_handle (static_cast<poller_t::handle_t> (NULL))
 {
     _poller = new (std::nothrow) poller_t (*ctx_);
@@ -4,7 +4,7 @@
 #include "mailbox.hpp"
 #include "err.hpp"
 
-zmq::mailbox_t::mailbox_t ()
+zmq::mailbox_t::mailbox_t (int granularity_) : _cpipe (granularity_)
 {
     //  Get the pipe into passive state. That way, if the users starts by
     //  polling on the associated file descriptor it will get woken up when
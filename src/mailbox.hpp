@@ -18,7 +18,7 @@ namespace zmq
 class mailbox_t ZMQ_FINAL : public i_mailbox
 {
   public:
-    mailbox_t ();
+    explicit mailbox_t (int granularity_ = command_pipe_granularity);
     ~mailbox_t ();
 
     fd_t get_fd () const;
@@ -7,7 +7,8 @@
 
 #include <algorithm>
 
-zmq::mailbox_safe_t::mailbox_safe_t (mutex_t *sync_) : _sync (sync_)
+zmq::mailbox_safe_t::mailbox_safe_t (mutex_t *sync_, int granularity_) :
+    _cpipe (granularity_), _sync (sync_)
 {
     //  Get the pipe into passive state. That way, if the users starts by
     //  polling on the associated file descriptor it will get woken up when
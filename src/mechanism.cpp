@@ -249,6 +249,8 @@ int zmq::mechanism_t::parse_metadata (const unsigned char *ptr_,
             const int rc = property (name, value, value_length);
             if (rc == -1)
                 return -1;
+            if (rc == 1)
+                continue;
         }
         (zap_flag_ ? _zap_properties : _zmtp_properties)
           .ZMQ_MAP_INSERT_OR_EMPLACE (
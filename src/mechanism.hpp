@@ -43,6 +43,10 @@ class mechanism_t
     //  Notifies mechanism about availability of ZAP message.
     virtual int zap_msg_available () { return 0; }
 
+    //  Notifies mechanism that the job it posted to the crypto pool
+    //  has run.
+    virtual int crypto_job_done () { return 0; }
+
     //  Returns the status of this mechanism.
     virtual status_t status () const = 0;
 
@@ -96,7 +100,9 @@ class mechanism_t
     //  parses a new property. The function should return 0
     //  on success and -1 on error, in which case it should
     //  set errno. Signaling error prevents parser from
-    //  parsing remaining data.
+    //  parsing remaining data. Returning 1 marks a property
+    //  of the mechanism itself, which is not passed on to the
+    //  application.
     //  Derived classes are supposed to override this
     //  method to handle custom processing.
     virtual int
@@ -13,6 +13,7 @@
 #include "likely.hpp"
 #include "metadata.hpp"
 #include "err.hpp"
+#include "allocator.hpp"
 
 //  Check whether the sizes of public representation of the message (zmq_msg_t)
 //  and private representation of the message (zmq::msg_t) match.
@@ -78,8 +79,8 @@ int zmq::msg_t::init_size (size_t size_)
         _u.lmsg.routing_id = 0;
         _u.lmsg.content = NULL;
         if (sizeof (content_t) + size_ > size_)
-            _u.lmsg.content =
-              static_cast<content_t *> (malloc (sizeof (content_t) + size_));
+            _u.lmsg.content = static_cast<content_t *> (
+              default_allocate (sizeof (content_t) + size_));
         if (unlikely (!_u.lmsg.content)) {
             errno = ENOMEM;
             return -1;
@@ -94,6 +95,35 @@ int zmq::msg_t::init_size (size_t size_)
     return 0;
 }
 
+//  Frees a block laid out by init_size with an allocator: a copy of the
+//  allocator, followed by the content and the data.
+static void free_allocated (void *, void *hint_)
+{
+    const zmq::allocator_t allocator = *static_cast<zmq::allocator_t *> (hint_);
+    zmq::deallocate (allocator, hint_);
+}
+
+int zmq::msg_t::init_size (size_t size_, const allocator_t &allocator_)
+{
+    if (size_ <= max_vsm_size || !allocator_.alloc_fn)
+        return init_size (size_);
+
+    const size_t header_size = sizeof (allocator_t) + sizeof (content_t);
+    void *block = NULL;
+    if (header_size + size_ > size_)
+        block = allocate (allocator_, header_size + size_);
+    if (unlikely (!block)) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    *static_cast<allocator_t *> (block) = allocator_;
+    content_t *content = reinterpret_cast<content_t *> (
+      static_cast<allocator_t *> (block) + 1);
+    return init_external_storage (content, content + 1, size_, free_allocated,
+                                  block);
+}
+
 int zmq::msg_t::init_buffer (const void *buf_, size_t size_)
 {
     const int rc = init_size (size_);
@@ -134,6 +164,12 @@ int zmq::msg_t::init_external_storage (content_t *content_,
     return 0;
 }
 
+int zmq::msg_t::init_static (const void *data_, size_t size_)
+{
+    //  A constant message never frees its data.
+    return init_data (const_cast<void *> (data_), size_, NULL, NULL);
+}
+
 int zmq::msg_t::init_data (void *data_,
                            size_t size_,
                            msg_free_fn *ffn_,
@@ -161,7 +197,7 @@ int zmq::msg_t::init_data (void *data_,
         _u.lmsg.group.type = group_type_short;
         _u.lmsg.routing_id = 0;
         _u.lmsg.content =
-          static_cast<content_t *> (malloc (sizeof (content_t)));
+          static_cast<content_t *> (default_allocate (sizeof (content_t)));
         if (!_u.lmsg.content) {
             errno = ENOMEM;
             return -1;
@@ -259,7 +295,7 @@ int zmq::msg_t::close ()
             if (_u.lmsg.content->ffn)
                 _u.lmsg.content->ffn (_u.lmsg.content->data,
                                       _u.lmsg.content->hint);
-            free (_u.lmsg.content);
+            default_deallocate (_u.lmsg.content);
         }
     }
 
@@ -607,7 +643,7 @@ bool zmq::msg_t::rm_refs (int refs_)
 
         if (_u.lmsg.content->ffn)
             _u.lmsg.content->ffn (_u.lmsg.content->data, _u.lmsg.content->hint);
-        free (_u.lmsg.content);
+        default_deallocate (_u.lmsg.content);
 
         return false;
     }
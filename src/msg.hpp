@@ -6,6 +6,7 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include "../include/zmq.h"
 #include "config.hpp"
 #include "err.hpp"
 #include "fd.hpp"
@@ -22,11 +23,17 @@ extern "C" {
 typedef void (msg_free_fn) (void *data_, void *hint_);
 }
 
+#if ZMQ_MSG_T_BYTES != 64 && ZMQ_MSG_T_BYTES != 128 && ZMQ_MSG_T_BYTES != 256
+#error ZMQ_MSG_T_BYTES must be 64, 128 or 256
+#endif
+
 namespace zmq
 {
 //  Note that this structure needs to be explicitly constructed
 //  (init functions) and destructed (close function).
 
+struct allocator_t;
+
 static const char cancel_cmd_name[] = "\6CANCEL";
 static const char sub_cmd_name[] = "\x9SUBSCRIBE";
 
@@ -76,7 +83,11 @@ class msg_t
               content_t *content_ = NULL);
 
     int init_size (size_t size_);
+    int init_size (size_t size_, const allocator_t &allocator_);
     int init_buffer (const void *buf_, size_t size_);
+    //  Refers to data that outlives all copies of the message. Copies are
+    //  plain struct copies, without any reference counting.
+    int init_static (const void *data_, size_t size_);
     int init_data (void *data_, size_t size_, msg_free_fn *ffn_, void *hint_);
     int init_external_storage (content_t *content_,
                                void *data_,
@@ -147,7 +158,7 @@ class msg_t
     //  rather than being reference-counted.
     enum
     {
-        msg_t_size = 64
+        msg_t_size = ZMQ_MSG_T_BYTES
     };
     enum
     {
@@ -0,0 +1,213 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "msg_pool.hpp"
+#include "atomic_counter.hpp"
+#include "atomic_ptr.hpp"
+#include "config.hpp"
+#include "err.hpp"
+#include "likely.hpp"
+
+#include <stdlib.h>
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <pthread.h>
+#define ZMQ_MSG_POOL_THREAD_CACHE
+#endif
+
+namespace
+{
+//  Every block starts with this header. While the block is free, next
+//  links it into a cache.
+struct block_t
+{
+    block_t *next;
+    size_t size_class;
+};
+
+//  Blocks, including their header, are rounded up to one of the sizes
+//  2^min_shift to 2^max_shift. Larger blocks have size class size_classes.
+const size_t min_shift = 7;
+const size_t max_shift = 17;
+const size_t size_classes = max_shift - min_shift + 1;
+
+size_t class_size (size_t size_class_)
+{
+    return static_cast<size_t> (1) << (size_class_ + min_shift);
+}
+
+size_t size_class_of (size_t size_)
+{
+    size_t size_class = 0;
+    while (size_class < size_classes && class_size (size_class) < size_)
+        size_class++;
+    return size_class;
+}
+
+#ifdef ZMQ_MSG_POOL_THREAD_CACHE
+
+//  Blocks returned by threads whose cache was full. Blocks are pushed one
+//  by one with CAS and taken all at once with an exchange, so that neither
+//  side is exposed to ABA.
+struct shared_list_t
+{
+    zmq::atomic_ptr_t<block_t> head;
+    zmq::atomic_counter_t count;
+};
+
+shared_list_t shared_lists[size_classes];
+
+void push_shared (block_t *block_)
+{
+    shared_list_t &list = shared_lists[block_->size_class];
+
+    //  The count is approximate under contention, which is good enough to
+    //  bound the memory held by the pool.
+    if (list.count.get () * class_size (block_->size_class)
+        >= zmq::msg_pool_shared_cache_size) {
+        free (block_);
+        return;
+    }
+    list.count.add (1);
+
+    block_t *head = NULL;
+    while (true) {
+        block_->next = head;
+        block_t *const old = list.head.cas (head, block_);
+        if (old == head)
+            break;
+        head = old;
+    }
+}
+
+block_t *take_shared (size_t size_class_, size_t *count_)
+{
+    shared_list_t &list = shared_lists[size_class_];
+    block_t *const blocks = list.head.xchg (NULL);
+    size_t count = 0;
+    for (const block_t *block = blocks; block; block = block->next)
+        count++;
+    if (count)
+        list.count.sub (static_cast<zmq::atomic_counter_t::integer_t> (count));
+    *count_ = count;
+    return blocks;
+}
+
+struct thread_cache_t
+{
+    block_t *heads[size_classes];
+    size_t counts[size_classes];
+};
+
+pthread_key_t cache_key;
+pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+//  Runs when a thread that used the pool exits.
+void release_thread_cache (void *cache_)
+{
+    thread_cache_t *const cache = static_cast<thread_cache_t *> (cache_);
+    for (size_t size_class = 0; size_class < size_classes; size_class++) {
+        while (cache->heads[size_class]) {
+            block_t *const block = cache->heads[size_class];
+            cache->heads[size_class] = block->next;
+            push_shared (block);
+        }
+    }
+    free (cache);
+}
+
+void create_cache_key ()
+{
+    const int rc = pthread_key_create (&cache_key, release_thread_cache);
+    posix_assert (rc);
+}
+
+//  Returns NULL if the cache could not be allocated.
+thread_cache_t *thread_cache ()
+{
+    int rc = pthread_once (&cache_key_once, create_cache_key);
+    posix_assert (rc);
+
+    thread_cache_t *cache =
+      static_cast<thread_cache_t *> (pthread_getspecific (cache_key));
+    if (unlikely (!cache)) {
+        cache =
+          static_cast<thread_cache_t *> (calloc (1, sizeof (thread_cache_t)));
+        if (!cache)
+            return NULL;
+        rc = pthread_setspecific (cache_key, cache);
+        if (rc != 0) {
+            free (cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+size_t thread_cache_limit (size_t size_class_)
+{
+    const size_t limit =
+      zmq::msg_pool_thread_cache_size / class_size (size_class_);
+    return limit < 4 ? 4 : limit;
+}
+
+#endif
+}
+
+void *zmq::msg_pool_t::allocate (size_t size_)
+{
+    const size_t size = sizeof (block_t) + size_;
+    if (unlikely (size < size_))
+        return NULL;
+    const size_t size_class = size_class_of (size);
+
+    block_t *block = NULL;
+#ifdef ZMQ_MSG_POOL_THREAD_CACHE
+    if (size_class < size_classes) {
+        thread_cache_t *const cache = thread_cache ();
+        if (likely (cache != NULL)) {
+            if (!cache->heads[size_class])
+                cache->heads[size_class] =
+                  take_shared (size_class, &cache->counts[size_class]);
+            block = cache->heads[size_class];
+            if (block) {
+                cache->heads[size_class] = block->next;
+                cache->counts[size_class]--;
+            }
+        }
+    }
+#endif
+
+    if (!block) {
+        block = static_cast<block_t *> (
+          malloc (size_class < size_classes ? class_size (size_class) : size));
+        if (unlikely (!block))
+            return NULL;
+        block->size_class = size_class;
+    }
+    return block + 1;
+}
+
+void zmq::msg_pool_t::deallocate (void *ptr_)
+{
+    if (!ptr_)
+        return;
+    block_t *const block = static_cast<block_t *> (ptr_) - 1;
+
+#ifdef ZMQ_MSG_POOL_THREAD_CACHE
+    const size_t size_class = block->size_class;
+    if (size_class < size_classes) {
+        thread_cache_t *const cache = thread_cache ();
+        if (likely (cache != NULL)
+            && cache->counts[size_class] < thread_cache_limit (size_class)) {
+            block->next = cache->heads[size_class];
+            cache->heads[size_class] = block;
+            cache->counts[size_class]++;
+        } else
+            push_shared (block);
+        return;
+    }
+#endif
+
+    free (block);
+}
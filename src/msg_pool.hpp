@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_MSG_POOL_HPP_INCLUDED__
+#define __ZMQ_MSG_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+namespace zmq
+{
+//  Process-wide pool for message content and codec buffers.
+//
+//  Blocks are rounded up to power-of-two size classes. Each thread keeps
+//  a small cache of free blocks per class, so allocating and freeing on
+//  the same thread takes no locks and no atomic operations. A thread whose
+//  cache is full returns blocks to a shared list per class with a single
+//  CAS; a thread whose cache is empty takes that whole list with a single
+//  exchange. This suits the typical pattern of messages allocated on one
+//  thread and freed on another. Blocks larger than the largest class, and
+//  all blocks on platforms without thread-specific storage, go straight
+//  to malloc and free.
+//
+//  Both functions are thread safe.
+
+class msg_pool_t
+{
+  public:
+    //  Returns NULL if memory is exhausted.
+    static void *allocate (size_t size_);
+
+    //  Releases a block returned by allocate. NULL is ignored.
+    static void deallocate (void *ptr_);
+};
+}
+
+#endif
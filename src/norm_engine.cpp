@@ -35,7 +35,7 @@ zmq::norm_engine_t::norm_engine_t (io_thread_t *parent_,
     norm_session (NORM_SESSION_INVALID),
     is_sender (false),
     is_receiver (false),
-    zmq_encoder (0),
+    zmq_encoder (0, options_.allocator),
     norm_tx_stream (NORM_OBJECT_INVALID),
     tx_first_msg (true),
     tx_more_bit (false),
@@ -498,7 +498,7 @@ void zmq::norm_engine_t::recv_data (NormObjectHandle object)
             // This is a new stream, so create rxState with zmq decoder, etc
             rxState = new (std::nothrow)
               NormRxStreamState (object, options.maxmsgsize, options.zero_copy,
-                                 options.in_batch_size);
+                                 options.in_batch_size, options.allocator);
             errno_assert (rxState);
 
             if (!rxState->Init ()) {
@@ -641,11 +641,13 @@ zmq::norm_engine_t::NormRxStreamState::NormRxStreamState (
   NormObjectHandle normStream,
   int64_t maxMsgSize,
   bool zeroCopy,
-  int inBatchSize) :
+  int inBatchSize,
+  const allocator_t &allocHooks) :
     norm_stream (normStream),
     max_msg_size (maxMsgSize),
     zero_copy (zeroCopy),
     in_batch_size (inBatchSize),
+    allocator (allocHooks),
     in_sync (false),
     rx_ready (false),
     zmq_decoder (NULL),
@@ -678,7 +680,8 @@ bool zmq::norm_engine_t::NormRxStreamState::Init ()
     if (NULL != zmq_decoder)
         delete zmq_decoder;
     zmq_decoder =
-      new (std::nothrow) v2_decoder_t (in_batch_size, max_msg_size, zero_copy);
+      new (std::nothrow)
+      v2_decoder_t (in_batch_size, max_msg_size, zero_copy, allocator);
     alloc_assert (zmq_decoder);
     if (NULL != zmq_decoder) {
         buffer_count = 0;
@@ -79,7 +79,8 @@ class norm_engine_t ZMQ_FINAL : public io_object_t, public i_engine
         NormRxStreamState (NormObjectHandle normStream,
                            int64_t maxMsgSize,
                            bool zeroCopy,
-                           int inBatchSize);
+                           int inBatchSize,
+                           const allocator_t &allocHooks);
         ~NormRxStreamState ();
 
         NormObjectHandle GetStreamHandle () const { return norm_stream; }
@@ -145,6 +146,7 @@ class norm_engine_t ZMQ_FINAL : public io_object_t, public i_engine
         int64_t max_msg_size;
         bool zero_copy;
         int in_batch_size;
+        allocator_t allocator;
         bool in_sync;
         bool rx_ready;
         v2_decoder_t *zmq_decoder;
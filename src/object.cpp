@@ -48,7 +48,8 @@ void zmq::object_t::process_command (const command_t &cmd_)
             break;
 
         case command_t::activate_write:
-            process_activate_write (cmd_.args.activate_write.msgs_read);
+            process_activate_write (cmd_.args.activate_write.msgs_read,
+                                    cmd_.args.activate_write.bytes_read);
             break;
 
         case command_t::stop:
@@ -137,6 +138,10 @@ void zmq::object_t::process_command (const command_t &cmd_)
             process_conn_failed ();
             break;
 
+        case command_t::resolved:
+            process_resolved (cmd_.args.resolved.error);
+            break;
+
         case command_t::done:
         default:
             zmq_assert (false);
@@ -264,12 +269,14 @@ void zmq::object_t::send_activate_read (pipe_t *destination_)
 }
 
 void zmq::object_t::send_activate_write (pipe_t *destination_,
-                                         uint64_t msgs_read_)
+                                         uint64_t msgs_read_,
+                                         uint64_t bytes_read_)
 {
     command_t cmd;
     cmd.destination = destination_;
     cmd.type = command_t::activate_write;
     cmd.args.activate_write.msgs_read = msgs_read_;
+    cmd.args.activate_write.bytes_read = bytes_read_;
     send_command (cmd);
 }
 
@@ -438,7 +445,7 @@ void zmq::object_t::process_activate_read ()
     zmq_assert (false);
 }
 
-void zmq::object_t::process_activate_write (uint64_t)
+void zmq::object_t::process_activate_write (uint64_t, uint64_t)
 {
     zmq_assert (false);
 }
@@ -517,6 +524,11 @@ void zmq::object_t::process_conn_failed ()
     zmq_assert (false);
 }
 
+void zmq::object_t::process_resolved (int)
+{
+    zmq_assert (false);
+}
+
 void zmq::object_t::send_command (const command_t &cmd_)
 {
     _ctx->send_command (cmd_.destination->get_tid (), cmd_);
@@ -70,7 +70,9 @@ class object_t
                       zmq::i_engine *engine_,
                       bool inc_seqnum_ = true);
     void send_activate_read (zmq::pipe_t *destination_);
-    void send_activate_write (zmq::pipe_t *destination_, uint64_t msgs_read_);
+    void send_activate_write (zmq::pipe_t *destination_,
+                              uint64_t msgs_read_,
+                              uint64_t bytes_read_);
     void send_hiccup (zmq::pipe_t *destination_, void *pipe_);
     void send_pipe_peer_stats (zmq::pipe_t *destination_,
                                uint64_t queue_count_,
@@ -101,7 +103,8 @@ class object_t
     virtual void process_attach (zmq::i_engine *engine_);
     virtual void process_bind (zmq::pipe_t *pipe_);
     virtual void process_activate_read ();
-    virtual void process_activate_write (uint64_t msgs_read_);
+    virtual void process_activate_write (uint64_t msgs_read_,
+                                         uint64_t bytes_read_);
     virtual void process_hiccup (void *pipe_);
     virtual void process_pipe_peer_stats (uint64_t queue_count_,
                                           zmq::own_t *socket_base_,
@@ -120,6 +123,7 @@ class object_t
     virtual void process_reap (zmq::socket_base_t *socket_);
     virtual void process_reaped ();
     virtual void process_conn_failed ();
+    virtual void process_resolved (int error_);
 
 
     //  Special handler called after a command that requires a seqnum
@@ -9,6 +9,10 @@
 #include "err.hpp"
 #include "macros.hpp"
 
+#if defined ZMQ_HAVE_CURVE && defined ZMQ_USE_LIBSODIUM
+#include "sodium.h"
+#endif
+
 #ifndef ZMQ_HAVE_WINDOWS
 #include <net/if.h>
 #endif
@@ -209,13 +213,20 @@ zmq::options_t::options_t () :
     gss_plaintext (false),
     socket_id (0),
     conflate (false),
+    conflate_key_size (0),
+    sndhwm_bytes (0),
+    rcvhwm_bytes (0),
     handshake_ivl (30000),
+    zmtp_v3_only (false),
+    tcp_fastopen (false),
     connected (false),
     heartbeat_ttl (0),
     heartbeat_interval (0),
     heartbeat_timeout (-1),
     use_fd (-1),
     zap_enforce_domain (false),
+    zap_cache_ttl (0),
+    zap_cache_size (1000),
     loopback_fastpath (false),
     multicast_loop (true),
     in_batch_size (8192),
@@ -224,6 +235,10 @@ zmq::options_t::options_t () :
     router_notify (0),
     monitor_event_version (1),
     wss_trust_system (false),
+    ws_deflate (false),
+    ws_deflate_threshold (64),
+    ws_deflate_no_context_takeover (false),
+    ws_fragment_size (0),
     hello_msg (),
     can_send_hello_msg (false),
     disconnect_msg (),
@@ -243,6 +258,12 @@ zmq::options_t::options_t () :
     memset (curve_public_key, 0, CURVE_KEYSIZE);
     memset (curve_secret_key, 0, CURVE_KEYSIZE);
     memset (curve_server_key, 0, CURVE_KEYSIZE);
+    curve_ticket_lifetime = 0;
+    memset (curve_ticket_key, 0, CURVE_KEYSIZE);
+    curve_cipher = ZMQ_CURVE_CIPHER_XSALSA20POLY1305;
+    allocator.alloc_fn = NULL;
+    allocator.free_fn = NULL;
+    allocator.hint = NULL;
 #if defined ZMQ_HAVE_VMCI
     vmci_buffer_size = 0;
     vmci_buffer_min_size = 0;
@@ -621,6 +642,25 @@ int zmq::options_t::setsockopt (int option_,
                 return 0;
             }
             break;
+
+        case ZMQ_CURVE_TICKET_LIFETIME:
+            if (is_int && value >= 0) {
+                curve_ticket_lifetime = value;
+                //  Tickets issued under the previous key are void.
+                if (value > 0)
+                    randombytes (curve_ticket_key, CURVE_KEYSIZE);
+                return 0;
+            }
+            break;
+
+        case ZMQ_CURVE_CIPHER:
+            if (is_int
+                && (value == ZMQ_CURVE_CIPHER_XSALSA20POLY1305
+                    || value == ZMQ_CURVE_CIPHER_AES256GCM)) {
+                curve_cipher = value;
+                return 0;
+            }
+            break;
 #endif
 
         case ZMQ_CONFLATE:
@@ -687,6 +727,14 @@ int zmq::options_t::setsockopt (int option_,
             }
             break;
 
+        case ZMQ_ZMTP_V3_ONLY:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &zmtp_v3_only);
+
+        case ZMQ_TCP_FASTOPEN:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &tcp_fastopen);
+
         case ZMQ_INVERT_MATCHING:
             return do_setsockopt_int_as_bool_relaxed (optval_, optvallen_,
                                                       &invert_matching);
@@ -743,6 +791,20 @@ int zmq::options_t::setsockopt (int option_,
             return do_setsockopt_int_as_bool_relaxed (optval_, optvallen_,
                                                       &zap_enforce_domain);
 
+        case ZMQ_ZAP_CACHE_TTL:
+            if (is_int && value >= 0) {
+                zap_cache_ttl = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ZAP_CACHE_SIZE:
+            if (is_int && value > 0) {
+                zap_cache_size = value;
+                return 0;
+            }
+            break;
+
         case ZMQ_LOOPBACK_FASTPATH:
             return do_setsockopt_int_as_bool_relaxed (optval_, optvallen_,
                                                       &loopback_fastpath);
@@ -792,6 +854,19 @@ int zmq::options_t::setsockopt (int option_,
                 return 0;
             }
             break;
+
+        case ZMQ_CONFLATE_KEY_SIZE:
+            if (is_int && value >= 0) {
+                conflate_key_size = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_SNDHWM_BYTES:
+            return do_setsockopt (optval_, optvallen_, &sndhwm_bytes);
+
+        case ZMQ_RCVHWM_BYTES:
+            return do_setsockopt (optval_, optvallen_, &rcvhwm_bytes);
 #ifdef ZMQ_HAVE_WSS
         case ZMQ_WSS_KEY_PEM:
             // TODO: check if valid certificate
@@ -812,6 +887,30 @@ int zmq::options_t::setsockopt (int option_,
             return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
                                                      &wss_trust_system);
 #endif
+#ifdef ZMQ_HAVE_WS_DEFLATE
+        case ZMQ_WS_DEFLATE:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &ws_deflate);
+
+        case ZMQ_WS_DEFLATE_THRESHOLD:
+            if (is_int && value >= 0) {
+                ws_deflate_threshold = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_WS_DEFLATE_NO_CONTEXT_TAKEOVER:
+            return do_setsockopt_int_as_bool_strict (
+              optval_, optvallen_, &ws_deflate_no_context_takeover);
+#endif
+#ifdef ZMQ_HAVE_WS
+        case ZMQ_WS_FRAGMENT_SIZE:
+            if (is_int && value >= 0) {
+                ws_fragment_size = value;
+                return 0;
+            }
+            break;
+#endif
 
 #ifdef ZMQ_HAVE_NORM
         case ZMQ_NORM_MODE:
@@ -1199,6 +1298,20 @@ int zmq::options_t::getsockopt (int option_,
         case ZMQ_CURVE_SERVERKEY:
             return do_getsockopt_curve_key (optval_, optvallen_,
                                             curve_server_key);
+
+        case ZMQ_CURVE_TICKET_LIFETIME:
+            if (is_int) {
+                *value = curve_ticket_lifetime;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CURVE_CIPHER:
+            if (is_int) {
+                *value = curve_cipher;
+                return 0;
+            }
+            break;
 #endif
 
         case ZMQ_CONFLATE:
@@ -1251,6 +1364,20 @@ int zmq::options_t::getsockopt (int option_,
             }
             break;
 
+        case ZMQ_ZMTP_V3_ONLY:
+            if (is_int) {
+                *value = zmtp_v3_only;
+                return 0;
+            }
+            break;
+
+        case ZMQ_TCP_FASTOPEN:
+            if (is_int) {
+                *value = tcp_fastopen;
+                return 0;
+            }
+            break;
+
         case ZMQ_INVERT_MATCHING:
             if (is_int) {
                 *value = invert_matching;
@@ -1297,6 +1424,20 @@ int zmq::options_t::getsockopt (int option_,
             }
             break;
 
+        case ZMQ_ZAP_CACHE_TTL:
+            if (is_int) {
+                *value = zap_cache_ttl;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ZAP_CACHE_SIZE:
+            if (is_int) {
+                *value = zap_cache_size;
+                return 0;
+            }
+            break;
+
         case ZMQ_LOOPBACK_FASTPATH:
             if (is_int) {
                 *value = loopback_fastpath;
@@ -1346,6 +1487,59 @@ int zmq::options_t::getsockopt (int option_,
             }
             break;
 
+        case ZMQ_CONFLATE_KEY_SIZE:
+            if (is_int) {
+                *value = conflate_key_size;
+                return 0;
+            }
+            break;
+
+        case ZMQ_SNDHWM_BYTES:
+            if (*optvallen_ == sizeof (uint64_t)) {
+                *(static_cast<uint64_t *> (optval_)) = sndhwm_bytes;
+                return 0;
+            }
+            break;
+
+        case ZMQ_RCVHWM_BYTES:
+            if (*optvallen_ == sizeof (uint64_t)) {
+                *(static_cast<uint64_t *> (optval_)) = rcvhwm_bytes;
+                return 0;
+            }
+            break;
+
+#ifdef ZMQ_HAVE_WS_DEFLATE
+        case ZMQ_WS_DEFLATE:
+            if (is_int) {
+                *value = ws_deflate;
+                return 0;
+            }
+            break;
+
+        case ZMQ_WS_DEFLATE_THRESHOLD:
+            if (is_int) {
+                *value = ws_deflate_threshold;
+                return 0;
+            }
+            break;
+
+        case ZMQ_WS_DEFLATE_NO_CONTEXT_TAKEOVER:
+            if (is_int) {
+                *value = ws_deflate_no_context_takeover;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_HAVE_WS
+        case ZMQ_WS_FRAGMENT_SIZE:
+            if (is_int) {
+                *value = ws_fragment_size;
+                return 0;
+            }
+            break;
+#endif
+
 #ifdef ZMQ_HAVE_NORM
         case ZMQ_NORM_MODE:
             if (is_int) {
@@ -7,6 +7,7 @@
 #include <vector>
 #include <map>
 
+#include "allocator.hpp"
 #include "atomic_ptr.hpp"
 #include "stddef.h"
 #include "stdint.hpp"
@@ -186,6 +187,16 @@ struct options_t
     uint8_t curve_secret_key[CURVE_KEYSIZE];
     uint8_t curve_server_key[CURVE_KEYSIZE];
 
+    //  How long, in milliseconds, a CURVE server's resumption tickets
+    //  are valid, and the key it seals them with. On a client, any value
+    //  above 0 asks for tickets and resumes sessions with them.
+    int curve_ticket_lifetime;
+    uint8_t curve_ticket_key[CURVE_KEYSIZE];
+
+    //  Cipher to seal CURVE messages with, if the peer and the CPU
+    //  support it, one of ZMQ_CURVE_CIPHER_*.
+    int curve_cipher;
+
     //  Principals for GSSAPI mechanism
     std::string gss_principal;
     std::string gss_service_principal;
@@ -206,10 +217,27 @@ struct options_t
     //  Ignores hwm
     bool conflate;
 
+    //  If non-zero and conflate is set, the last message is kept per key,
+    //  the key being the first conflate_key_size bytes of the message.
+    int conflate_key_size;
+
+    //  High-water marks for message outbound/inbound pipes in bytes of
+    //  message body. 0 means no byte limit, only sndhwm/rcvhwm apply.
+    uint64_t sndhwm_bytes;
+    uint64_t rcvhwm_bytes;
+
     //  If connection handshake is not done after this many milliseconds,
     //  close socket.  Default is 30 secs.  0 means no handshake timeout.
     int handshake_ivl;
 
+    //  If true, peers speaking ZMTP/1.0 or ZMTP/2.0 are refused, so that
+    //  the whole greeting and the first handshake command can be sent
+    //  without waiting for the peer's version.
+    bool zmtp_v3_only;
+
+    //  If true, TCP Fast Open is enabled on listeners and connecters.
+    bool tcp_fastopen;
+
     bool connected;
     //  If remote peer receives a PING message and doesn't receive another
     //  message within the ttl value, it should close the connection
@@ -238,6 +266,12 @@ struct options_t
     //  Enforce a non-empty ZAP domain requirement for PLAIN auth
     bool zap_enforce_domain;
 
+    //  How long, in milliseconds, the replies of the ZAP handler are
+    //  reused for the same request, 0 to always ask the handler, and how
+    //  many of them the socket keeps at most.
+    int zap_cache_ttl;
+    int zap_cache_size;
+
     // Use of loopback fastpath.
     bool loopback_fastpath;
 
@@ -258,6 +292,9 @@ struct options_t
     // Use zero copy strategy for storing message content when decoding.
     bool zero_copy;
 
+    //  Memory allocation hooks of the context, used by the engines.
+    allocator_t allocator;
+
     // Router socket ZMQ_NOTIFY_CONNECT/ZMQ_NOTIFY_DISCONNECT notifications
     int router_notify;
 
@@ -274,6 +311,17 @@ struct options_t
     std::string wss_hostname;
     bool wss_trust_system;
 
+    //  permessage-deflate compression of WebSocket messages: whether to
+    //  offer or accept it, the smallest message body worth compressing
+    //  and whether to compress every message on its own.
+    bool ws_deflate;
+    int ws_deflate_threshold;
+    bool ws_deflate_no_context_takeover;
+
+    //  Largest payload of a WebSocket frame sent, longer messages are
+    //  split into continuation frames. 0 sends every message in one frame.
+    int ws_fragment_size;
+
     //  Hello msg
     std::vector<unsigned char> hello_msg;
     bool can_send_hello_msg;
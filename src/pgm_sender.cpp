@@ -20,7 +20,7 @@ zmq::pgm_sender_t::pgm_sender_t (io_thread_t *parent_,
     has_tx_timer (false),
     has_rx_timer (false),
     session (NULL),
-    encoder (0),
+    encoder (0, options_.allocator),
     more_flag (false),
     pgm_socket (false, options_),
     options (options_),
@@ -7,40 +7,35 @@
 #include "macros.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
+#include "ctx.hpp"
+#include "spill_file.hpp"
 
 #include "ypipe.hpp"
 #include "ypipe_conflate.hpp"
+#include "ypipe_conflate_keyed.hpp"
 
 int zmq::pipepair (object_t *parents_[2],
                    pipe_t *pipes_[2],
                    const int hwms_[2],
-                   const bool conflate_[2])
+                   const bool conflate_[2],
+                   int conflate_key_size_)
 {
     //   Creates two pipe objects. These objects are connected by two ypipes,
     //   each to pass messages in one direction.
 
-    typedef ypipe_t<msg_t, message_pipe_granularity> upipe_normal_t;
-    typedef ypipe_conflate_t<msg_t> upipe_conflate_t;
-
-    pipe_t::upipe_t *upipe1;
-    if (conflate_[0])
-        upipe1 = new (std::nothrow) upipe_conflate_t ();
-    else
-        upipe1 = new (std::nothrow) upipe_normal_t ();
-    alloc_assert (upipe1);
-
-    pipe_t::upipe_t *upipe2;
-    if (conflate_[1])
-        upipe2 = new (std::nothrow) upipe_conflate_t ();
-    else
-        upipe2 = new (std::nothrow) upipe_normal_t ();
-    alloc_assert (upipe2);
+    ctx_t *const ctx = parents_[0]->get_ctx ();
+    pipe_t::upipe_t *upipe1 =
+      pipe_t::create_upipe (conflate_[0], conflate_key_size_, ctx);
+    pipe_t::upipe_t *upipe2 =
+      pipe_t::create_upipe (conflate_[1], conflate_key_size_, ctx);
 
     pipes_[0] = new (std::nothrow)
-      pipe_t (parents_[0], upipe1, upipe2, hwms_[1], hwms_[0], conflate_[0]);
+      pipe_t (parents_[0], upipe1, upipe2, hwms_[1], hwms_[0], conflate_[0],
+              conflate_key_size_);
     alloc_assert (pipes_[0]);
     pipes_[1] = new (std::nothrow)
-      pipe_t (parents_[1], upipe2, upipe1, hwms_[0], hwms_[1], conflate_[1]);
+      pipe_t (parents_[1], upipe2, upipe1, hwms_[0], hwms_[1], conflate_[1],
+              conflate_key_size_);
     alloc_assert (pipes_[1]);
 
     pipes_[0]->set_peer (pipes_[1]);
@@ -77,7 +72,8 @@ zmq::pipe_t::pipe_t (object_t *parent_,
                      upipe_t *outpipe_,
                      int inhwm_,
                      int outhwm_,
-                     bool conflate_) :
+                     bool conflate_,
+                     int conflate_key_size_) :
     object_t (parent_),
     _in_pipe (inpipe_),
     _out_pipe (outpipe_),
@@ -87,21 +83,39 @@ zmq::pipe_t::pipe_t (object_t *parent_,
     _lwm (compute_lwm (inhwm_)),
     _in_hwm_boost (-1),
     _out_hwm_boost (-1),
+    _hwm_bytes (0),
+    _lwm_bytes (0),
     _msgs_read (0),
     _msgs_written (0),
+    _bytes_read (0),
+    _bytes_written (0),
+    _bytes_in_msg (0),
+    _bytes_read_sent (0),
     _peers_msgs_read (0),
+    _peers_bytes_read (0),
     _peer (NULL),
     _sink (NULL),
     _state (active),
     _delay (true),
     _server_socket_routing_id (0),
-    _conflate (conflate_)
+    _conflate (conflate_),
+    _conflate_key_size (conflate_key_size_),
+    _count_queued_bytes_out (false),
+    _count_queued_bytes_in (false),
+    _queued_bytes_delta (0),
+    _spill (NULL),
+    _out_more (false),
+    _spilling (false),
+    _spill_failed (false)
 {
     _disconnect_msg.init ();
 }
 
 zmq::pipe_t::~pipe_t ()
 {
+    if (_queued_bytes_delta != 0)
+        get_ctx ()->add_queued_bytes (_queued_bytes_delta);
+    LIBZMQ_DELETE (_spill);
     _disconnect_msg.close ();
 }
 
@@ -195,11 +209,16 @@ bool zmq::pipe_t::read (msg_t *msg_)
         return false;
     }
 
+    const size_t size = payload_size (*msg_);
+    _bytes_read += size;
+    if (_count_queued_bytes_in)
+        count_queued_bytes (-static_cast<int64_t> (size));
     if (!(msg_->flags () & msg_t::more) && !msg_->is_routing_id ())
         _msgs_read++;
 
-    if (_lwm > 0 && _msgs_read % _lwm == 0)
-        send_activate_write (_peer, _msgs_read);
+    if ((_lwm > 0 && _msgs_read % _lwm == 0)
+        || (_lwm_bytes > 0 && _bytes_read - _bytes_read_sent >= _lwm_bytes))
+        send_credit ();
 
     return true;
 }
@@ -209,7 +228,8 @@ bool zmq::pipe_t::check_write ()
     if (unlikely (!_out_active || _state != active))
         return false;
 
-    const bool full = !check_hwm ();
+    //  With a spill file the pipe never fills up, overflow goes to disk.
+    const bool full = !check_hwm () && !_spill;
 
     if (unlikely (full)) {
         _out_active = false;
@@ -224,22 +244,74 @@ bool zmq::pipe_t::write (const msg_t *msg_)
     if (unlikely (!check_write ()))
         return false;
 
+    if (unlikely (_spill != NULL)) {
+        const bool more = (msg_->flags () & msg_t::more) != 0;
+
+        //  Whole messages go either to the pipe or to the spill file. Once
+        //  something is spilled, newer messages follow it there so that
+        //  ordering is kept.
+        if (!_out_more) {
+            replay_spill ();
+            _spilling = !_spill->empty () || !check_hwm ();
+        }
+        _out_more = more;
+
+        if (_spilling) {
+            //  On a disk error the message is dropped, as it would be
+            //  without a spill file. The file has dropped the frames it
+            //  held, the message's earlier ones among them, so the rest
+            //  of the message must not start a new file.
+            if (!_spill_failed && _spill->write (*msg_) != 0)
+                _spill_failed = true;
+            if (!more)
+                _spill_failed = false;
+            msg_t &msg = const_cast<msg_t &> (*msg_);
+            int rc = msg.close ();
+            errno_assert (rc == 0);
+            rc = msg.init ();
+            errno_assert (rc == 0);
+            return true;
+        }
+    }
+
+    do_write (msg_);
+    return true;
+}
+
+void zmq::pipe_t::do_write (const msg_t *msg_)
+{
     const bool more = (msg_->flags () & msg_t::more) != 0;
     const bool is_routing_id = msg_->is_routing_id ();
+    const size_t size = payload_size (*msg_);
+    _bytes_in_msg += size;
+    if (_count_queued_bytes_out)
+        count_queued_bytes (static_cast<int64_t> (size));
     _out_pipe->write (*msg_, more);
-    if (!more && !is_routing_id)
+    if (!more && !is_routing_id) {
         _msgs_written++;
-
-    return true;
+        _bytes_written += _bytes_in_msg;
+        _bytes_in_msg = 0;
+    }
 }
 
-void zmq::pipe_t::rollback () const
+void zmq::pipe_t::rollback ()
 {
+    _bytes_in_msg = 0;
+
+    //  Parts of a spilled message can't be taken back from the file, so
+    //  its content is dropped rather than replaying a truncated message.
+    if (_spilling && _out_more)
+        _spill->clear ();
+    _out_more = false;
+    _spill_failed = false;
+
     //  Remove incomplete message from the outbound pipe.
     msg_t msg;
     if (_out_pipe) {
         while (_out_pipe->unwrite (&msg)) {
             zmq_assert (msg.flags () & msg_t::more);
+            if (_count_queued_bytes_out)
+                count_queued_bytes (-static_cast<int64_t> (payload_size (msg)));
             const int rc = msg.close ();
             errno_assert (rc == 0);
         }
@@ -264,10 +336,15 @@ void zmq::pipe_t::process_activate_read ()
     }
 }
 
-void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
+void zmq::pipe_t::process_activate_write (uint64_t msgs_read_,
+                                          uint64_t bytes_read_)
 {
     //  Remember the peer's message sequence number.
     _peers_msgs_read = msgs_read_;
+    _peers_bytes_read = bytes_read_;
+
+    if (_spill && !_out_more && _state == active)
+        replay_spill ();
 
     if (!_out_active && _state == active) {
         _out_active = true;
@@ -275,6 +352,46 @@ void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
     }
 }
 
+void zmq::pipe_t::replay_spill ()
+{
+    bool replayed = false;
+    while (!_spill->empty () && check_hwm ()) {
+        //  Move the oldest spilled message back into the pipe.
+        bool more = true;
+        bool started = false;
+        while (more) {
+            msg_t msg;
+            int rc = msg.init ();
+            errno_assert (rc == 0);
+            if (unlikely (_spill->read (&msg) != 0)) {
+                //  The rest of the spill file is lost. Terminate the
+                //  message so that the reader doesn't get a truncated one.
+                rc = msg.close ();
+                errno_assert (rc == 0);
+                if (started) {
+                    rc = msg.init ();
+                    errno_assert (rc == 0);
+                    do_write (&msg);
+                }
+                break;
+            }
+            more = (msg.flags () & msg_t::more) != 0;
+            do_write (&msg);
+            started = true;
+            replayed = true;
+        }
+    }
+    if (replayed)
+        flush ();
+}
+
+void zmq::pipe_t::set_spill_dir (const std::string &dir_)
+{
+    zmq_assert (!_spill);
+    _spill = new (std::nothrow) spill_file_t (dir_);
+    alloc_assert (_spill);
+}
+
 void zmq::pipe_t::process_hiccup (void *pipe_)
 {
     //  Destroy old outpipe. Note that the read end of the pipe was already
@@ -282,12 +399,32 @@ void zmq::pipe_t::process_hiccup (void *pipe_)
     zmq_assert (_out_pipe);
     _out_pipe->flush ();
     msg_t msg;
+    uint64_t bytes_in_msg = 0;
     while (_out_pipe->read (&msg)) {
-        if (!(msg.flags () & msg_t::more))
+        const size_t size = payload_size (msg);
+        bytes_in_msg += size;
+        if (!(msg.flags () & msg_t::more)) {
             _msgs_written--;
+            //  Bytes are added to _bytes_written per message, so they are
+            //  taken back the same way, clamped as the context's count is.
+            _bytes_written -= std::min (bytes_in_msg, _bytes_written);
+            bytes_in_msg = 0;
+        }
+        if (_count_queued_bytes_out)
+            count_queued_bytes (-static_cast<int64_t> (size));
+        const int rc = msg.close ();
+        errno_assert (rc == 0);
+    }
+
+    //  The frames of a message still being written never made it into
+    //  _bytes_written, and go with the old pipe.
+    while (_out_pipe->unwrite (&msg)) {
+        if (_count_queued_bytes_out)
+            count_queued_bytes (-static_cast<int64_t> (payload_size (msg)));
         const int rc = msg.close ();
         errno_assert (rc == 0);
     }
+    _bytes_in_msg = 0;
     LIBZMQ_DELETE (_out_pipe);
 
     //  Plug in the new outpipe.
@@ -363,6 +500,8 @@ void zmq::pipe_t::process_pipe_term_ack ()
     if (!_conflate) {
         msg_t msg;
         while (_in_pipe->read (&msg)) {
+            if (_count_queued_bytes_in)
+                count_queued_bytes (-static_cast<int64_t> (payload_size (msg)));
             const int rc = msg.close ();
             errno_assert (rc == 0);
         }
@@ -472,6 +611,48 @@ int zmq::pipe_t::compute_lwm (int hwm_)
     return result;
 }
 
+zmq::pipe_t::upipe_t *zmq::pipe_t::create_upipe (bool conflate_,
+                                                  int conflate_key_size_,
+                                                  ctx_t *ctx_)
+{
+    upipe_t *upipe;
+    if (conflate_ && conflate_key_size_ > 0)
+        upipe = new (std::nothrow)
+          ypipe_conflate_keyed_t (static_cast<size_t> (conflate_key_size_));
+    else if (conflate_)
+        upipe = new (std::nothrow) ypipe_conflate_t<msg_t> ();
+    else
+        upipe = new (std::nothrow) ypipe_t<msg_t, message_pipe_granularity> (
+          ctx_->msg_pipe_granularity (), ctx_->msg_chunk_cache ());
+    alloc_assert (upipe);
+    return upipe;
+}
+
+size_t zmq::pipe_t::payload_size (const msg_t &msg_)
+{
+    //  Only message bodies count towards the byte limits.
+    if (msg_.is_routing_id () || msg_.is_delimiter () || msg_.is_join ()
+        || msg_.is_leave ())
+        return 0;
+    return msg_.size ();
+}
+
+void zmq::pipe_t::count_queued_bytes (int64_t delta_)
+{
+    _queued_bytes_delta += delta_;
+    if (_queued_bytes_delta >= queued_bytes_batch
+        || _queued_bytes_delta <= -queued_bytes_batch) {
+        get_ctx ()->add_queued_bytes (_queued_bytes_delta);
+        _queued_bytes_delta = 0;
+    }
+}
+
+void zmq::pipe_t::send_credit ()
+{
+    _bytes_read_sent = _bytes_read;
+    send_activate_write (_peer, _msgs_read, _bytes_read);
+}
+
 void zmq::pipe_t::process_delimiter ()
 {
     zmq_assert (_state == active || _state == waiting_for_delimiter);
@@ -496,12 +677,7 @@ void zmq::pipe_t::hiccup ()
     //  responsible for deallocating it.
 
     //  Create new inpipe.
-    _in_pipe =
-      _conflate
-        ? static_cast<upipe_t *> (new (std::nothrow) ypipe_conflate_t<msg_t> ())
-        : new (std::nothrow) ypipe_t<msg_t, message_pipe_granularity> ();
-
-    alloc_assert (_in_pipe);
+    _in_pipe = create_upipe (_conflate, _conflate_key_size, get_ctx ());
     _in_active = true;
 
     //  Notify the peer about the hiccup.
@@ -524,6 +700,22 @@ void zmq::pipe_t::set_hwms (int inhwm_, int outhwm_)
     _hwm = out;
 }
 
+void zmq::pipe_t::set_hwms_bytes (uint64_t inhwm_bytes_,
+                                  uint64_t outhwm_bytes_)
+{
+    _lwm_bytes = (inhwm_bytes_ + 1) / 2;
+    _hwm_bytes = outhwm_bytes_;
+}
+
+void zmq::pipe_t::set_count_queued_bytes ()
+{
+    zmq_assert (_peer);
+    if (_conflate || get_ctx ()->get_max_queued_bytes () == 0)
+        return;
+    _count_queued_bytes_out = true;
+    _peer->_count_queued_bytes_in = true;
+}
+
 void zmq::pipe_t::set_hwms_boost (int inhwmboost_, int outhwmboost_)
 {
     _in_hwm_boost = inhwmboost_;
@@ -533,7 +725,8 @@ void zmq::pipe_t::set_hwms_boost (int inhwmboost_, int outhwmboost_)
 bool zmq::pipe_t::check_hwm () const
 {
     const bool full =
-      _hwm > 0 && _msgs_written - _peers_msgs_read >= uint64_t (_hwm);
+      (_hwm > 0 && _msgs_written - _peers_msgs_read >= uint64_t (_hwm))
+      || (_hwm_bytes > 0 && _bytes_written - _peers_bytes_read >= _hwm_bytes);
     return !full;
 }
 
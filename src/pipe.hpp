@@ -16,6 +16,7 @@
 namespace zmq
 {
 class pipe_t;
+class spill_file_t;
 
 //  Create a pipepair for bi-directional transfer of messages.
 //  First HWM is for messages passed from first pipe to the second pipe.
@@ -24,11 +25,14 @@ class pipe_t;
 //  pipe receives all the pending messages before terminating, otherwise it
 //  terminates straight away.
 //  If conflate is true, only the most recently arrived message could be
-//  read (older messages are discarded)
+//  read (older messages are discarded). If conflate key size is non-zero
+//  as well, the most recent message is kept per key, the key being the
+//  first conflate_key_size bytes of the message.
 int pipepair (zmq::object_t *parents_[2],
               zmq::pipe_t *pipes_[2],
               const int hwms_[2],
-              const bool conflate_[2]);
+              const bool conflate_[2],
+              int conflate_key_size_ = 0);
 
 struct i_pipe_events
 {
@@ -53,7 +57,8 @@ class pipe_t ZMQ_FINAL : public object_t,
     friend int pipepair (zmq::object_t *parents_[2],
                          zmq::pipe_t *pipes_[2],
                          const int hwms_[2],
-                         const bool conflate_[2]);
+                         const bool conflate_[2],
+                         int conflate_key_size_);
 
   public:
     //  Specifies the object to send events to.
@@ -84,7 +89,7 @@ class pipe_t ZMQ_FINAL : public object_t,
     bool write (const msg_t *msg_);
 
     //  Remove unfinished parts of the outbound message from the pipe.
-    void rollback () const;
+    void rollback ();
 
     //  Flush the messages downstream.
     void flush ();
@@ -106,6 +111,20 @@ class pipe_t ZMQ_FINAL : public object_t,
     //  Set the high water marks.
     void set_hwms (int inhwm_, int outhwm_);
 
+    //  Set the high water marks in bytes. Zero means no limit.
+    void set_hwms_bytes (uint64_t inhwm_bytes_, uint64_t outhwm_bytes_);
+
+    //  Makes the messages written to this pipe count towards the context's
+    //  ZMQ_MAX_QUEUED_BYTES. Only pipes written by a socket's send, which
+    //  enforces the budget, are counted. Must be called on a new pair
+    //  before either end is handed over.
+    void set_count_queued_bytes ();
+
+    //  Overflow beyond the high water mark goes to a spill file in the
+    //  given directory instead of blocking the writer, and is written to
+    //  the pipe again as the reader catches up.
+    void set_spill_dir (const std::string &dir_);
+
     //  Set the boost to high water marks, used by inproc sockets so total hwm are sum of connect and bind sockets watermarks
     void set_hwms_boost (int inhwmboost_, int outhwmboost_);
 
@@ -131,7 +150,8 @@ class pipe_t ZMQ_FINAL : public object_t,
 
     //  Command handlers.
     void process_activate_read () ZMQ_OVERRIDE;
-    void process_activate_write (uint64_t msgs_read_) ZMQ_OVERRIDE;
+    void process_activate_write (uint64_t msgs_read_,
+                                 uint64_t bytes_read_) ZMQ_OVERRIDE;
     void process_hiccup (void *pipe_) ZMQ_OVERRIDE;
     void
     process_pipe_peer_stats (uint64_t queue_count_,
@@ -151,7 +171,8 @@ class pipe_t ZMQ_FINAL : public object_t,
             upipe_t *outpipe_,
             int inhwm_,
             int outhwm_,
-            bool conflate_);
+            bool conflate_,
+            int conflate_key_size_);
 
     //  Pipepair uses this function to let us know about
     //  the peer pipe object.
@@ -178,14 +199,30 @@ class pipe_t ZMQ_FINAL : public object_t,
     int _in_hwm_boost;
     int _out_hwm_boost;
 
+    //  High and low watermarks in bytes, zero if not limited.
+    uint64_t _hwm_bytes;
+    uint64_t _lwm_bytes;
+
     //  Number of messages read and written so far.
     uint64_t _msgs_read;
     uint64_t _msgs_written;
 
+    //  Number of bytes read and written so far. Bytes of a multi-part
+    //  message are only counted as written once its last part is.
+    uint64_t _bytes_read;
+    uint64_t _bytes_written;
+    uint64_t _bytes_in_msg;
+
+    //  Value of _bytes_read when it was last sent to the peer.
+    uint64_t _bytes_read_sent;
+
     //  Last received peer's msgs_read. The actual number in the peer
     //  can be higher at the moment.
     uint64_t _peers_msgs_read;
 
+    //  Last received peer's bytes_read.
+    uint64_t _peers_bytes_read;
+
     //  The pipe object on the other side of the pipepair.
     pipe_t *_peer;
 
@@ -230,7 +267,49 @@ class pipe_t ZMQ_FINAL : public object_t,
     //  Computes appropriate low watermark from the given high watermark.
     static int compute_lwm (int hwm_);
 
+    //  Number of bytes the message counts towards the byte limits.
+    static size_t payload_size (const msg_t &msg_);
+
+    //  Reports bytes entering (positive) or leaving (negative) the pipe to
+    //  the context-wide accounting, in batches.
+    void count_queued_bytes (int64_t delta_);
+
+    //  Writes the message to the underlying pipe and does the accounting.
+    void do_write (const msg_t *msg_);
+
+    //  Moves spilled messages back into the pipe while it has room.
+    void replay_spill ();
+
+    //  Lets the peer know how much was read so far.
+    void send_credit ();
+
+    //  Creates the underlying pipe matching the conflate settings.
+    static upipe_t *
+    create_upipe (bool conflate_, int conflate_key_size_, ctx_t *ctx_);
+
     const bool _conflate;
+    const int _conflate_key_size;
+
+    //  True if the bytes written to, respectively read from, this pipe are
+    //  reported to the context. See set_count_queued_bytes.
+    bool _count_queued_bytes_out;
+    bool _count_queued_bytes_in;
+
+    //  Bytes queued (or dequeued if negative) not reported yet.
+    int64_t _queued_bytes_delta;
+
+    //  Overflow queue on disk, NULL if not enabled.
+    spill_file_t *_spill;
+
+    //  True if the last frame written had the more flag set.
+    bool _out_more;
+
+    //  True if the message being written goes to the spill file.
+    bool _spilling;
+
+    //  True if a frame of the message being written failed to go to the
+    //  spill file, so that its remaining frames are dropped.
+    bool _spill_failed;
 
     // The endpoints of this pipe.
     endpoint_uri_pair_t _endpoint_pair;
@@ -151,6 +151,11 @@ int zmq::radio_t::xsend (msg_t *msg_)
     return rc;
 }
 
+bool zmq::radio_t::xlossy () const
+{
+    return _lossy;
+}
+
 bool zmq::radio_t::xhas_out ()
 {
     return _dist.has_out ();
@@ -30,6 +30,7 @@ class radio_t ZMQ_FINAL : public socket_base_t
                        bool locally_initiated_ = false);
     int xsend (zmq::msg_t *msg_);
     bool xhas_out ();
+    bool xlossy () const;
     int xrecv (zmq::msg_t *msg_);
     bool xhas_in ();
     void xread_activated (zmq::pipe_t *pipe_);
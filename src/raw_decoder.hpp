@@ -15,7 +15,7 @@ namespace zmq
 class raw_decoder_t ZMQ_FINAL : public i_decoder
 {
   public:
-    raw_decoder_t (size_t bufsize_);
+    raw_decoder_t (size_t bufsize_, const allocator_t &hooks_);
     ~raw_decoder_t ();
 
     //  i_decoder interface.
@@ -27,6 +27,7 @@ class raw_decoder_t ZMQ_FINAL : public i_decoder
     msg_t *msg () { return &_in_progress; }
 
     void resize_buffer (size_t) {}
+    void release_buffer () { _allocator.deallocate (); }
 
   private:
     msg_t _in_progress;
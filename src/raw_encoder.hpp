@@ -16,7 +16,7 @@ namespace zmq
 class raw_encoder_t ZMQ_FINAL : public encoder_base_t<raw_encoder_t>
 {
   public:
-    raw_encoder_t (size_t bufsize_);
+    raw_encoder_t (size_t bufsize_, const allocator_t &hooks_);
     ~raw_encoder_t ();
 
   private:
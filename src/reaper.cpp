@@ -8,6 +8,7 @@
 
 zmq::reaper_t::reaper_t (class ctx_t *ctx_, uint32_t tid_) :
     object_t (ctx_, tid_),
+    _mailbox (ctx_->cmd_pipe_granularity ()),
     _mailbox_handle (static_cast<poller_t::handle_t> (NULL)),
     _poller (NULL),
     _sockets (0),
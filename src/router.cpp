@@ -389,6 +389,11 @@ static bool check_pipe_hwm (const zmq::pipe_t &pipe_)
     return pipe_.check_hwm ();
 }
 
+bool zmq::router_t::xlossy () const
+{
+    return !_mandatory;
+}
+
 bool zmq::router_t::xhas_out ()
 {
     //  In theory, ROUTER socket is always ready for writing (except when
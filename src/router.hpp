@@ -34,6 +34,7 @@ class router_t : public routing_socket_base_t
     int xrecv (zmq::msg_t *msg_) ZMQ_OVERRIDE;
     bool xhas_in () ZMQ_OVERRIDE;
     bool xhas_out () ZMQ_OVERRIDE;
+    bool xlossy () const ZMQ_OVERRIDE;
     void xread_activated (zmq::pipe_t *pipe_) ZMQ_FINAL;
     void xpipe_terminated (zmq::pipe_t *pipe_) ZMQ_FINAL;
     int get_peer_state (const void *routing_id_,
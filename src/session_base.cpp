@@ -403,8 +403,19 @@ void zmq::session_base_t::engine_ready ()
         int hwms[2] = {conflate ? -1 : options.rcvhwm,
                        conflate ? -1 : options.sndhwm};
         bool conflates[2] = {conflate, conflate};
-        const int rc = pipepair (parents, pipes, hwms, conflates);
+        const int rc = pipepair (parents, pipes, hwms, conflates,
+                                 options.conflate_key_size);
         errno_assert (rc == 0);
+        if (!conflate) {
+            pipes[0]->set_hwms_bytes (options.sndhwm_bytes,
+                                      options.rcvhwm_bytes);
+            pipes[1]->set_hwms_bytes (options.rcvhwm_bytes,
+                                      options.sndhwm_bytes);
+        }
+
+        //  Only what the socket sends counts towards ZMQ_MAX_QUEUED_BYTES,
+        //  the engine doesn't hold back on the way in.
+        pipes[1]->set_count_queued_bytes ();
 
         //  Plug the local end of the pipe.
         pipes[0]->set_event_sink (this);
@@ -11,6 +11,7 @@
 #include "socket_base.hpp"
 #include "i_engine.hpp"
 #include "msg.hpp"
+#include "blob.hpp"
 
 namespace zmq
 {
@@ -69,6 +70,10 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     socket_base_t *get_socket () const;
     const endpoint_uri_pair_t &get_endpoint () const;
 
+    //  Ticket to resume the CURVE session with when reconnecting, along
+    //  with its secret. Empty if there is none.
+    blob_t &curve_ticket () { return _curve_ticket; }
+
   protected:
     session_base_t (zmq::io_thread_t *io_thread_,
                     bool active_,
@@ -126,6 +131,8 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     //  the engines into the same thread.
     zmq::io_thread_t *_io_thread;
 
+    blob_t _curve_ticket;
+
     //  ID of the linger timer
     enum
     {
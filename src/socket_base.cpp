@@ -224,6 +224,8 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_,
     _last_tsc (0),
     _ticks (0),
     _rcvmore (false),
+    _sndmore (false),
+    _snddrop (false),
     _monitor_socket (NULL),
     _monitor_events (0),
     _thread_safe (thread_safe_),
@@ -235,12 +237,15 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_,
     options.ipv6 = (parent_->get (ZMQ_IPV6) != 0);
     options.linger.store (parent_->get (ZMQ_BLOCKY) ? -1 : 0);
     options.zero_copy = parent_->get (ZMQ_ZERO_COPY_RECV) != 0;
+    options.allocator = parent_->get_allocator ();
 
     if (_thread_safe) {
-        _mailbox = new (std::nothrow) mailbox_safe_t (&_sync);
+        _mailbox = new (std::nothrow) mailbox_safe_t (
+          &_sync, parent_->cmd_pipe_granularity ());
         zmq_assert (_mailbox);
     } else {
-        mailbox_t *m = new (std::nothrow) mailbox_t ();
+        mailbox_t *m =
+          new (std::nothrow) mailbox_t (parent_->cmd_pipe_granularity ());
         zmq_assert (m);
 
         if (m->get_fd () != retired_fd)
@@ -420,6 +425,15 @@ int zmq::socket_base_t::setsockopt (int option_,
     rc = options.setsockopt (option_, optval_, optvallen_);
     update_pipe_options (option_);
 
+    //  Setting the TTL starts over, e.g. after the handler's policy has
+    //  changed.
+    if (rc == 0 && option_ == ZMQ_ZAP_CACHE_TTL)
+        _zap_cache.clear ();
+
+    //  A new ticket key voids the tickets issued so far.
+    if (rc == 0 && option_ == ZMQ_CURVE_TICKET_LIFETIME)
+        _curve_tickets.clear ();
+
     return rc;
 }
 
@@ -599,6 +613,7 @@ int zmq::socket_base_t::bind (const char *endpoint_uri_)
         bool conflates[2] = {false, false};
         rc = pipepair (parents, new_pipes, hwms, conflates);
         errno_assert (rc == 0);
+        new_pipes[0]->set_count_queued_bytes ();
 
         //  Attach local end of the pipe to the socket object.
         attach_pipe (new_pipes[0], true, true);
@@ -792,6 +807,16 @@ int zmq::socket_base_t::connect_internal (const char *endpoint_uri_)
                            : options.rcvhwm != 0 && peer.options.sndhwm != 0
                              ? options.rcvhwm + peer.options.sndhwm
                              : 0;
+        const uint64_t sndhwm_bytes =
+          peer.socket == NULL ? options.sndhwm_bytes
+          : options.sndhwm_bytes != 0 && peer.options.rcvhwm_bytes != 0
+            ? options.sndhwm_bytes + peer.options.rcvhwm_bytes
+            : 0;
+        const uint64_t rcvhwm_bytes =
+          peer.socket == NULL ? options.rcvhwm_bytes
+          : options.rcvhwm_bytes != 0 && peer.options.sndhwm_bytes != 0
+            ? options.rcvhwm_bytes + peer.options.sndhwm_bytes
+            : 0;
 
         //  Create a bi-directional pipe to connect the peers.
         object_t *parents[2] = {this, peer.socket == NULL ? this : peer.socket};
@@ -801,14 +826,19 @@ int zmq::socket_base_t::connect_internal (const char *endpoint_uri_)
 
         int hwms[2] = {conflate ? -1 : sndhwm, conflate ? -1 : rcvhwm};
         bool conflates[2] = {conflate, conflate};
-        rc = pipepair (parents, new_pipes, hwms, conflates);
+        rc = pipepair (parents, new_pipes, hwms, conflates,
+                       options.conflate_key_size);
         if (!conflate) {
             new_pipes[0]->set_hwms_boost (peer.options.sndhwm,
                                           peer.options.rcvhwm);
             new_pipes[1]->set_hwms_boost (options.sndhwm, options.rcvhwm);
+            new_pipes[0]->set_hwms_bytes (rcvhwm_bytes, sndhwm_bytes);
+            new_pipes[1]->set_hwms_bytes (sndhwm_bytes, rcvhwm_bytes);
         }
 
         errno_assert (rc == 0);
+        new_pipes[0]->set_count_queued_bytes ();
+        new_pipes[1]->set_count_queued_bytes ();
 
         if (!peer.socket) {
             //  The peer doesn't exist yet so we don't know whether
@@ -1075,8 +1105,16 @@ int zmq::socket_base_t::connect_internal (const char *endpoint_uri_)
         int hwms[2] = {conflate ? -1 : options.sndhwm,
                        conflate ? -1 : options.rcvhwm};
         bool conflates[2] = {conflate, conflate};
-        rc = pipepair (parents, new_pipes, hwms, conflates);
+        rc = pipepair (parents, new_pipes, hwms, conflates,
+                       options.conflate_key_size);
         errno_assert (rc == 0);
+        if (!conflate) {
+            new_pipes[0]->set_hwms_bytes (options.rcvhwm_bytes,
+                                          options.sndhwm_bytes);
+            new_pipes[1]->set_hwms_bytes (options.sndhwm_bytes,
+                                          options.rcvhwm_bytes);
+        }
+        new_pipes[0]->set_count_queued_bytes ();
 
         //  Attach local end of the pipe to the socket object.
         attach_pipe (new_pipes[0], subscribe_to_all, true);
@@ -1233,9 +1271,28 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
 
     msg_->reset_metadata ();
 
+    const bool more = (flags_ & ZMQ_SNDMORE) != 0;
+
+    //  Once the context-wide budget for queued bytes is exhausted, new
+    //  messages are dropped or blocked as they would be on a full pipe.
+    if (unlikely (_snddrop
+                  || (!_sndmore && get_ctx ()->queued_bytes_exceeded ()))) {
+        if (_snddrop || xlossy ()) {
+            _snddrop = more;
+            rc = msg_->close ();
+            errno_assert (rc == 0);
+            rc = msg_->init ();
+            errno_assert (rc == 0);
+            return 0;
+        }
+        if (wait_for_queued_bytes (flags_) != 0)
+            return -1;
+    }
+
     //  Try to send the message using method in each socket class
     rc = xsend (msg_);
     if (rc == 0) {
+        _sndmore = more;
         return 0;
     }
     //  Special case for ZMQ_PUSH: -2 means pipe is dead while a
@@ -1247,6 +1304,7 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
             errno_assert (rc == 0);
             rc = msg_->init ();
             errno_assert (rc == 0);
+            _sndmore = false;
             return 0;
         }
     }
@@ -1287,6 +1345,35 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
         }
     }
 
+    _sndmore = more;
+    return 0;
+}
+
+int zmq::socket_base_t::wait_for_queued_bytes (int flags_)
+{
+    if ((flags_ & ZMQ_DONTWAIT) || options.sndtimeo == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    //  Pipes release the budget without notifying the blocked sockets,
+    //  so the budget is re-checked at a regular interval.
+    const int timeout = options.sndtimeo;
+    const uint64_t end = timeout < 0 ? 0 : (_clock.now_ms () + timeout);
+    while (get_ctx ()->queued_bytes_exceeded ()) {
+        int interval = queued_bytes_poll_interval;
+        if (timeout > 0) {
+            const int remaining = static_cast<int> (end - _clock.now_ms ());
+            if (remaining <= 0) {
+                errno = EAGAIN;
+                return -1;
+            }
+            if (remaining < interval)
+                interval = remaining;
+        }
+        if (unlikely (process_commands (interval, false) != 0))
+            return -1;
+    }
     return 0;
 }
 
@@ -1612,6 +1699,11 @@ bool zmq::socket_base_t::xhas_out ()
     return false;
 }
 
+bool zmq::socket_base_t::xlossy () const
+{
+    return false;
+}
+
 int zmq::socket_base_t::xsend (msg_t *)
 {
     errno = ENOTSUP;
@@ -17,6 +17,8 @@
 #include "clock.hpp"
 #include "pipe.hpp"
 #include "endpoint.hpp"
+#include "zap_cache.hpp"
+#include "curve_tickets.hpp"
 
 extern "C" {
 void zmq_free_event (void *data_, void *hint_);
@@ -140,6 +142,13 @@ class socket_base_t : public own_t,
 
     bool is_disconnected () const;
 
+    //  Replies of the ZAP handler, shared by the sessions of the socket.
+    zap_cache_t &zap_cache () { return _zap_cache; }
+
+    //  CURVE tickets used to resume sessions, shared by the sessions of
+    //  the socket.
+    curve_tickets_t &curve_tickets () { return _curve_tickets; }
+
   protected:
     socket_base_t (zmq::ctx_t *parent_,
                    uint32_t tid_,
@@ -168,6 +177,10 @@ class socket_base_t : public own_t,
     virtual bool xhas_out ();
     virtual int xsend (zmq::msg_t *msg_);
 
+    //  Returns true if the socket drops messages rather than blocking when
+    //  its peers can't keep up. The default implementation blocks.
+    virtual bool xlossy () const;
+
     //  The default implementation assumes that recv in not supported.
     virtual bool xhas_in ();
     virtual int xrecv (zmq::msg_t *msg_);
@@ -268,6 +281,11 @@ class socket_base_t : public own_t,
     //  in a predefined time period.
     int process_commands (int timeout_, bool throttle_);
 
+    //  Waits until the context-wide queued bytes budget is available again,
+    //  processing commands meanwhile. Fails with EAGAIN on timeout or if
+    //  flags_ ask not to wait.
+    int wait_for_queued_bytes (int flags_);
+
     //  Handlers for incoming commands.
     void process_stop () ZMQ_FINAL;
     void process_bind (zmq::pipe_t *pipe_) ZMQ_FINAL;
@@ -303,6 +321,13 @@ class socket_base_t : public own_t,
     //  True if the last message received had MORE flag set.
     bool _rcvmore;
 
+    //  True if the last message sent had MORE flag set.
+    bool _sndmore;
+
+    //  True while dropping the remaining parts of a message because the
+    //  context-wide queued bytes budget was exhausted.
+    bool _snddrop;
+
     //  Improves efficiency of time measurement.
     clock_t _clock;
 
@@ -324,6 +349,10 @@ class socket_base_t : public own_t,
     // Mutex to synchronize access to the monitor Pair socket
     mutex_t _monitor_sync;
 
+    zap_cache_t _zap_cache;
+
+    curve_tickets_t _curve_tickets;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (socket_base_t)
 
     // Add a flag for mark disconnect action
@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "spill_file.hpp"
+#include "err.hpp"
+#include "msg.hpp"
+#include "random.hpp"
+
+#ifndef ZMQ_HAVE_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+zmq::spill_file_t::spill_file_t (const std::string &dir_) :
+    _dir (dir_), _writer (NULL), _reader (NULL), _dirty (false), _frames (0)
+{
+}
+
+zmq::spill_file_t::~spill_file_t ()
+{
+    clear ();
+}
+
+int zmq::spill_file_t::open ()
+{
+    char name[32];
+    snprintf (name, sizeof name, "zmq-spill-%08x%08x", generate_random (),
+              generate_random ());
+    _path = _dir + "/" + name;
+
+#ifdef ZMQ_HAVE_WINDOWS
+    _writer = fopen (_path.c_str (), "wb");
+#else
+    //  The file holds message payloads, so only the owner may read it,
+    //  whatever the umask.
+    const int fd =
+      ::open (_path.c_str (), O_WRONLY | O_CREAT | O_EXCL | O_TRUNC, 0600);
+    if (fd == -1)
+        return -1;
+    _writer = fdopen (fd, "wb");
+    if (!_writer) {
+        const int err = errno;
+        ::close (fd);
+        ::remove (_path.c_str ());
+        _path.clear ();
+        errno = err;
+        return -1;
+    }
+#endif
+    if (!_writer)
+        return -1;
+    _reader = fopen (_path.c_str (), "rb");
+    if (!_reader) {
+        const int err = errno;
+        clear ();
+        errno = err;
+        return -1;
+    }
+
+#ifndef ZMQ_HAVE_WINDOWS
+    //  Both handles stay valid, and nothing is left behind on a crash.
+    ::remove (_path.c_str ());
+    _path.clear ();
+#endif
+    return 0;
+}
+
+void zmq::spill_file_t::clear ()
+{
+    if (_reader) {
+        fclose (_reader);
+        _reader = NULL;
+    }
+    if (_writer) {
+        fclose (_writer);
+        _writer = NULL;
+    }
+    if (!_path.empty ()) {
+        ::remove (_path.c_str ());
+        _path.clear ();
+    }
+    _dirty = false;
+    _frames = 0;
+}
+
+int zmq::spill_file_t::write (const msg_t &msg_)
+{
+    if (!_writer && open () != 0)
+        return -1;
+
+    const unsigned char flags =
+      static_cast<unsigned char> (msg_.flags () & (msg_t::more | msg_t::command));
+    const uint64_t size = msg_.size ();
+    msg_t &msg = const_cast<msg_t &> (msg_);
+    if (fwrite (&flags, sizeof flags, 1, _writer) != 1
+        || fwrite (&size, sizeof size, 1, _writer) != 1
+        || (size > 0 && fwrite (msg.data (), size, 1, _writer) != 1)) {
+        //  The file is now unusable, drop what it holds.
+        if (errno == 0)
+            errno = EIO;
+        const int err = errno;
+        clear ();
+        errno = err;
+        return -1;
+    }
+
+    _dirty = true;
+    _frames++;
+    return 0;
+}
+
+int zmq::spill_file_t::read (msg_t *msg_)
+{
+    zmq_assert (_frames > 0);
+
+    if (_dirty) {
+        if (fflush (_writer) != 0) {
+            const int err = errno;
+            clear ();
+            errno = err;
+            return -1;
+        }
+        _dirty = false;
+    }
+
+    unsigned char flags;
+    uint64_t size;
+    if (fread (&flags, sizeof flags, 1, _reader) != 1
+        || fread (&size, sizeof size, 1, _reader) != 1) {
+        clear ();
+        errno = EIO;
+        return -1;
+    }
+
+    int rc = msg_->close ();
+    errno_assert (rc == 0);
+    rc = msg_->init_size (static_cast<size_t> (size));
+    errno_assert (rc == 0);
+    if (size > 0 && fread (msg_->data (), size, 1, _reader) != 1) {
+        clear ();
+        errno = EIO;
+        return -1;
+    }
+    msg_->set_flags (flags);
+
+    //  Once everything was read back, the segment is dropped.
+    if (--_frames == 0)
+        clear ();
+    return 0;
+}
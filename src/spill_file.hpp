@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_SPILL_FILE_HPP_INCLUDED__
+#define __ZMQ_SPILL_FILE_HPP_INCLUDED__
+
+#include <stdio.h>
+#include <string>
+
+#include "macros.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+class msg_t;
+
+//  Overflow queue of message frames kept in a file. Frames are appended
+//  at the end and read back in order from the start. The file is created
+//  in the given directory on the first write and removed as soon as all
+//  frames were read back, so each overflow episode gets a fresh segment.
+//
+//  Not thread safe, both ends are used from the writer's thread.
+
+class spill_file_t
+{
+  public:
+    explicit spill_file_t (const std::string &dir_);
+    ~spill_file_t ();
+
+    //  Returns true if there are no frames to read back.
+    bool empty () const { return _frames == 0; }
+
+    //  Appends the frame to the file. Returns -1 and sets errno on
+    //  failure. The message is left untouched.
+    int write (const msg_t &msg_);
+
+    //  Reads the oldest frame back into an initialised message. Returns -1
+    //  and sets errno on failure, in which case the remaining frames are
+    //  discarded.
+    int read (msg_t *msg_);
+
+    //  Discards all frames and removes the file.
+    void clear ();
+
+  private:
+    int open ();
+
+    const std::string _dir;
+    std::string _path;
+
+    //  Separate handles for appending and reading back, so that neither
+    //  has to seek.
+    FILE *_writer;
+    FILE *_reader;
+
+    //  True if frames were written since the writer was last flushed.
+    bool _dirty;
+
+    //  Number of frames written but not read back yet.
+    uint64_t _frames;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (spill_file_t)
+};
+}
+
+#endif
@@ -28,6 +28,7 @@ zmq::stream_connecter_base_t::stream_connecter_base_t (
     _s (retired_fd),
     _handle (static_cast<handle_t> (NULL)),
     _socket (session_->get_socket ()),
+    _greeting_bytes_sent (0),
     _delayed_start (delayed_start_),
     _reconnect_timer_started (false),
     _current_reconnect_ivl (-1),
@@ -155,7 +156,8 @@ void zmq::stream_connecter_base_t::create_engine (
     if (options.raw_socket)
         engine = new (std::nothrow) raw_engine_t (fd_, options, endpoint_pair);
     else
-        engine = new (std::nothrow) zmtp_engine_t (fd_, options, endpoint_pair);
+        engine = new (std::nothrow)
+          zmtp_engine_t (fd_, options, endpoint_pair, _greeting_bytes_sent);
     alloc_assert (engine);
 
     //  Attach the engine to the corresponding session object.
@@ -64,6 +64,9 @@ class stream_connecter_base_t : public own_t, public io_object_t
     // Socket
     zmq::socket_base_t *const _socket;
 
+    //  Number of bytes of the ZMTP greeting sent while connecting.
+    size_t _greeting_bytes_sent;
+
   private:
     //  ID of the timer used to delay the reconnection.
     enum
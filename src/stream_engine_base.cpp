@@ -27,6 +27,8 @@
 #include "gssapi_server.hpp"
 #include "curve_client.hpp"
 #include "curve_server.hpp"
+#include "crypto_pool.hpp"
+#include "ctx.hpp"
 #include "raw_decoder.hpp"
 #include "raw_encoder.hpp"
 #include "config.hpp"
@@ -80,11 +82,14 @@ zmq::stream_engine_base_t::stream_engine_base_t (
     _options (options_),
     _inpos (NULL),
     _insize (0),
+    _next_inpos (NULL),
+    _next_insize (0),
     _decoder (NULL),
     _outpos (NULL),
     _outsize (0),
     _encoder (NULL),
     _mechanism (NULL),
+    _crypto_notifier (NULL),
     _next_msg (NULL),
     _process_msg (NULL),
     _metadata (NULL),
@@ -95,6 +100,8 @@ zmq::stream_engine_base_t::stream_engine_base_t (
     _has_ttl_timer (false),
     _has_timeout_timer (false),
     _has_heartbeat_timer (false),
+    _has_idle_timer (false),
+    _io_activity (false),
     _peer_address (get_peer_address (fd_)),
     _s (fd_),
     _handle (static_cast<handle_t> (NULL)),
@@ -147,6 +154,9 @@ zmq::stream_engine_base_t::~stream_engine_base_t ()
     LIBZMQ_DELETE (_encoder);
     LIBZMQ_DELETE (_decoder);
     LIBZMQ_DELETE (_mechanism);
+
+    //  After the mechanism, which cancels the job it may have posted.
+    LIBZMQ_DELETE (_crypto_notifier);
 }
 
 void zmq::stream_engine_base_t::plug (io_thread_t *io_thread_,
@@ -166,6 +176,21 @@ void zmq::stream_engine_base_t::plug (io_thread_t *io_thread_,
     _handle = add_fd (_s);
     _io_error = false;
 
+#ifdef ZMQ_HAVE_CURVE
+    crypto_pool_t *const crypto_pool = _session->get_ctx ()->get_crypto_pool ();
+    if (crypto_pool && _options.mechanism == ZMQ_CURVE && _options.as_server) {
+        _crypto_notifier =
+          new (std::nothrow) crypto_notifier_t (crypto_pool, this);
+        alloc_assert (_crypto_notifier);
+
+        //  Without a signaler, the handshake runs in this thread.
+        if (!_crypto_notifier->valid ())
+            LIBZMQ_DELETE (_crypto_notifier);
+    }
+    if (_crypto_notifier)
+        _crypto_notifier->plug (io_thread_);
+#endif
+
     plug_internal ();
 }
 
@@ -194,9 +219,16 @@ void zmq::stream_engine_base_t::unplug ()
         cancel_timer (heartbeat_ivl_timer_id);
         _has_heartbeat_timer = false;
     }
+
+    if (_has_idle_timer) {
+        cancel_timer (idle_timer_id);
+        _has_idle_timer = false;
+    }
     //  Cancel all fd subscriptions.
     if (!_io_error)
         rm_fd (_handle);
+    if (_crypto_notifier)
+        _crypto_notifier->unplug ();
 
     //  Disconnect from I/O threads poller object.
     io_object_t::unplug ();
@@ -251,15 +283,21 @@ bool zmq::stream_engine_base_t::in_event_internal ()
     }
 
     //  If there's no data to process in the buffer...
-    if (!_insize) {
+    if (!input_available ()) {
+        set_io_activity ();
+
         //  Retrieve the buffer and read as much data as possible.
         //  Note that buffer can be arbitrarily large. However, we assume
         //  the underlying TCP layer has fixed buffer size and thus the
         //  number of bytes read will be always limited.
         size_t bufsize = 0;
-        _decoder->get_buffer (&_inpos, &bufsize);
+        unsigned char *next_buf = NULL;
+        size_t next_bufsize = 0;
+        _decoder->get_buffers (&_inpos, &bufsize, &next_buf, &next_bufsize);
 
-        const int rc = read (_inpos, bufsize);
+        const int rc = next_buf
+                         ? readv (_inpos, bufsize, next_buf, next_bufsize)
+                         : read (_inpos, bufsize);
 
         if (rc == -1) {
             if (errno != EAGAIN) {
@@ -271,20 +309,29 @@ bool zmq::stream_engine_base_t::in_event_internal ()
 
         //  Adjust input size
         _insize = static_cast<size_t> (rc);
+        if (next_buf && _insize > bufsize) {
+            _next_inpos = next_buf;
+            _next_insize = _insize - bufsize;
+            _insize = bufsize;
+        }
         // Adjust buffer size to received bytes
-        _decoder->resize_buffer (_insize);
+        _decoder->resize_buffer (next_buf ? _next_insize : _insize);
     }
 
     int rc = 0;
     size_t processed = 0;
 
-    while (_insize > 0) {
+    while (input_available ()) {
         rc = _decoder->decode (_inpos, _insize, processed);
         zmq_assert (processed <= _insize);
         _inpos += processed;
         _insize -= processed;
-        if (rc == 0 || rc == -1)
+        if (rc == -1)
             break;
+        //  The decoder wants more data, which a scattered read may have
+        //  put in the second buffer already.
+        if (rc == 0)
+            continue;
         rc = (this->*_process_msg) (_decoder->msg ());
         if (rc == -1)
             break;
@@ -325,6 +372,7 @@ void zmq::stream_engine_base_t::out_event ()
             return;
         }
 
+        set_io_activity ();
         _outpos = NULL;
         _outsize = _encoder->encode (&_outpos, 0);
 
@@ -414,14 +462,18 @@ bool zmq::stream_engine_base_t::restart_input ()
         return true;
     }
 
-    while (_insize > 0) {
+    while (input_available ()) {
         size_t processed = 0;
         rc = _decoder->decode (_inpos, _insize, processed);
         zmq_assert (processed <= _insize);
         _inpos += processed;
         _insize -= processed;
-        if (rc == 0 || rc == -1)
+        if (rc == -1)
             break;
+        //  The decoder wants more data, which a scattered read may have
+        //  put in the second buffer already.
+        if (rc == 0)
+            continue;
         rc = (this->*_process_msg) (_decoder->msg ());
         if (rc == -1)
             break;
@@ -504,6 +556,22 @@ void zmq::stream_engine_base_t::zap_msg_available ()
         restart_output ();
 }
 
+void zmq::stream_engine_base_t::crypto_job_done ()
+{
+    zmq_assert (_mechanism != NULL);
+
+    const int rc = _mechanism->crypto_job_done ();
+    if (rc == -1 || _mechanism->status () == mechanism_t::error) {
+        error (protocol_error);
+        return;
+    }
+    if (_input_stopped)
+        if (!restart_input ())
+            return;
+    if (_output_stopped)
+        restart_output ();
+}
+
 const zmq::endpoint_uri_pair_t &zmq::stream_engine_base_t::get_endpoint () const
 {
     return _endpoint_uri_pair;
@@ -511,6 +579,13 @@ const zmq::endpoint_uri_pair_t &zmq::stream_engine_base_t::get_endpoint () const
 
 void zmq::stream_engine_base_t::mechanism_ready ()
 {
+    //  The handshake has no more jobs for the crypto pool, so don't hold
+    //  on to a signaler for the rest of the connection.
+    if (_crypto_notifier) {
+        _crypto_notifier->unplug ();
+        LIBZMQ_DELETE (_crypto_notifier);
+    }
+
     if (_options.heartbeat_interval > 0 && !_has_heartbeat_timer) {
         add_timer (_options.heartbeat_interval, heartbeat_ivl_timer_id);
         _has_heartbeat_timer = true;
@@ -748,11 +823,64 @@ void zmq::stream_engine_base_t::timer_event (int id_)
     } else if (id_ == heartbeat_timeout_timer_id) {
         _has_timeout_timer = false;
         error (timeout_error);
+    } else if (id_ == idle_timer_id) {
+        _has_idle_timer = false;
+        if (_io_activity) {
+            //  Check again after another interval.
+            _io_activity = false;
+            add_timer (engine_buffer_idle_interval, idle_timer_id);
+            _has_idle_timer = true;
+        } else
+            release_buffers ();
     } else
         // There are no other valid timer ids!
         assert (false);
 }
 
+void zmq::stream_engine_base_t::set_io_activity ()
+{
+    _io_activity = true;
+    if (!_has_idle_timer) {
+        add_timer (engine_buffer_idle_interval, idle_timer_id);
+        _has_idle_timer = true;
+    }
+}
+
+void zmq::stream_engine_base_t::release_buffers ()
+{
+    if (_encoder && !_outsize)
+        _encoder->release_buffer ();
+    if (_decoder && !input_available ())
+        _decoder->release_buffer ();
+}
+
+bool zmq::stream_engine_base_t::input_available ()
+{
+    if (!_insize && _next_insize) {
+        _inpos = _next_inpos;
+        _insize = _next_insize;
+        _next_insize = 0;
+    }
+    return _insize > 0;
+}
+
+int zmq::stream_engine_base_t::readv (void *data_,
+                                      size_t size_,
+                                      void *next_data_,
+                                      size_t next_size_)
+{
+    const int rc =
+      zmq::tcp_readv (_s, data_, size_, next_data_, next_size_);
+
+    if (rc == 0) {
+        // connection closed by peer
+        errno = EPIPE;
+        return -1;
+    }
+
+    return rc;
+}
+
 int zmq::stream_engine_base_t::read (void *data_, size_t size_)
 {
     const int rc = zmq::tcp_read (_s, data_, size_);
@@ -21,6 +21,7 @@ namespace zmq
 class io_thread_t;
 class session_base_t;
 class mechanism_t;
+class crypto_notifier_t;
 
 //  This engine handles any socket with SOCK_STREAM semantics,
 //  e.g. TCP socket or an UNIX domain socket.
@@ -44,6 +45,9 @@ class stream_engine_base_t : public io_object_t, public i_engine
     void zap_msg_available () ZMQ_FINAL;
     const endpoint_uri_pair_t &get_endpoint () const ZMQ_FINAL;
 
+    //  Called once a job the mechanism posted to the crypto pool has run.
+    void crypto_job_done ();
+
     //  i_poll_events interface implementation.
     void in_event () ZMQ_FINAL;
     void out_event () ZMQ_OVERRIDE;
@@ -93,6 +97,10 @@ class stream_engine_base_t : public io_object_t, public i_engine
     };
 
     virtual int read (void *data, size_t size_);
+    //  Reads into data_ and, once it is full, into next_data_. Engines that
+    //  override read have to override this too.
+    virtual int
+    readv (void *data_, size_t size_, void *next_data_, size_t next_size_);
     virtual int write (const void *data_, size_t size_);
 
     void reset_pollout () { io_object_t::reset_pollout (_handle); }
@@ -105,6 +113,11 @@ class stream_engine_base_t : public io_object_t, public i_engine
 
     unsigned char *_inpos;
     size_t _insize;
+
+    //  Data read past the end of _inpos by a scattered read. It is decoded
+    //  once everything at _inpos was.
+    unsigned char *_next_inpos;
+    size_t _next_insize;
     i_decoder *_decoder;
 
     unsigned char *_outpos;
@@ -113,6 +126,10 @@ class stream_engine_base_t : public io_object_t, public i_engine
 
     mechanism_t *_mechanism;
 
+    //  Lets a CURVE server run its handshake on the context's crypto
+    //  pool. NULL if there is no pool.
+    crypto_notifier_t *_crypto_notifier;
+
     int (stream_engine_base_t::*_next_msg) (msg_t *msg_);
     int (stream_engine_base_t::*_process_msg) (msg_t *msg_);
 
@@ -148,15 +165,35 @@ class stream_engine_base_t : public io_object_t, public i_engine
     bool _has_timeout_timer;
     bool _has_heartbeat_timer;
 
+    //  Buffer release timer, see engine_buffer_idle_interval.
+    enum
+    {
+        idle_timer_id = 0x83
+    };
+    bool _has_idle_timer;
+
+    //  True if the connection was read from or written to since the idle
+    //  timer was last armed.
+    bool _io_activity;
 
     const std::string _peer_address;
 
   private:
     bool in_event_internal ();
 
+    //  Returns true if there is read data left to decode, moving on to
+    //  _next_inpos once _inpos is exhausted.
+    bool input_available ();
+
     //  Unplug the engine from the session.
     void unplug ();
 
+    //  Records I/O on the connection and arms the idle timer if needed.
+    void set_io_activity ();
+
+    //  Frees the encoder and decoder buffers unless they hold data.
+    void release_buffers ();
+
     int write_credential (msg_t *msg_);
 
     void mechanism_ready ();
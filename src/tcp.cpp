@@ -11,6 +11,7 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <unistd.h>
@@ -242,49 +243,96 @@ int zmq::tcp_write (fd_t s_, const void *data_, size_t size_)
 #endif
 }
 
-int zmq::tcp_read (fd_t s_, void *data_, size_t size_)
+//  Sets errno after a failed read.
+static void read_error ()
 {
 #ifdef ZMQ_HAVE_WINDOWS
 
-    const int rc =
-      recv (s_, static_cast<char *> (data_), static_cast<int> (size_), 0);
-
     //  If not a single byte can be read from the socket in non-blocking mode
     //  we'll get an error (this may happen during the speculative read).
-    if (rc == SOCKET_ERROR) {
-        const int last_error = WSAGetLastError ();
-        if (last_error == WSAEWOULDBLOCK) {
-            errno = EAGAIN;
-        } else {
-            wsa_assert (
-              last_error == WSAENETDOWN || last_error == WSAENETRESET
-              || last_error == WSAECONNABORTED || last_error == WSAETIMEDOUT
-              || last_error == WSAECONNRESET || last_error == WSAECONNREFUSED
-              || last_error == WSAENOTCONN || last_error == WSAENOBUFS);
-            errno = wsa_error_to_errno (last_error);
-        }
+    const int last_error = WSAGetLastError ();
+    if (last_error == WSAEWOULDBLOCK) {
+        errno = EAGAIN;
+    } else {
+        wsa_assert (
+          last_error == WSAENETDOWN || last_error == WSAENETRESET
+          || last_error == WSAECONNABORTED || last_error == WSAETIMEDOUT
+          || last_error == WSAECONNRESET || last_error == WSAECONNREFUSED
+          || last_error == WSAENOTCONN || last_error == WSAENOBUFS);
+        errno = zmq::wsa_error_to_errno (last_error);
     }
 
-    return rc == SOCKET_ERROR ? -1 : rc;
-
 #else
 
-    const ssize_t rc = recv (s_, static_cast<char *> (data_), size_, 0);
-
     //  Several errors are OK. When speculative read is being done we may not
     //  be able to read a single byte from the socket. Also, SIGSTOP issued
     //  by a debugging tool can result in EINTR error.
-    if (rc == -1) {
 #if !defined(TARGET_OS_IPHONE) || !TARGET_OS_IPHONE
-        errno_assert (errno != EBADF && errno != EFAULT && errno != ENOMEM
-                      && errno != ENOTSOCK);
+    errno_assert (errno != EBADF && errno != EFAULT && errno != ENOMEM
+                  && errno != ENOTSOCK);
+#else
+    errno_assert (errno != EFAULT && errno != ENOMEM && errno != ENOTSOCK);
+#endif
+    if (errno == EWOULDBLOCK || errno == EINTR)
+        errno = EAGAIN;
+
+#endif
+}
+
+int zmq::tcp_read (fd_t s_, void *data_, size_t size_)
+{
+#ifdef ZMQ_HAVE_WINDOWS
+
+    const int rc =
+      recv (s_, static_cast<char *> (data_), static_cast<int> (size_), 0);
+    if (rc == SOCKET_ERROR) {
+        read_error ();
+        return -1;
+    }
+    return rc;
+
 #else
-        errno_assert (errno != EFAULT && errno != ENOMEM && errno != ENOTSOCK);
+
+    const ssize_t rc = recv (s_, static_cast<char *> (data_), size_, 0);
+    if (rc == -1)
+        read_error ();
+    return static_cast<int> (rc);
+
 #endif
-        if (errno == EWOULDBLOCK || errno == EINTR)
-            errno = EAGAIN;
+}
+
+int zmq::tcp_readv (fd_t s_,
+                    void *data_,
+                    size_t size_,
+                    void *next_data_,
+                    size_t next_size_)
+{
+#ifdef ZMQ_HAVE_WINDOWS
+
+    WSABUF buffers[2];
+    buffers[0].buf = static_cast<char *> (data_);
+    buffers[0].len = static_cast<ULONG> (size_);
+    buffers[1].buf = static_cast<char *> (next_data_);
+    buffers[1].len = static_cast<ULONG> (next_size_);
+    DWORD nbytes = 0;
+    DWORD flags = 0;
+    const int rc = WSARecv (s_, buffers, 2, &nbytes, &flags, NULL, NULL);
+    if (rc == SOCKET_ERROR) {
+        read_error ();
+        return -1;
     }
+    return static_cast<int> (nbytes);
 
+#else
+
+    struct iovec buffers[2];
+    buffers[0].iov_base = data_;
+    buffers[0].iov_len = size_;
+    buffers[1].iov_base = next_data_;
+    buffers[1].iov_len = next_size_;
+    const ssize_t rc = readv (s_, buffers, 2);
+    if (rc == -1)
+        read_error ();
     return static_cast<int> (rc);
 
 #endif
@@ -329,6 +377,30 @@ void zmq::tune_tcp_busy_poll (fd_t socket_, int busy_poll_)
 #endif
 }
 
+void zmq::tune_tcp_fastopen (fd_t socket_, bool listener_, int queue_size_)
+{
+    //  Older kernels refuse the options with ENOPROTOOPT, in which case
+    //  connections are simply established the usual way.
+#if defined(TCP_FASTOPEN)
+    if (listener_) {
+        setsockopt (socket_, IPPROTO_TCP, TCP_FASTOPEN,
+                    reinterpret_cast<char *> (&queue_size_), sizeof (int));
+        return;
+    }
+#endif
+#if defined(TCP_FASTOPEN_CONNECT)
+    if (!listener_) {
+        int flag = 1;
+        setsockopt (socket_, IPPROTO_TCP, TCP_FASTOPEN_CONNECT,
+                    reinterpret_cast<char *> (&flag), sizeof (int));
+        return;
+    }
+#endif
+    LIBZMQ_UNUSED (socket_);
+    LIBZMQ_UNUSED (listener_);
+    LIBZMQ_UNUSED (queue_size_);
+}
+
 zmq::fd_t zmq::tcp_open_socket (const char *address_,
                                 const zmq::options_t &options_,
                                 bool local_,
@@ -336,10 +408,22 @@ zmq::fd_t zmq::tcp_open_socket (const char *address_,
                                 zmq::tcp_address_t *out_tcp_addr_)
 {
     //  Convert the textual address into address structure.
-    int rc = out_tcp_addr_->resolve (address_, local_, options_.ipv6);
+    const int rc = out_tcp_addr_->resolve (address_, local_, options_.ipv6);
     if (rc != 0)
         return retired_fd;
 
+    return tcp_open_resolved_socket (address_, options_, local_,
+                                     fallback_to_ipv4_, out_tcp_addr_);
+}
+
+zmq::fd_t zmq::tcp_open_resolved_socket (const char *address_,
+                                         const zmq::options_t &options_,
+                                         bool local_,
+                                         bool fallback_to_ipv4_,
+                                         zmq::tcp_address_t *out_tcp_addr_)
+{
+    int rc;
+
     //  Create the socket.
     fd_t s = open_socket (out_tcp_addr_->family (), SOCK_STREAM, IPPROTO_TCP);
 
@@ -39,10 +39,21 @@ int tcp_write (fd_t s_, const void *data_, size_t size_);
 //  Zero indicates the peer has closed the connection.
 int tcp_read (fd_t s_, void *data_, size_t size_);
 
+//  Like tcp_read, but fills next_data_ once data_ is full, so that
+//  both are filled with a single system call.
+int tcp_readv (
+  fd_t s_, void *data_, size_t size_, void *next_data_, size_t next_size_);
+
 void tcp_tune_loopback_fast_path (fd_t socket_);
 
 void tune_tcp_busy_poll (fd_t socket_, int busy_poll_);
 
+//  Enables TCP Fast Open, for a listening socket with a queue of
+//  queue_size_ pending Fast Open connections, or for a socket about to
+//  connect, whose first write then goes out with the SYN. Fast Open is
+//  only an optimisation, so it is silently left off where unsupported.
+void tune_tcp_fastopen (fd_t socket_, bool listener_, int queue_size_);
+
 //  Resolves the given address_ string, opens a socket and sets socket options
 //  according to the passed options_. On success, returns the socket
 //  descriptor and assigns the resolved address to out_tcp_addr_. In case of
@@ -53,6 +64,14 @@ fd_t tcp_open_socket (const char *address_,
                       bool local_,
                       bool fallback_to_ipv4_,
                       tcp_address_t *out_tcp_addr_);
+
+//  Like tcp_open_socket, for an address_ already resolved to out_tcp_addr_.
+//  It is resolved again only to fall back to IPv4.
+fd_t tcp_open_resolved_socket (const char *address_,
+                               const options_t &options_,
+                               bool local_,
+                               bool fallback_to_ipv4_,
+                               tcp_address_t *out_tcp_addr_);
 }
 
 #endif
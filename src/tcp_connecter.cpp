@@ -3,6 +3,7 @@
 #include "precompiled.hpp"
 #include <new>
 #include <string>
+#include <limits.h>
 
 #include "macros.hpp"
 #include "tcp_connecter.hpp"
@@ -13,6 +14,9 @@
 #include "address.hpp"
 #include "tcp_address.hpp"
 #include "session_base.hpp"
+#include "dns_cache.hpp"
+#include "ctx.hpp"
+#include "wire.hpp"
 
 #if !defined ZMQ_HAVE_WINDOWS
 #include <unistd.h>
@@ -42,7 +46,8 @@ zmq::tcp_connecter_t::tcp_connecter_t (class io_thread_t *io_thread_,
                                        bool delayed_start_) :
     stream_connecter_base_t (
       io_thread_, session_, options_, addr_, delayed_start_),
-    _connect_timer_started (false)
+    _connect_timer_started (false),
+    _resolving (false)
 {
     zmq_assert (_addr->protocol == protocol_name::tcp);
 }
@@ -50,6 +55,7 @@ zmq::tcp_connecter_t::tcp_connecter_t (class io_thread_t *io_thread_,
 zmq::tcp_connecter_t::~tcp_connecter_t ()
 {
     zmq_assert (!_connect_timer_started);
+    zmq_assert (!_resolving);
 }
 
 void zmq::tcp_connecter_t::process_term (int linger_)
@@ -59,9 +65,37 @@ void zmq::tcp_connecter_t::process_term (int linger_)
         _connect_timer_started = false;
     }
 
+    //  Unless the lookup can be cancelled in time, its command is on the
+    //  way and the connecter has to stay around until it arrives.
+    if (_resolving) {
+        if (get_ctx ()->get_dns_cache ()->cancel (this))
+            _resolving = false;
+        else
+            register_term_acks (1);
+    }
+
     stream_connecter_base_t::process_term (linger_);
 }
 
+void zmq::tcp_connecter_t::process_resolved (int error_)
+{
+    zmq_assert (_resolving);
+    _resolving = false;
+
+    if (is_terminating ()) {
+        unregister_term_ack ();
+        return;
+    }
+
+    if (error_ != 0) {
+        LIBZMQ_DELETE (_addr->resolved.tcp_addr);
+        add_reconnect_timer ();
+        return;
+    }
+
+    open_and_connect (true);
+}
+
 void zmq::tcp_connecter_t::out_event ()
 {
     if (_connect_timer_started) {
@@ -107,9 +141,35 @@ void zmq::tcp_connecter_t::timer_event (int id_)
 }
 
 void zmq::tcp_connecter_t::start_connecting ()
+{
+    //  If the context caches lookups, the address is resolved by the
+    //  cache, which may have to look it up in the background first.
+    dns_cache_t *const dns_cache = get_ctx ()->get_dns_cache ();
+    if (dns_cache) {
+        if (_addr->resolved.tcp_addr == NULL) {
+            _addr->resolved.tcp_addr = new (std::nothrow) tcp_address_t ();
+            alloc_assert (_addr->resolved.tcp_addr);
+        }
+        const int rc = dns_cache->resolve (_addr->address, options.ipv6, this,
+                                           _addr->resolved.tcp_addr);
+        if (rc == -1 && errno == EINPROGRESS) {
+            _resolving = true;
+            return;
+        }
+        if (rc == -1) {
+            LIBZMQ_DELETE (_addr->resolved.tcp_addr);
+            add_reconnect_timer ();
+            return;
+        }
+    }
+
+    open_and_connect (dns_cache != NULL);
+}
+
+void zmq::tcp_connecter_t::open_and_connect (bool resolved_)
 {
     //  Open the connecting socket.
-    const int rc = open ();
+    const int rc = open (resolved_);
 
     //  Connect may succeed in synchronous manner.
     if (rc == 0) {
@@ -130,8 +190,15 @@ void zmq::tcp_connecter_t::start_connecting ()
 
     //  Handle any other error condition by eventual reconnect.
     else {
+        const bool refused = errno == ECONNREFUSED;
         if (_s != retired_fd)
             close ();
+        if (refused
+            && (options.reconnect_stop & ZMQ_RECONNECT_STOP_CONN_REFUSED)) {
+            send_conn_failed (_session);
+            terminate ();
+            return;
+        }
         add_reconnect_timer ();
     }
 }
@@ -144,19 +211,25 @@ void zmq::tcp_connecter_t::add_connect_timer ()
     }
 }
 
-int zmq::tcp_connecter_t::open ()
+int zmq::tcp_connecter_t::open (bool resolved_)
 {
     zmq_assert (_s == retired_fd);
+    _greeting_bytes_sent = 0;
 
-    //  Resolve the address
-    if (_addr->resolved.tcp_addr != NULL) {
-        LIBZMQ_DELETE (_addr->resolved.tcp_addr);
-    }
+    if (resolved_)
+        _s = tcp_open_resolved_socket (_addr->address.c_str (), options, false,
+                                       true, _addr->resolved.tcp_addr);
+    else {
+        //  Resolve the address
+        if (_addr->resolved.tcp_addr != NULL) {
+            LIBZMQ_DELETE (_addr->resolved.tcp_addr);
+        }
 
-    _addr->resolved.tcp_addr = new (std::nothrow) tcp_address_t ();
-    alloc_assert (_addr->resolved.tcp_addr);
-    _s = tcp_open_socket (_addr->address.c_str (), options, false, true,
-                          _addr->resolved.tcp_addr);
+        _addr->resolved.tcp_addr = new (std::nothrow) tcp_address_t ();
+        alloc_assert (_addr->resolved.tcp_addr);
+        _s = tcp_open_socket (_addr->address.c_str (), options, false, true,
+                              _addr->resolved.tcp_addr);
+    }
     if (_s == retired_fd) {
         //  TODO we should emit some event in this case!
 
@@ -200,11 +273,37 @@ int zmq::tcp_connecter_t::open ()
             return -1;
     }
 
+    //  With Fast Open, connect returns at once and the SYN only goes out
+    //  with the first data written.
+    if (options.tcp_fastopen)
+        tune_tcp_fastopen (_s, false, 0);
+
     //  Connect to the remote peer.
 #if defined ZMQ_HAVE_VXWORKS
     rc = ::connect (_s, (sockaddr *) tcp_addr->addr (), tcp_addr->addrlen ());
 #else
     rc = ::connect (_s, tcp_addr->addr (), tcp_addr->addrlen ());
+#endif
+#if defined TCP_FASTOPEN_CONNECT
+    //  Put the ZMTP signature, which doesn't depend on the peer, on the SYN
+    //  and wait for the connection to be established the usual way, so that
+    //  the connect timeout, refused connections and the monitor events work
+    //  as without Fast Open. Without a cookie for the peer, the SYN goes
+    //  out alone and the engine sends the whole greeting later.
+    if (rc == 0 && options.tcp_fastopen && !options.raw_socket) {
+        unsigned char signature[10];
+        signature[0] = UCHAR_MAX;
+        put_uint64 (signature + 1, options.routing_id_size + 1);
+        signature[9] = 0x7f;
+        const ssize_t nbytes =
+          ::send (_s, signature, sizeof signature, MSG_NOSIGNAL);
+        if (nbytes > 0)
+            _greeting_bytes_sent = static_cast<size_t> (nbytes);
+        else if (errno != EINPROGRESS && errno != EAGAIN)
+            return -1;
+        errno = EINPROGRESS;
+        return -1;
+    }
 #endif
     //  Connect was successful immediately.
     if (rc == 0) {
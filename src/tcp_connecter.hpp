@@ -30,6 +30,7 @@ class tcp_connecter_t ZMQ_FINAL : public stream_connecter_base_t
 
     //  Handlers for incoming commands.
     void process_term (int linger_);
+    void process_resolved (int error_);
 
     //  Handlers for I/O events.
     void out_event ();
@@ -38,13 +39,17 @@ class tcp_connecter_t ZMQ_FINAL : public stream_connecter_base_t
     //  Internal function to start the actual connection establishment.
     void start_connecting ();
 
+    //  Opens the socket and starts connecting it. If resolved_ is true, the
+    //  address has been looked up already.
+    void open_and_connect (bool resolved_);
+
     //  Internal function to add a connect timer
     void add_connect_timer ();
 
     //  Open TCP connecting socket. Returns -1 in case of error,
     //  0 if connect was successful immediately. Returns -1 with
     //  EAGAIN errno if async connect was launched.
-    int open ();
+    int open (bool resolved_);
 
     //  Get the file descriptor of newly created connection. Returns
     //  retired_fd if the connection was unsuccessful.
@@ -56,6 +61,9 @@ class tcp_connecter_t ZMQ_FINAL : public stream_connecter_base_t
     //  True iff a timer has been started.
     bool _connect_timer_started;
 
+    //  True iff the connecter waits for the context's DNS cache.
+    bool _resolving;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (tcp_connecter_t)
 };
 }
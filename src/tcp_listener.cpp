@@ -121,6 +121,10 @@ int zmq::tcp_listener_t::create_socket (const char *addr_)
         goto error;
 #endif
 
+    //  Accept data on the SYN from peers that have a Fast Open cookie.
+    if (options.tcp_fastopen)
+        tune_tcp_fastopen (_s, true, options.backlog);
+
     //  Listen for incoming connections.
     rc = listen (_s, options.backlog);
 #ifdef ZMQ_HAVE_WINDOWS
@@ -12,8 +12,10 @@
 #include "wire.hpp"
 #include "err.hpp"
 
-zmq::v1_decoder_t::v1_decoder_t (size_t bufsize_, int64_t maxmsgsize_) :
-    decoder_base_t<v1_decoder_t> (bufsize_), _max_msg_size (maxmsgsize_)
+zmq::v1_decoder_t::v1_decoder_t (size_t bufsize_,
+                                 int64_t maxmsgsize_,
+                                 const allocator_t &hooks_) :
+    decoder_base_t<v1_decoder_t> (bufsize_, hooks_), _max_msg_size (maxmsgsize_)
 {
     int rc = _in_progress.init ();
     errno_assert (rc == 0);
@@ -50,7 +52,7 @@ int zmq::v1_decoder_t::one_byte_size_ready (unsigned char const *)
 
         int rc = _in_progress.close ();
         assert (rc == 0);
-        rc = _in_progress.init_size (*_tmpbuf - 1);
+        rc = _in_progress.init_size (*_tmpbuf - 1, get_allocator ().hooks ());
         if (rc != 0) {
             errno_assert (errno == ENOMEM);
             rc = _in_progress.init ();
@@ -95,7 +97,7 @@ int zmq::v1_decoder_t::eight_byte_size_ready (unsigned char const *)
 
     int rc = _in_progress.close ();
     assert (rc == 0);
-    rc = _in_progress.init_size (msg_size);
+    rc = _in_progress.init_size (msg_size, get_allocator ().hooks ());
     if (rc != 0) {
         errno_assert (errno == ENOMEM);
         rc = _in_progress.init ();
@@ -12,7 +12,7 @@ namespace zmq
 class v1_encoder_t ZMQ_FINAL : public encoder_base_t<v1_encoder_t>
 {
   public:
-    v1_encoder_t (size_t bufsize_);
+    v1_encoder_t (size_t bufsize_, const allocator_t &hooks_);
     ~v1_encoder_t ();
 
   private:
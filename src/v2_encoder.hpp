@@ -12,7 +12,7 @@ namespace zmq
 class v2_encoder_t ZMQ_FINAL : public encoder_base_t<v2_encoder_t>
 {
   public:
-    v2_encoder_t (size_t bufsize_);
+    v2_encoder_t (size_t bufsize_, const allocator_t &hooks_);
     ~v2_encoder_t ();
 
   private:
@@ -13,7 +13,7 @@ namespace zmq
 class v3_1_encoder_t ZMQ_FINAL : public encoder_base_t<v3_1_encoder_t>
 {
   public:
-    v3_1_encoder_t (size_t bufsize_);
+    v3_1_encoder_t (size_t bufsize_, const allocator_t &hooks_);
     ~v3_1_encoder_t () ZMQ_FINAL;
 
   private:
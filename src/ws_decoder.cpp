@@ -4,23 +4,46 @@
 #include <stdlib.h>
 #include <string.h>
 #include <cmath>
+#include <new>
 
 #include "ws_protocol.hpp"
 #include "ws_decoder.hpp"
+#include "ws_mask.hpp"
 #include "likely.hpp"
 #include "wire.hpp"
 #include "err.hpp"
 
+#ifdef ZMQ_HAVE_WS_DEFLATE
+#include "ws_deflate.hpp"
+#endif
+
+namespace
+{
+//  Buffers for fragmented messages larger than this are released once
+//  the message is complete.
+const size_t max_kept_fragments_size = 256 * 1024;
+}
+
 zmq::ws_decoder_t::ws_decoder_t (size_t bufsize_,
                                  int64_t maxmsgsize_,
                                  bool zero_copy_,
-                                 bool must_mask_) :
-    decoder_base_t<ws_decoder_t, shared_message_memory_allocator> (bufsize_),
+                                 bool must_mask_,
+                                 const allocator_t &hooks_,
+                                 ws_inflate_t *inflate_) :
+    decoder_base_t<ws_decoder_t, shared_message_memory_allocator> (bufsize_,
+                                                                   hooks_),
     _msg_flags (0),
     _zero_copy (zero_copy_),
     _max_msg_size (maxmsgsize_),
     _must_mask (must_mask_),
-    _size (0)
+    _size (0),
+    _final (false),
+    _is_fragment (false),
+    _fragmented (false),
+    _fragments_deflated (false),
+    _fragment_pos (0),
+    _inflate (inflate_),
+    _is_deflated (false)
 {
     memset (_tmpbuf, 0, sizeof (_tmpbuf));
     int rc = _in_progress.init ();
@@ -34,20 +57,43 @@ zmq::ws_decoder_t::~ws_decoder_t ()
 {
     const int rc = _in_progress.close ();
     errno_assert (rc == 0);
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    delete _inflate;
+#endif
 }
 
 int zmq::ws_decoder_t::opcode_ready (unsigned char const *)
 {
-    const bool final = (_tmpbuf[0] & 0x80) != 0; // final bit
-    if (!final)
-        return -1; // non final messages are not supported
+    //  RSV2 and RSV3 belong to no extension we agree on.
+    if (_tmpbuf[0] & 0x30)
+        return -1;
 
+    _final = (_tmpbuf[0] & 0x80) != 0;
     _opcode = static_cast<zmq::ws_protocol_t::opcode_t> (_tmpbuf[0] & 0xF);
 
+    //  Only the first frame of a binary message is marked as compressed,
+    //  and only if that was agreed on.
+    const bool rsv1 = (_tmpbuf[0] & ws_protocol_t::rsv1_flag) != 0;
+    _is_deflated = false;
+    _is_fragment = false;
     _msg_flags = 0;
 
     switch (_opcode) {
         case zmq::ws_protocol_t::opcode_binary:
+            //  The previous message must be complete.
+            if (_fragmented || (rsv1 && !_inflate))
+                return -1;
+            _is_deflated = rsv1;
+            if (!_final) {
+                _fragmented = true;
+                _fragments_deflated = rsv1;
+                _is_fragment = true;
+            }
+            break;
+        case zmq::ws_protocol_t::opcode_continuation:
+            if (!_fragmented || rsv1)
+                return -1;
+            _is_fragment = true;
             break;
         case zmq::ws_protocol_t::opcode_close:
             _msg_flags = msg_t::command | msg_t::close_cmd;
@@ -62,6 +108,11 @@ int zmq::ws_decoder_t::opcode_ready (unsigned char const *)
             return -1;
     }
 
+    //  Control frames may come between the fragments of a message, but
+    //  are never fragmented themselves.
+    if (!_is_fragment && (!_final || (rsv1 && !_is_deflated)))
+        return -1;
+
     next_step (_tmpbuf, 1, &ws_decoder_t::size_first_byte_ready);
 
     return 0;
@@ -79,12 +130,8 @@ int zmq::ws_decoder_t::size_first_byte_ready (unsigned char const *read_from_)
     if (_size < 126) {
         if (_must_mask)
             next_step (_tmpbuf, 4, &ws_decoder_t::mask_ready);
-        else if (_opcode == ws_protocol_t::opcode_binary) {
-            if (_size == 0)
-                return -1;
-            next_step (_tmpbuf, 1, &ws_decoder_t::flags_ready);
-        } else
-            return size_ready (read_from_);
+        else
+            return header_ready (read_from_);
     } else if (_size == 126)
         next_step (_tmpbuf, 2, &ws_decoder_t::short_size_ready);
     else
@@ -100,12 +147,8 @@ int zmq::ws_decoder_t::short_size_ready (unsigned char const *read_from_)
 
     if (_must_mask)
         next_step (_tmpbuf, 4, &ws_decoder_t::mask_ready);
-    else if (_opcode == ws_protocol_t::opcode_binary) {
-        if (_size == 0)
-            return -1;
-        next_step (_tmpbuf, 1, &ws_decoder_t::flags_ready);
-    } else
-        return size_ready (read_from_);
+    else
+        return header_ready (read_from_);
 
     return 0;
 }
@@ -118,12 +161,8 @@ int zmq::ws_decoder_t::long_size_ready (unsigned char const *read_from_)
 
     if (_must_mask)
         next_step (_tmpbuf, 4, &ws_decoder_t::mask_ready);
-    else if (_opcode == ws_protocol_t::opcode_binary) {
-        if (_size == 0)
-            return -1;
-        next_step (_tmpbuf, 1, &ws_decoder_t::flags_ready);
-    } else
-        return size_ready (read_from_);
+    else
+        return header_ready (read_from_);
 
     return 0;
 }
@@ -132,15 +171,23 @@ int zmq::ws_decoder_t::mask_ready (unsigned char const *read_from_)
 {
     memcpy (_mask, _tmpbuf, 4);
 
-    if (_opcode == ws_protocol_t::opcode_binary) {
+    return header_ready (read_from_);
+}
+
+int zmq::ws_decoder_t::header_ready (unsigned char const *read_from_)
+{
+    if (_is_fragment)
+        return fragment_size_ready ();
+
+    if (_opcode == ws_protocol_t::opcode_binary && !_is_deflated) {
         if (_size == 0)
             return -1;
 
         next_step (_tmpbuf, 1, &ws_decoder_t::flags_ready);
-    } else
-        return size_ready (read_from_);
+        return 0;
+    }
 
-    return 0;
+    return size_ready (read_from_);
 }
 
 int zmq::ws_decoder_t::flags_ready (unsigned char const *read_from_)
@@ -162,22 +209,98 @@ int zmq::ws_decoder_t::flags_ready (unsigned char const *read_from_)
     return size_ready (read_from_);
 }
 
-
-int zmq::ws_decoder_t::size_ready (unsigned char const *read_pos_)
+int zmq::ws_decoder_t::check_size (uint64_t size_, bool deflated_)
 {
-    //  Message size must not exceed the maximum allowed size.
-    if (_max_msg_size >= 0)
-        if (unlikely (_size > static_cast<uint64_t> (_max_msg_size))) {
+    //  Message size must not exceed the maximum allowed size. Compressed
+    //  messages also hold the flags byte, and data that doesn't compress
+    //  grows by up to 5 bytes per 16 KB block.
+    if (_max_msg_size >= 0) {
+        uint64_t max_size = static_cast<uint64_t> (_max_msg_size);
+        if (deflated_)
+            max_size += 1 + 5 * (max_size / 16384 + 1);
+        if (unlikely (size_ > max_size)) {
             errno = EMSGSIZE;
             return -1;
         }
+    }
 
     //  Message size must fit into size_t data type.
-    if (unlikely (_size != static_cast<size_t> (_size))) {
+    if (unlikely (size_ != static_cast<size_t> (size_))) {
         errno = EMSGSIZE;
         return -1;
     }
 
+    return 0;
+}
+
+int zmq::ws_decoder_t::fragment_size_ready ()
+{
+    //  The payload so far, flags byte included unless compressed.
+    const uint64_t size = _fragments.size () + _size;
+    if (size < _size
+        || check_size (_fragments_deflated || size == 0 ? size : size - 1,
+                       _fragments_deflated)
+             != 0) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    _fragment_pos = _fragments.size ();
+    try {
+        _fragments.resize (static_cast<size_t> (size));
+    }
+    catch (const std::bad_alloc &) {
+        errno = ENOMEM;
+        return -1;
+    }
+    next_step (_fragments.empty () ? _tmpbuf : &_fragments[0] + _fragment_pos,
+               static_cast<size_t> (_size), &ws_decoder_t::fragment_ready);
+
+    return 0;
+}
+
+int zmq::ws_decoder_t::fragment_ready (unsigned char const *)
+{
+    if (_must_mask && _size > 0)
+        ws_mask (&_fragments[_fragment_pos], &_fragments[_fragment_pos],
+                 static_cast<size_t> (_size), _mask, 0);
+
+    if (!_final) {
+        next_step (_tmpbuf, 1, &ws_decoder_t::opcode_ready);
+        return 0;
+    }
+
+    //  The last fragment completes the message.
+    _fragmented = false;
+    _msg_flags = 0;
+    int rc;
+    if (_fragments_deflated)
+        rc = _fragments.empty () ? -1
+                                 : inflate_message (&_fragments[0],
+                                                    _fragments.size ());
+    else
+        rc = _fragments.empty ()
+               ? -1
+               : load_payload (&_fragments[0], _fragments.size ());
+
+    //  Don't keep the memory of the largest message around.
+    if (_fragments.capacity () > max_kept_fragments_size)
+        std::vector<unsigned char> ().swap (_fragments);
+    else
+        _fragments.clear ();
+
+    if (rc != 0)
+        return -1;
+
+    next_step (_tmpbuf, 1, &ws_decoder_t::opcode_ready);
+    return 1;
+}
+
+int zmq::ws_decoder_t::size_ready (unsigned char const *read_pos_)
+{
+    if (check_size (_size, _is_deflated) != 0)
+        return -1;
+
     int rc = _in_progress.close ();
     assert (rc == 0);
 
@@ -193,7 +316,8 @@ int zmq::ws_decoder_t::size_ready (unsigned char const *read_pos_)
         // a new message has started, but the size would exceed the pre-allocated arena
         // (or read_pos_ is in the initial handshake buffer)
         // this happens every time when a message does not fit completely into the buffer
-        rc = _in_progress.init_size (static_cast<size_t> (_size));
+        rc = _in_progress.init_size (static_cast<size_t> (_size),
+                                     allocator.hooks ());
     } else {
         // construct message using n bytes from the buffer as storage
         // increase buffer ref count
@@ -234,16 +358,73 @@ int zmq::ws_decoder_t::size_ready (unsigned char const *read_pos_)
 int zmq::ws_decoder_t::message_ready (unsigned char const *)
 {
     if (_must_mask) {
-        int mask_index = _opcode == ws_protocol_t::opcode_binary ? 1 : 0;
+        //  The flags byte of binary frames took the first mask byte,
+        //  unless it is compressed along with the body.
+        const size_t mask_index =
+          _opcode == ws_protocol_t::opcode_binary && !_is_deflated ? 1 : 0;
 
         unsigned char *data =
           static_cast<unsigned char *> (_in_progress.data ());
-        for (size_t i = 0; i < _size; ++i, mask_index++)
-            data[i] = data[i] ^ _mask[mask_index % 4];
+        ws_mask (data, data, static_cast<size_t> (_size), _mask, mask_index);
     }
 
+    if (_is_deflated
+        && inflate_message (
+             static_cast<const unsigned char *> (_in_progress.data ()),
+             _in_progress.size ())
+             != 0)
+        return -1;
+
     //  Message is completely read. Signal this to the caller
     //  and prepare to decode next message.
     next_step (_tmpbuf, 1, &ws_decoder_t::opcode_ready);
     return 1;
 }
+
+int zmq::ws_decoder_t::inflate_message (const unsigned char *data_,
+                                        size_t size_)
+{
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    //  The decompressed payload holds the flags byte and the body.
+    const size_t max_size =
+      _max_msg_size >= 0
+          && static_cast<uint64_t> (_max_msg_size) < static_cast<size_t> (-1)
+        ? static_cast<size_t> (_max_msg_size) + 1
+        : static_cast<size_t> (-1);
+    if (_inflate->decompress (data_, size_, max_size) != 0)
+        return -1;
+    if (_inflate->size () == 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    return load_payload (_inflate->data (), _inflate->size ());
+#else
+    LIBZMQ_UNUSED (data_);
+    LIBZMQ_UNUSED (size_);
+    errno = EPROTO;
+    return -1;
+#endif
+}
+
+int zmq::ws_decoder_t::load_payload (const unsigned char *data_, size_t size_)
+{
+    const unsigned char flags = data_[0];
+    if (flags & ws_protocol_t::more_flag)
+        _msg_flags |= msg_t::more;
+    if (flags & ws_protocol_t::command_flag)
+        _msg_flags |= msg_t::command;
+
+    int rc = _in_progress.close ();
+    assert (rc == 0);
+    rc = _in_progress.init_size (size_ - 1, get_allocator ().hooks ());
+    if (unlikely (rc)) {
+        errno_assert (errno == ENOMEM);
+        rc = _in_progress.init ();
+        errno_assert (rc == 0);
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy (_in_progress.data (), data_ + 1, size_ - 1);
+    _in_progress.set_flags (_msg_flags);
+    return 0;
+}
@@ -7,11 +7,18 @@
 #include "decoder_allocators.hpp"
 #include "ws_protocol.hpp"
 
+#include <vector>
+
 namespace zmq
 {
+class ws_inflate_t;
+
 //  Decoder for Web socket framing protocol. Converts data stream into messages.
 //  The class has to inherit from shared_message_memory_allocator because
 //  the base class calls allocate in its constructor.
+//  If given a decompressor, which it takes ownership of, it accepts
+//  messages compressed with permessage-deflate. Messages split into
+//  continuation frames are put back together.
 class ws_decoder_t ZMQ_FINAL
     : public decoder_base_t<ws_decoder_t, shared_message_memory_allocator>
 {
@@ -19,7 +26,9 @@ class ws_decoder_t ZMQ_FINAL
     ws_decoder_t (size_t bufsize_,
                   int64_t maxmsgsize_,
                   bool zero_copy_,
-                  bool must_mask_);
+                  bool must_mask_,
+                  const allocator_t &hooks_,
+                  ws_inflate_t *inflate_ = NULL);
     ~ws_decoder_t ();
 
     //  i_decoder interface.
@@ -34,7 +43,14 @@ class ws_decoder_t ZMQ_FINAL
     int flags_ready (unsigned char const *);
     int message_ready (unsigned char const *);
 
+    int header_ready (unsigned char const *);
+    int fragment_ready (unsigned char const *);
+
     int size_ready (unsigned char const *);
+    int fragment_size_ready ();
+    int check_size (uint64_t size_, bool deflated_);
+    int inflate_message (const unsigned char *data_, size_t size_);
+    int load_payload (const unsigned char *data_, size_t size_);
 
     unsigned char _tmpbuf[8];
     unsigned char _msg_flags;
@@ -47,6 +63,21 @@ class ws_decoder_t ZMQ_FINAL
     zmq::ws_protocol_t::opcode_t _opcode;
     unsigned char _mask[4];
 
+    //  Whether the current frame is the last of its message, and whether
+    //  it belongs to a message split into several frames.
+    bool _final;
+    bool _is_fragment;
+
+    //  The payload of a message split into frames, received so far, and
+    //  where the current frame starts in it.
+    bool _fragmented;
+    bool _fragments_deflated;
+    std::vector<unsigned char> _fragments;
+    size_t _fragment_pos;
+
+    ws_inflate_t *const _inflate;
+    bool _is_deflated;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (ws_decoder_t)
 };
 }
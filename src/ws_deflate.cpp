@@ -0,0 +1,319 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "ws_deflate.hpp"
+#include "msg.hpp"
+#include "err.hpp"
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+namespace
+{
+//  zlib counts bytes in unsigned int.
+const size_t max_chunk_size = 1 << 30;
+
+//  Buffers larger than this are released once the message is done, so
+//  that a connection doesn't keep the memory of its largest message.
+const size_t max_kept_buffer_size = 256 * 1024;
+
+const size_t initial_buffer_size = 4096;
+
+std::string trim (const std::string &s_)
+{
+    const size_t begin = s_.find_first_not_of (" \t");
+    if (begin == std::string::npos)
+        return std::string ();
+    const size_t end = s_.find_last_not_of (" \t");
+    return s_.substr (begin, end - begin + 1);
+}
+
+bool equals_ignoring_case (const std::string &s_, const char *literal_)
+{
+    const size_t length = strlen (literal_);
+    if (s_.size () != length)
+        return false;
+    for (size_t i = 0; i != length; i++)
+        if (tolower (static_cast<unsigned char> (s_[i]))
+            != tolower (static_cast<unsigned char> (literal_[i])))
+            return false;
+    return true;
+}
+
+//  Parses a window size of 8 to 15, possibly quoted.
+bool parse_window_bits (std::string value_, int *bits_)
+{
+    if (value_.size () >= 2 && value_[0] == '"'
+        && value_[value_.size () - 1] == '"')
+        value_ = value_.substr (1, value_.size () - 2);
+    if (value_.size () == 1 && value_[0] == '8')
+        *bits_ = 8;
+    else if (value_.size () == 1 && value_[0] == '9')
+        *bits_ = 9;
+    else if (value_.size () == 2 && value_[0] == '1' && value_[1] >= '0'
+             && value_[1] <= '5')
+        *bits_ = 10 + (value_[1] - '0');
+    else
+        return false;
+    return true;
+}
+}
+
+zmq::ws_deflate_params_t::ws_deflate_params_t () :
+    server_no_context_takeover (false),
+    client_no_context_takeover (false),
+    server_max_window_bits (0),
+    client_max_window_bits (0)
+{
+}
+
+bool zmq::ws_deflate_params_t::parse (const char *extension_)
+{
+    *this = ws_deflate_params_t ();
+
+    const std::string extension (extension_);
+    size_t pos = extension.find (';');
+    if (!equals_ignoring_case (trim (extension.substr (0, pos)),
+                               "permessage-deflate"))
+        return false;
+
+    while (pos != std::string::npos) {
+        const size_t next = extension.find (';', pos + 1);
+        const std::string param =
+          trim (extension.substr (pos + 1, next == std::string::npos
+                                             ? std::string::npos
+                                             : next - pos - 1));
+        pos = next;
+
+        const size_t equals = param.find ('=');
+        const std::string name = trim (param.substr (0, equals));
+        const bool has_value = equals != std::string::npos;
+        const std::string value =
+          has_value ? trim (param.substr (equals + 1)) : std::string ();
+
+        if (equals_ignoring_case (name, "server_no_context_takeover")) {
+            if (has_value || server_no_context_takeover)
+                return false;
+            server_no_context_takeover = true;
+        } else if (equals_ignoring_case (name, "client_no_context_takeover")) {
+            if (has_value || client_no_context_takeover)
+                return false;
+            client_no_context_takeover = true;
+        } else if (equals_ignoring_case (name, "server_max_window_bits")) {
+            if (server_max_window_bits
+                || !parse_window_bits (value, &server_max_window_bits))
+                return false;
+        } else if (equals_ignoring_case (name, "client_max_window_bits")) {
+            if (client_max_window_bits)
+                return false;
+            if (!has_value)
+                client_max_window_bits = -1;
+            else if (!parse_window_bits (value, &client_max_window_bits))
+                return false;
+        } else
+            return false;
+    }
+    return true;
+}
+
+int zmq::ws_deflate_params_t::format (char *buf_, size_t size_) const
+{
+    const int written = snprintf (
+      buf_, size_, "permessage-deflate%s%s",
+      server_no_context_takeover ? "; server_no_context_takeover" : "",
+      client_no_context_takeover ? "; client_no_context_takeover" : "");
+    zmq_assert (written > 0 && static_cast<size_t> (written) < size_);
+    int length = written;
+
+    if (server_max_window_bits > 0)
+        length += snprintf (buf_ + length, size_ - length,
+                            "; server_max_window_bits=%d",
+                            server_max_window_bits);
+    if (client_max_window_bits > 0)
+        length += snprintf (buf_ + length, size_ - length,
+                            "; client_max_window_bits=%d",
+                            client_max_window_bits);
+    else if (client_max_window_bits < 0)
+        length +=
+          snprintf (buf_ + length, size_ - length, "; client_max_window_bits");
+    zmq_assert (static_cast<size_t> (length) < size_);
+    return length;
+}
+
+zmq::ws_deflate_t::ws_deflate_t (int window_bits_, bool no_context_takeover_) :
+    _no_context_takeover (no_context_takeover_), _buffer_used (0)
+{
+    //  zlib produces raw deflate data for negative window sizes. It can't
+    //  compress with a window of 256 bytes, which is never agreed on.
+    zmq_assert (window_bits_ >= 9 && window_bits_ <= 15);
+    memset (&_stream, 0, sizeof _stream);
+    const int rc = deflateInit2 (&_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                 -window_bits_, 8, Z_DEFAULT_STRATEGY);
+    alloc_assert (rc != Z_MEM_ERROR);
+    zmq_assert (rc == Z_OK);
+}
+
+zmq::ws_deflate_t::~ws_deflate_t ()
+{
+    deflateEnd (&_stream);
+}
+
+void zmq::ws_deflate_t::compress (const unsigned char *head_,
+                                  size_t head_size_,
+                                  const unsigned char *body_,
+                                  size_t body_size_,
+                                  msg_t *out_)
+{
+    _buffer_used = 0;
+    if (_buffer.size () < initial_buffer_size)
+        _buffer.resize (initial_buffer_size);
+
+    if (head_size_)
+        deflate_chunk (head_, head_size_, Z_NO_FLUSH);
+    deflate_chunk (body_, body_size_, Z_SYNC_FLUSH);
+
+    //  A sync flush ends in an empty stored block, 00 00 ff ff, which is
+    //  left out on the wire.
+    zmq_assert (_buffer_used >= 4);
+    const size_t size = _buffer_used - 4;
+
+    int rc = out_->close ();
+    errno_assert (rc == 0);
+    rc = out_->init_size (size);
+    errno_assert (rc == 0);
+    memcpy (out_->data (), &_buffer[0], size);
+
+    if (_no_context_takeover) {
+        rc = deflateReset (&_stream);
+        zmq_assert (rc == Z_OK);
+    }
+    if (_buffer.size () > max_kept_buffer_size)
+        std::vector<unsigned char> ().swap (_buffer);
+}
+
+void zmq::ws_deflate_t::deflate_chunk (const unsigned char *data_,
+                                       size_t size_,
+                                       int flush_)
+{
+    do {
+        const size_t chunk = std::min (size_, max_chunk_size);
+        _stream.next_in = const_cast<Bytef *> (data_);
+        _stream.avail_in = static_cast<uInt> (chunk);
+        data_ += chunk;
+        size_ -= chunk;
+        const int flush = size_ ? Z_NO_FLUSH : flush_;
+
+        //  Keep going while there is input, or output that didn't fit.
+        do {
+            if (_buffer.size () - _buffer_used < 64)
+                _buffer.resize (_buffer.size () * 2);
+            const size_t avail =
+              std::min (_buffer.size () - _buffer_used, max_chunk_size);
+            _stream.next_out = &_buffer[_buffer_used];
+            _stream.avail_out = static_cast<uInt> (avail);
+            const int rc = deflate (&_stream, flush);
+            zmq_assert (rc == Z_OK || rc == Z_BUF_ERROR);
+            _buffer_used += avail - _stream.avail_out;
+        } while (_stream.avail_in > 0 || _stream.avail_out == 0);
+    } while (size_);
+}
+
+zmq::ws_inflate_t::ws_inflate_t (bool no_context_takeover_) :
+    _no_context_takeover (no_context_takeover_), _size (0)
+{
+    //  The largest window decompresses data compressed with any window.
+    memset (&_stream, 0, sizeof _stream);
+    const int rc = inflateInit2 (&_stream, -15);
+    alloc_assert (rc != Z_MEM_ERROR);
+    zmq_assert (rc == Z_OK);
+}
+
+zmq::ws_inflate_t::~ws_inflate_t ()
+{
+    inflateEnd (&_stream);
+}
+
+int zmq::ws_inflate_t::decompress (const unsigned char *data_,
+                                   size_t size_,
+                                   size_t max_size_)
+{
+    //  The end of the sync flush the sender left out.
+    static const unsigned char trailer[4] = {0x00, 0x00, 0xff, 0xff};
+
+    if (_buffer.size () > max_kept_buffer_size)
+        std::vector<unsigned char> ().swap (_buffer);
+    if (_buffer.empty ())
+        _buffer.resize (initial_buffer_size);
+    _size = 0;
+
+    int rc = inflate_chunk (data_, size_, max_size_);
+    if (rc == 0)
+        rc = inflate_chunk (trailer, sizeof trailer, max_size_);
+
+    //  After an error the connection is closed, resetting just frees the
+    //  memory of the window early.
+    if (rc != 0 || _no_context_takeover) {
+        const int reset_rc = inflateReset (&_stream);
+        zmq_assert (reset_rc == Z_OK);
+    }
+    return rc;
+}
+
+int zmq::ws_inflate_t::inflate_chunk (const unsigned char *data_,
+                                      size_t size_,
+                                      size_t max_size_)
+{
+    //  One byte more than allowed to tell a message that is too large
+    //  from one that fills the limit exactly.
+    const size_t limit =
+      max_size_ < static_cast<size_t> (-1) ? max_size_ + 1 : max_size_;
+
+    while (size_ > 0) {
+        const size_t chunk = std::min (size_, max_chunk_size);
+        _stream.next_in = const_cast<Bytef *> (data_);
+        _stream.avail_in = static_cast<uInt> (chunk);
+        data_ += chunk;
+        size_ -= chunk;
+
+        do {
+            if (_size == _buffer.size ()) {
+                if (_size >= limit) {
+                    errno = EMSGSIZE;
+                    return -1;
+                }
+                _buffer.resize (std::min (_buffer.size () * 2, limit));
+            }
+            const size_t avail =
+              std::min (_buffer.size () - _size, max_chunk_size);
+            _stream.next_out = &_buffer[_size];
+            _stream.avail_out = static_cast<uInt> (avail);
+            const int rc = inflate (&_stream, Z_SYNC_FLUSH);
+            _size += avail - _stream.avail_out;
+
+            if (rc == Z_STREAM_END) {
+                //  The sender finished its stream, whatever follows starts
+                //  a new one.
+                const int reset_rc = inflateReset (&_stream);
+                zmq_assert (reset_rc == Z_OK);
+            } else if (rc == Z_MEM_ERROR) {
+                errno = ENOMEM;
+                return -1;
+            } else if (rc != Z_OK
+                       && (rc != Z_BUF_ERROR
+                           || (_stream.avail_in > 0 && _stream.avail_out > 0))) {
+                errno = EPROTO;
+                return -1;
+            }
+        } while (_stream.avail_in > 0 || _stream.avail_out == 0);
+    }
+
+    if (_size > max_size_) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_WS_DEFLATE_HPP_INCLUDED__
+#define __ZMQ_WS_DEFLATE_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include <zlib.h>
+
+#include "macros.hpp"
+
+namespace zmq
+{
+class msg_t;
+
+//  Parameters of the permessage-deflate extension (RFC 7692) as offered
+//  in a Sec-WebSocket-Extensions request header or agreed on in the
+//  response.
+struct ws_deflate_params_t
+{
+    ws_deflate_params_t ();
+
+    //  Parses one extension of the header, e.g.
+    //  "permessage-deflate; client_max_window_bits". Returns false if it
+    //  is another extension or has parameters that are unknown, repeated
+    //  or out of range.
+    bool parse (const char *extension_);
+
+    //  Writes the parameters in header syntax, returns the length.
+    int format (char *buf_, size_t size_) const;
+
+    bool server_no_context_takeover;
+    bool client_no_context_takeover;
+
+    //  Largest LZ77 window the server or client compresses with, as the
+    //  base 2 logarithm. 0 means not given. In an offer, a client max
+    //  window of -1 means the client accepts a limit without asking for
+    //  one.
+    int server_max_window_bits;
+    int client_max_window_bits;
+};
+
+//  Compresses the messages sent on a connection with the extension. With
+//  context takeover, each message refers back to the ones before it.
+
+class ws_deflate_t
+{
+  public:
+    ws_deflate_t (int window_bits_, bool no_context_takeover_);
+    ~ws_deflate_t ();
+
+    //  Compresses head_ followed by body_ into out_, without the trailer
+    //  that the receiver adds back. out_ must be initialised.
+    void compress (const unsigned char *head_,
+                   size_t head_size_,
+                   const unsigned char *body_,
+                   size_t body_size_,
+                   msg_t *out_);
+
+  private:
+    void deflate_chunk (const unsigned char *data_, size_t size_, int flush_);
+
+    z_stream _stream;
+    const bool _no_context_takeover;
+
+    //  Output of the message being compressed.
+    std::vector<unsigned char> _buffer;
+    size_t _buffer_used;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (ws_deflate_t)
+};
+
+//  Decompresses the messages received on a connection with the extension.
+
+class ws_inflate_t
+{
+  public:
+    explicit ws_inflate_t (bool no_context_takeover_);
+    ~ws_inflate_t ();
+
+    //  Decompresses a message. Returns -1 with errno set to EMSGSIZE if it
+    //  is larger than max_size_ and to EPROTO if it is corrupt. On success
+    //  the result is available through data and size until the next call.
+    int decompress (const unsigned char *data_,
+                    size_t size_,
+                    size_t max_size_);
+
+    const unsigned char *data () const { return &_buffer[0]; }
+    size_t size () const { return _size; }
+
+  private:
+    int inflate_chunk (const unsigned char *data_,
+                       size_t size_,
+                       size_t max_size_);
+
+    z_stream _stream;
+    const bool _no_context_takeover;
+
+    std::vector<unsigned char> _buffer;
+    size_t _size;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (ws_inflate_t)
+};
+}
+
+#endif
@@ -3,64 +3,165 @@
 #include "precompiled.hpp"
 #include "ws_protocol.hpp"
 #include "ws_encoder.hpp"
+#include "ws_mask.hpp"
 #include "msg.hpp"
 #include "likely.hpp"
 #include "wire.hpp"
 #include "random.hpp"
 
+#ifdef ZMQ_HAVE_WS_DEFLATE
+#include "ws_deflate.hpp"
+#endif
+
 #include <limits.h>
 
-zmq::ws_encoder_t::ws_encoder_t (size_t bufsize_, bool must_mask_) :
-    encoder_base_t<ws_encoder_t> (bufsize_), _must_mask (must_mask_)
+#include <algorithm>
+
+zmq::ws_encoder_t::ws_encoder_t (size_t bufsize_,
+                                 bool must_mask_,
+                                 const allocator_t &hooks_,
+                                 ws_deflate_t *deflate_,
+                                 size_t deflate_threshold_,
+                                 size_t fragment_size_) :
+    encoder_base_t<ws_encoder_t> (bufsize_, hooks_),
+    _must_mask (must_mask_),
+    _head_size (0),
+    _payload (NULL),
+    _payload_pos (0),
+    _fragment_size (fragment_size_),
+    _chunk_size (0),
+    _deflate (deflate_),
+    _deflate_threshold (deflate_threshold_),
+    _is_deflated (false)
 {
     //  Write 0 bytes to the batch and go to message_ready state.
     next_step (NULL, 0, &ws_encoder_t::message_ready, true);
     _masked_msg.init ();
+    _deflated_msg.init ();
 }
 
 zmq::ws_encoder_t::~ws_encoder_t ()
 {
     _masked_msg.close ();
+    _deflated_msg.close ();
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    delete _deflate;
+#endif
 }
 
 void zmq::ws_encoder_t::message_ready ()
 {
-    int offset = 0;
+    unsigned char opcode;
 
     _is_binary = false;
 
+    //  The previous message has been written.
+    if (_is_deflated) {
+        _deflated_msg.close ();
+        _deflated_msg.init ();
+        _is_deflated = false;
+    }
+
     if (in_progress ()->is_ping ())
-        _tmp_buf[offset++] = 0x80 | zmq::ws_protocol_t::opcode_ping;
+        opcode = zmq::ws_protocol_t::opcode_ping;
     else if (in_progress ()->is_pong ())
-        _tmp_buf[offset++] = 0x80 | zmq::ws_protocol_t::opcode_pong;
+        opcode = zmq::ws_protocol_t::opcode_pong;
     else if (in_progress ()->is_close_cmd ())
-        _tmp_buf[offset++] = 0x80 | zmq::ws_protocol_t::opcode_close;
+        opcode = zmq::ws_protocol_t::opcode_close;
     else {
-        _tmp_buf[offset++] = 0x82; // Final | binary
+        opcode = zmq::ws_protocol_t::opcode_binary;
         _is_binary = true;
     }
 
-    _tmp_buf[offset] = _must_mask ? 0x80 : 0x00;
+    //  Bytes ahead of the body: the flags of binary frames and the
+    //  subscribe/cancel byte.
+    unsigned char head[2];
+    size_t head_size = 0;
+    if (_is_binary) {
+        unsigned char protocol_flags = 0;
+        if (in_progress ()->flags () & msg_t::more)
+            protocol_flags |= ws_protocol_t::more_flag;
+        if (in_progress ()->flags () & msg_t::command)
+            protocol_flags |= ws_protocol_t::command_flag;
+        head[head_size++] = protocol_flags;
+    }
+    //  TODO: remove once there is an opcode for subscribe/cancel
+    if (in_progress ()->is_subscribe ())
+        head[head_size++] = 1;
+    else if (in_progress ()->is_cancel ())
+        head[head_size++] = 0;
+
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    //  Compressed messages carry the head in the compressed payload.
+    if (_deflate && _is_binary
+        && in_progress ()->size () >= _deflate_threshold) {
+        _deflate->compress (
+          head, head_size,
+          static_cast<const unsigned char *> (in_progress ()->data ()),
+          in_progress ()->size (), &_deflated_msg);
+        _is_deflated = true;
+        opcode |= ws_protocol_t::rsv1_flag;
+        head_size = 0;
+    }
+#endif
+
+    _payload = _is_deflated ? &_deflated_msg : in_progress ();
+    _payload_pos = 0;
 
-    size_t size = in_progress ()->size ();
-    if (_is_binary)
-        size++;
-    //  TODO: create an opcode for subscribe/cancel
-    if (in_progress ()->is_subscribe () || in_progress ()->is_cancel ())
-        size++;
+    //  Control frames can't be fragmented. The first fragment of a data
+    //  message holds the head and as much of the body as fits.
+    _chunk_size = _payload->size ();
+    if (_is_binary && _fragment_size > 0
+        && head_size + _chunk_size > _fragment_size)
+        _chunk_size =
+          _fragment_size > head_size ? _fragment_size - head_size : 0;
 
-    if (size <= 125)
-        _tmp_buf[offset++] |= static_cast<unsigned char> (size & 127);
-    else if (size <= 0xFFFF) {
+    const bool final = _chunk_size == _payload->size ();
+    int offset = encode_header (static_cast<unsigned char> (
+                                  (final ? 0x80 : 0x00) | opcode),
+                                head_size + _chunk_size);
+
+    for (size_t i = 0; i < head_size; i++)
+        _tmp_buf[offset++] = _must_mask ? head[i] ^ _mask[i] : head[i];
+    _head_size = head_size;
+
+    next_step (_tmp_buf, offset, &ws_encoder_t::size_ready, false);
+}
+
+void zmq::ws_encoder_t::fragment_ready ()
+{
+    _chunk_size = std::min (_payload->size () - _payload_pos, _fragment_size);
+
+    const bool final = _payload_pos + _chunk_size == _payload->size ();
+    const int offset = encode_header (
+      static_cast<unsigned char> ((final ? 0x80 : 0x00)
+                                  | zmq::ws_protocol_t::opcode_continuation),
+      _chunk_size);
+    _head_size = 0;
+
+    next_step (_tmp_buf, offset, &ws_encoder_t::size_ready, false);
+}
+
+int zmq::ws_encoder_t::encode_header (unsigned char first_byte_,
+                                      size_t size_)
+{
+    int offset = 0;
+    _tmp_buf[offset++] = first_byte_;
+    _tmp_buf[offset] = _must_mask ? 0x80 : 0x00;
+
+    if (size_ <= 125)
+        _tmp_buf[offset++] |= static_cast<unsigned char> (size_ & 127);
+    else if (size_ <= 0xFFFF) {
         _tmp_buf[offset++] |= 126;
-        _tmp_buf[offset++] = static_cast<unsigned char> ((size >> 8) & 0xFF);
-        _tmp_buf[offset++] = static_cast<unsigned char> (size & 0xFF);
+        _tmp_buf[offset++] = static_cast<unsigned char> ((size_ >> 8) & 0xFF);
+        _tmp_buf[offset++] = static_cast<unsigned char> (size_ & 0xFF);
     } else {
         _tmp_buf[offset++] |= 127;
-        put_uint64 (_tmp_buf + offset, size);
+        put_uint64 (_tmp_buf + offset, size_);
         offset += 8;
     }
 
+    //  Every frame is masked with a key of its own.
     if (_must_mask) {
         const uint32_t random = generate_random ();
         put_uint32 (_tmp_buf + offset, random);
@@ -68,59 +169,34 @@ void zmq::ws_encoder_t::message_ready ()
         offset += 4;
     }
 
-    int mask_index = 0;
-    if (_is_binary) {
-        //  Encode flags.
-        unsigned char protocol_flags = 0;
-        if (in_progress ()->flags () & msg_t::more)
-            protocol_flags |= ws_protocol_t::more_flag;
-        if (in_progress ()->flags () & msg_t::command)
-            protocol_flags |= ws_protocol_t::command_flag;
-
-        _tmp_buf[offset++] =
-          _must_mask ? protocol_flags ^ _mask[mask_index++] : protocol_flags;
-    }
-
-    //  Encode the subscribe/cancel byte.
-    //  TODO: remove once there is an opcode for subscribe/cancel
-    if (in_progress ()->is_subscribe ())
-        _tmp_buf[offset++] = _must_mask ? 1 ^ _mask[mask_index++] : 1;
-    else if (in_progress ()->is_cancel ())
-        _tmp_buf[offset++] = _must_mask ? 0 ^ _mask[mask_index++] : 0;
-
-    next_step (_tmp_buf, offset, &ws_encoder_t::size_ready, false);
+    return offset;
 }
 
 void zmq::ws_encoder_t::size_ready ()
 {
+    unsigned char *src = static_cast<unsigned char *> (_payload->data ());
+    unsigned char *dest = src;
+
     if (_must_mask) {
         assert (in_progress () != &_masked_msg);
-        const size_t size = in_progress ()->size ();
-
-        unsigned char *src =
-          static_cast<unsigned char *> (in_progress ()->data ());
-        unsigned char *dest = src;
 
         //  If msg is shared or data is constant we cannot mask in-place, allocate a new msg for it
-        if (in_progress ()->flags () & msg_t::shared
-            || in_progress ()->is_cmsg ()) {
-            _masked_msg.close ();
-            _masked_msg.init_size (size);
+        if (_payload->flags () & msg_t::shared || _payload->is_cmsg ()) {
+            if (_payload_pos == 0) {
+                _masked_msg.close ();
+                _masked_msg.init_size (_payload->size ());
+            }
             dest = static_cast<unsigned char *> (_masked_msg.data ());
         }
 
-        int mask_index = 0;
-        if (_is_binary)
-            ++mask_index;
-        //  TODO: remove once there is an opcode for subscribe/cancel
-        if (in_progress ()->is_subscribe () || in_progress ()->is_cancel ())
-            ++mask_index;
-        for (size_t i = 0; i < size; ++i, mask_index++)
-            dest[i] = src[i] ^ _mask[mask_index % 4];
-
-        next_step (dest, size, &ws_encoder_t::message_ready, true);
-    } else {
-        next_step (in_progress ()->data (), in_progress ()->size (),
-                   &ws_encoder_t::message_ready, true);
+        ws_mask (dest + _payload_pos, src + _payload_pos, _chunk_size, _mask,
+                 _head_size);
     }
+
+    unsigned char *chunk = dest + _payload_pos;
+    _payload_pos += _chunk_size;
+    if (_payload_pos == _payload->size ())
+        next_step (chunk, _chunk_size, &ws_encoder_t::message_ready, true);
+    else
+        next_step (chunk, _chunk_size, &ws_encoder_t::fragment_ready, false);
 }
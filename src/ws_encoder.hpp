@@ -7,17 +7,32 @@
 
 namespace zmq
 {
+class ws_deflate_t;
+
 //  Encoder for web socket framing protocol. Converts messages into data stream.
+//  If given a compressor, which it takes ownership of, messages of at least
+//  deflate_threshold_ bytes are sent compressed with permessage-deflate.
+//  With a fragment size, data messages are split into frames carrying at
+//  most that many bytes of payload.
 
 class ws_encoder_t ZMQ_FINAL : public encoder_base_t<ws_encoder_t>
 {
   public:
-    ws_encoder_t (size_t bufsize_, bool must_mask_);
+    ws_encoder_t (size_t bufsize_,
+                  bool must_mask_,
+                  const allocator_t &hooks_,
+                  ws_deflate_t *deflate_ = NULL,
+                  size_t deflate_threshold_ = 0,
+                  size_t fragment_size_ = 0);
     ~ws_encoder_t ();
 
   private:
     void size_ready ();
     void message_ready ();
+    void fragment_ready ();
+
+    //  Writes a frame header to _tmp_buf and returns its length.
+    int encode_header (unsigned char first_byte_, size_t size_);
 
     unsigned char _tmp_buf[16];
     bool _must_mask;
@@ -25,6 +40,22 @@ class ws_encoder_t ZMQ_FINAL : public encoder_base_t<ws_encoder_t>
     msg_t _masked_msg;
     bool _is_binary;
 
+    //  Bytes ahead of the body already written with the header.
+    size_t _head_size;
+
+    //  The message or its compressed version, and how much of it went
+    //  into the frames written so far.
+    msg_t *_payload;
+    size_t _payload_pos;
+
+    const size_t _fragment_size;
+    size_t _chunk_size;
+
+    ws_deflate_t *const _deflate;
+    const size_t _deflate_threshold;
+    msg_t _deflated_msg;
+    bool _is_deflated;
+
     ZMQ_NON_COPYABLE_NOR_MOVABLE (ws_encoder_t)
 };
 }
@@ -75,6 +75,10 @@ zmq::ws_engine_t::ws_engine_t (fd_t fd_,
     _header_upgrade_websocket (false),
     _header_connection_upgrade (false),
     _heartbeat_timeout (0)
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    ,
+    _deflate_agreed (false)
+#endif
 {
     memset (_websocket_key, 0, MAX_HEADER_VALUE_LENGTH + 1);
     memset (_websocket_accept, 0, MAX_HEADER_VALUE_LENGTH + 1);
@@ -127,6 +131,19 @@ void zmq::ws_engine_t::start_ws_handshake ()
           encode_base64 (nonce, 16, _websocket_key, MAX_HEADER_VALUE_LENGTH);
         assert (size > 0);
 
+        //  Offer permessage-deflate, leaving the size of the window we
+        //  compress with to the server.
+        const char *extensions = "";
+#ifdef ZMQ_HAVE_WS_DEFLATE
+        if (_options.ws_deflate)
+            extensions =
+              _options.ws_deflate_no_context_takeover
+                ? "Sec-WebSocket-Extensions: permessage-deflate; "
+                  "client_max_window_bits; client_no_context_takeover\r\n"
+                : "Sec-WebSocket-Extensions: permessage-deflate; "
+                  "client_max_window_bits\r\n";
+#endif
+
         size = snprintf (
           reinterpret_cast<char *> (_write_buffer), WS_BUFFER_SIZE,
           "GET %s HTTP/1.1\r\n"
@@ -135,8 +152,10 @@ void zmq::ws_engine_t::start_ws_handshake ()
           "Connection: Upgrade\r\n"
           "Sec-WebSocket-Key: %s\r\n"
           "Sec-WebSocket-Protocol: %s\r\n"
+          "%s"
           "Sec-WebSocket-Version: 13\r\n\r\n",
-          _address.path (), _address.host (), _websocket_key, protocol);
+          _address.path (), _address.host (), _websocket_key, protocol,
+          extensions);
         assert (size > 0 && size < WS_BUFFER_SIZE);
         _outpos = _write_buffer;
         _outsize = size;
@@ -217,8 +236,8 @@ bool zmq::ws_engine_t::select_protocol (const char *protocol_)
     else if (_options.mechanism == ZMQ_CURVE
              && strcmp ("ZWS2.0/CURVE", protocol_) == 0) {
         if (_options.as_server)
-            _mechanism = new (std::nothrow)
-              curve_server_t (session (), _peer_address, _options, false);
+            _mechanism = new (std::nothrow) curve_server_t (
+              session (), _peer_address, _options, false, _crypto_notifier);
         else
             _mechanism =
               new (std::nothrow) curve_client_t (session (), _options, false);
@@ -240,13 +259,35 @@ bool zmq::ws_engine_t::handshake ()
         complete = server_handshake ();
 
     if (complete) {
-        _encoder =
-          new (std::nothrow) ws_encoder_t (_options.out_batch_size, _client);
+        ws_deflate_t *deflate = NULL;
+        ws_inflate_t *inflate = NULL;
+#ifdef ZMQ_HAVE_WS_DEFLATE
+        if (_deflate_agreed) {
+            const int window_bits = _client
+                                      ? _deflate_params.client_max_window_bits
+                                      : _deflate_params.server_max_window_bits;
+            deflate = new (std::nothrow) ws_deflate_t (
+              window_bits > 0 ? window_bits : 15,
+              _client ? _deflate_params.client_no_context_takeover
+                      : _deflate_params.server_no_context_takeover);
+            alloc_assert (deflate);
+
+            inflate = new (std::nothrow) ws_inflate_t (
+              _client ? _deflate_params.server_no_context_takeover
+                      : _deflate_params.client_no_context_takeover);
+            alloc_assert (inflate);
+        }
+#endif
+
+        _encoder = new (std::nothrow)
+          ws_encoder_t (_options.out_batch_size, _client, _options.allocator,
+                        deflate, _options.ws_deflate_threshold,
+                        _options.ws_fragment_size);
         alloc_assert (_encoder);
 
-        _decoder = new (std::nothrow)
-          ws_decoder_t (_options.in_batch_size, _options.maxmsgsize,
-                        _options.zero_copy, !_client);
+        _decoder = new (std::nothrow) ws_decoder_t (
+          _options.in_batch_size, _options.maxmsgsize, _options.zero_copy,
+          !_client, _options.allocator, inflate);
         alloc_assert (_decoder);
 
         socket ()->event_handshake_succeeded (_endpoint_uri_pair, 0);
@@ -462,6 +503,12 @@ bool zmq::ws_engine_t::server_handshake ()
                             }
                         }
                     }
+#ifdef ZMQ_HAVE_WS_DEFLATE
+                    else if (strcasecmp ("Sec-WebSocket-Extensions",
+                                         _header_name)
+                             == 0)
+                        select_deflate_offer (_header_value);
+#endif
 
                     _server_handshake_state = header_field_cr;
                 } else if (_header_value_position + 1 > MAX_HEADER_VALUE_LENGTH)
@@ -494,6 +541,19 @@ bool zmq::ws_engine_t::server_handshake ()
                         assert (accept_key_len > 0);
                         _websocket_accept[accept_key_len] = '\0';
 
+                        char extensions[256] = "";
+#ifdef ZMQ_HAVE_WS_DEFLATE
+                        if (_deflate_agreed) {
+                            const char header[] = "Sec-WebSocket-Extensions: ";
+                            strcpy (extensions, header);
+                            const int length = _deflate_params.format (
+                              extensions + sizeof header - 1,
+                              sizeof extensions - sizeof header - 2);
+                            strcpy (extensions + sizeof header - 1 + length,
+                                    "\r\n");
+                        }
+#endif
+
                         const int written =
                           snprintf (reinterpret_cast<char *> (_write_buffer),
                                     WS_BUFFER_SIZE,
@@ -502,8 +562,10 @@ bool zmq::ws_engine_t::server_handshake ()
                                     "Connection: Upgrade\r\n"
                                     "Sec-WebSocket-Accept: %s\r\n"
                                     "Sec-WebSocket-Protocol: %s\r\n"
+                                    "%s"
                                     "\r\n",
-                                    _websocket_accept, _websocket_protocol);
+                                    _websocket_accept, _websocket_protocol,
+                                    extensions);
                         assert (written >= 0 && written < WS_BUFFER_SIZE);
                         _outpos = _write_buffer;
                         _outsize = written;
@@ -831,6 +893,16 @@ bool zmq::ws_engine_t::client_handshake ()
                         if (select_protocol (_header_value))
                             strcpy_s (_websocket_protocol, _header_value);
                     }
+#ifdef ZMQ_HAVE_WS_DEFLATE
+                    else if (strcasecmp ("Sec-WebSocket-Extensions",
+                                         _header_name)
+                             == 0) {
+                        if (!accept_deflate_response (_header_value)) {
+                            _client_handshake_state = client_handshake_error;
+                            break;
+                        }
+                    }
+#endif
                     _client_handshake_state = client_header_field_cr;
                 } else if (_header_value_position + 1 > MAX_HEADER_VALUE_LENGTH)
                     _client_handshake_state = client_handshake_error;
@@ -883,6 +955,55 @@ bool zmq::ws_engine_t::client_handshake ()
     return false;
 }
 
+#ifdef ZMQ_HAVE_WS_DEFLATE
+void zmq::ws_engine_t::select_deflate_offer (char *offers_)
+{
+    //  The header can appear several times, the first acceptable offer
+    //  wins.
+    if (!_options.ws_deflate || _deflate_agreed)
+        return;
+
+    char *rest = NULL;
+    for (const char *offer = strtok_r (offers_, ",", &rest); offer != NULL;
+         offer = strtok_r (NULL, ",", &rest)) {
+        ws_deflate_params_t params;
+        if (!params.parse (offer))
+            continue;
+
+        //  zlib can't compress with the smallest window.
+        if (params.server_max_window_bits == 8)
+            continue;
+
+        //  The client compresses with whatever window it likes, the
+        //  decompressor copes with all of them.
+        params.client_max_window_bits = 0;
+        params.server_no_context_takeover |=
+          _options.ws_deflate_no_context_takeover;
+        _deflate_params = params;
+        _deflate_agreed = true;
+        return;
+    }
+}
+
+bool zmq::ws_engine_t::accept_deflate_response (const char *response_)
+{
+    //  The server may only accept an offer that was made, and only once.
+    if (!_options.ws_deflate || _deflate_agreed)
+        return false;
+
+    ws_deflate_params_t params;
+    if (!params.parse (response_) || params.client_max_window_bits < 0
+        || params.client_max_window_bits == 8)
+        return false;
+
+    params.client_no_context_takeover |=
+      _options.ws_deflate_no_context_takeover;
+    _deflate_params = params;
+    _deflate_agreed = true;
+    return true;
+}
+#endif
+
 int zmq::ws_engine_t::decode_and_push (msg_t *msg_)
 {
     zmq_assert (_mechanism != NULL);
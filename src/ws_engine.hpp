@@ -9,6 +9,10 @@
 #include "stream_engine_base.hpp"
 #include "ws_address.hpp"
 
+#ifdef ZMQ_HAVE_WS_DEFLATE
+#include "ws_deflate.hpp"
+#endif
+
 #define WS_BUFFER_SIZE 8192
 #define MAX_HEADER_NAME_LENGTH 1024
 #define MAX_HEADER_VALUE_LENGTH 2048
@@ -128,6 +132,11 @@ class ws_engine_t : public stream_engine_base_t
     bool client_handshake ();
     bool server_handshake ();
 
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    void select_deflate_offer (char *offers_);
+    bool accept_deflate_response (const char *response_);
+#endif
+
     bool _client;
     ws_address_t _address;
 
@@ -149,6 +158,12 @@ class ws_engine_t : public stream_engine_base_t
 
     int _heartbeat_timeout;
     msg_t _close_msg;
+
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    //  Parameters of permessage-deflate once both sides agreed on it.
+    bool _deflate_agreed;
+    ws_deflate_params_t _deflate_params;
+#endif
 };
 }
 
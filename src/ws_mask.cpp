@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "ws_mask.hpp"
+#include "stdint.hpp"
+
+#include <string.h>
+
+#if defined __AVX2__
+#include <immintrin.h>
+#define ZMQ_WS_MASK_AVX2
+#elif defined __SSE2__ || defined _M_X64                                      \
+  || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZMQ_WS_MASK_SSE2
+#elif (defined __ARM_NEON || defined __ARM_NEON__) && !defined _MSC_VER
+#include <arm_neon.h>
+#define ZMQ_WS_MASK_NEON
+#endif
+
+namespace
+{
+#if defined ZMQ_WS_MASK_AVX2
+const size_t block_size = 32;
+#elif defined ZMQ_WS_MASK_SSE2 || defined ZMQ_WS_MASK_NEON
+const size_t block_size = 16;
+#else
+const size_t block_size = 8;
+#endif
+}
+
+void zmq::ws_mask (unsigned char *dest_,
+                   const unsigned char *src_,
+                   size_t size_,
+                   const unsigned char *mask_,
+                   size_t offset_)
+{
+    size_t i = 0;
+
+    //  Mask byte by byte up to an aligned destination, unless the payload
+    //  is too short for that to pay off. Loads stay unaligned.
+    if (size_ >= 2 * block_size)
+        while (reinterpret_cast<uintptr_t> (dest_ + i) % block_size != 0) {
+            dest_[i] = src_[i] ^ mask_[(offset_ + i) % 4];
+            i++;
+        }
+
+    //  The mask repeated, starting at the current position. As blocks and
+    //  words are multiples of four bytes, it stays in phase.
+    unsigned char key[32];
+    for (size_t j = 0; j != 4; j++)
+        key[j] = mask_[(offset_ + i + j) % 4];
+    memcpy (key + 4, key, 4);
+    memcpy (key + 8, key, 8);
+    memcpy (key + 16, key, 16);
+
+#if defined ZMQ_WS_MASK_AVX2
+    const __m256i key_block =
+      _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (key));
+    for (; i + 32 <= size_; i += 32) {
+        const __m256i data =
+          _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (src_ + i));
+        _mm256_storeu_si256 (reinterpret_cast<__m256i *> (dest_ + i),
+                             _mm256_xor_si256 (data, key_block));
+    }
+#elif defined ZMQ_WS_MASK_SSE2
+    const __m128i key_block =
+      _mm_loadu_si128 (reinterpret_cast<const __m128i *> (key));
+    for (; i + 16 <= size_; i += 16) {
+        const __m128i data =
+          _mm_loadu_si128 (reinterpret_cast<const __m128i *> (src_ + i));
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (dest_ + i),
+                          _mm_xor_si128 (data, key_block));
+    }
+#elif defined ZMQ_WS_MASK_NEON
+    const uint8x16_t key_block = vld1q_u8 (key);
+    for (; i + 16 <= size_; i += 16)
+        vst1q_u8 (dest_ + i, veorq_u8 (vld1q_u8 (src_ + i), key_block));
+#endif
+
+    //  Words, through memcpy as neither side need be aligned.
+    uint64_t key_word;
+    memcpy (&key_word, key, sizeof key_word);
+    for (; i + 8 <= size_; i += 8) {
+        uint64_t word;
+        memcpy (&word, src_ + i, sizeof word);
+        word ^= key_word;
+        memcpy (dest_ + i, &word, sizeof word);
+    }
+
+    for (; i < size_; i++)
+        dest_[i] = src_[i] ^ mask_[(offset_ + i) % 4];
+}
@@ -0,0 +1,24 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_WS_MASK_HPP_INCLUDED__
+#define __ZMQ_WS_MASK_HPP_INCLUDED__
+
+#include <stddef.h>
+
+namespace zmq
+{
+//  XORs size_ bytes of src_ with the four byte WebSocket mask and stores
+//  the result at dest_, which may be the same as src_ but must not
+//  overlap it otherwise. offset_ is the position of src_ in the masked
+//  payload, so that a payload can be masked in pieces.
+//
+//  Bytes are processed sixteen or thirty-two at a time with SSE2, AVX2 or
+//  NEON, whichever the compiler targets, and eight at a time elsewhere.
+void ws_mask (unsigned char *dest_,
+              const unsigned char *src_,
+              size_t size_,
+              const unsigned char *mask_,
+              size_t offset_);
+}
+
+#endif
@@ -25,6 +25,13 @@ class ws_protocol_t
         more_flag = 1,
         command_flag = 2
     };
+
+    //  Bit of the first header byte marking a message compressed with
+    //  permessage-deflate.
+    enum
+    {
+        rsv1_flag = 0x40
+    };
 };
 }
 
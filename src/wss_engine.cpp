@@ -147,6 +147,17 @@ bool zmq::wss_engine_t::handshake ()
     return ws_engine_t::handshake ();
 }
 
+int zmq::wss_engine_t::readv (void *data_,
+                              size_t size_,
+                              void *next_data_,
+                              size_t next_size_)
+{
+    //  TLS records are decrypted into a single buffer.
+    LIBZMQ_UNUSED (next_data_);
+    LIBZMQ_UNUSED (next_size_);
+    return read (data_, size_);
+}
+
 int zmq::wss_engine_t::read (void *data_, size_t size_)
 {
     ssize_t rc = gnutls_record_recv (_tls_session, data_, size_);
@@ -28,6 +28,7 @@ class wss_engine_t : public ws_engine_t
     bool handshake ();
     void plug_internal ();
     int read (void *data, size_t size_);
+    int readv (void *data_, size_t size_, void *next_data_, size_t next_size_);
     int write (const void *data_, size_t size_);
 
   private:
@@ -46,6 +46,8 @@ void zmq::xpub_t::xattach_pipe (pipe_t *pipe_,
     LIBZMQ_UNUSED (locally_initiated_);
 
     zmq_assert (pipe_);
+    if (_lossy && !_spill_dir.empty ())
+        pipe_->set_spill_dir (_spill_dir);
     _dist.attach (pipe_);
 
     //  If subscribe_to_all_ is specified, the caller would like to subscribe
@@ -178,6 +180,12 @@ int zmq::xpub_t::xsetsockopt (int option_,
                               const void *optval_,
                               size_t optvallen_)
 {
+#ifdef ZMQ_BUILD_DRAFT_API
+    if (option_ == ZMQ_XPUB_SPILL_DIR) {
+        _spill_dir.assign (static_cast<const char *> (optval_), optvallen_);
+        return 0;
+    }
+#endif
     if (option_ == ZMQ_XPUB_VERBOSE || option_ == ZMQ_XPUB_VERBOSER
         || option_ == ZMQ_XPUB_MANUAL_LAST_VALUE || option_ == ZMQ_XPUB_NODROP
         || option_ == ZMQ_XPUB_MANUAL || option_ == ZMQ_ONLY_FIRST_SUBSCRIBE) {
@@ -325,6 +333,11 @@ int zmq::xpub_t::xsend (msg_t *msg_)
     return rc;
 }
 
+bool zmq::xpub_t::xlossy () const
+{
+    return _lossy;
+}
+
 bool zmq::xpub_t::xhas_out ()
 {
     return _dist.has_out ();
@@ -29,6 +29,7 @@ class xpub_t : public socket_base_t
                        bool locally_initiated_ = false) ZMQ_OVERRIDE;
     int xsend (zmq::msg_t *msg_) ZMQ_FINAL;
     bool xhas_out () ZMQ_FINAL;
+    bool xlossy () const ZMQ_FINAL;
     int xrecv (zmq::msg_t *msg_) ZMQ_OVERRIDE;
     bool xhas_in () ZMQ_OVERRIDE;
     void xread_activated (zmq::pipe_t *pipe_) ZMQ_FINAL;
@@ -83,6 +84,10 @@ class xpub_t : public socket_base_t
     //  Drop messages if HWM reached, otherwise return with EAGAIN
     bool _lossy;
 
+    //  If not empty, lossy pipes spill overflow to files in this directory
+    //  rather than dropping it.
+    std::string _spill_dir;
+
     //  Subscriptions will not bed added automatically, only after calling set option with ZMQ_SUBSCRIBE or ZMQ_UNSUBSCRIBE
     bool _manual;
 
@@ -13,14 +13,16 @@ namespace zmq
 //  Only a single thread can read from the pipe at any specific moment.
 //  Only a single thread can write to the pipe at any specific moment.
 //  T is the type of the object in the queue.
-//  N is granularity of the pipe, i.e. how many items are needed to
-//  perform next memory allocation.
+//  N is the default granularity of the pipe, i.e. how many items are
+//  needed to perform next memory allocation.
 
 template <typename T, int N> class ypipe_t ZMQ_FINAL : public ypipe_base_t<T>
 {
   public:
-    //  Initialises the pipe.
-    ypipe_t ()
+    //  Initialises the pipe, optionally with another granularity and a
+    //  cache to take the queue's chunks from.
+    explicit ypipe_t (int granularity_ = N, chunk_cache_t *cache_ = NULL) :
+        _queue (granularity_, cache_)
     {
         //  Insert terminator element into the queue.
         _queue.push ();
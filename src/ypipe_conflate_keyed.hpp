@@ -0,0 +1,167 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_YPIPE_CONFLATE_KEYED_HPP_INCLUDED__
+#define __ZMQ_YPIPE_CONFLATE_KEYED_HPP_INCLUDED__
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <string>
+
+#include "err.hpp"
+#include "msg.hpp"
+#include "mutex.hpp"
+#include "ypipe_base.hpp"
+
+namespace zmq
+{
+//  Keyed variant of ypipe_conflate. Instead of keeping only the very last
+//  message it keeps the last message per key, where the key is the first
+//  key_size bytes of the message body (or the whole body if it is shorter,
+//  e.g. a topic prefix on PUB/SUB). Keys are read back in the order they
+//  were first written; a newer message for a pending key replaces the older
+//  one in place, so a slow reader gets the newest value of every key.
+//
+//  Delimiters, routing ids and credentials are never conflated, they are
+//  queued behind everything written before them.
+//
+//  The reader and writer live in different threads and share the queue
+//  under a mutex, the same way dbuffer does for the single slot case.
+
+class ypipe_conflate_keyed_t ZMQ_FINAL : public ypipe_base_t<msg_t>
+{
+  public:
+    //  Initialises the pipe.
+    explicit ypipe_conflate_keyed_t (size_t key_size_) :
+        _key_size (key_size_), _reader_awake (false)
+    {
+    }
+
+    ~ypipe_conflate_keyed_t ()
+    {
+        for (entries_t::iterator it = _entries.begin (), end = _entries.end ();
+             it != end; ++it) {
+            const int rc = it->msg.close ();
+            errno_assert (rc == 0);
+        }
+    }
+
+    void write (const msg_t &value_, bool incomplete_)
+    {
+        (void) incomplete_;
+        zmq_assert (value_.check ());
+
+        scoped_lock_t lock (_sync);
+
+        if (value_.is_delimiter () || value_.is_routing_id ()
+            || value_.is_credential ()) {
+            entry_t entry = {value_, false};
+            _entries.push_back (entry);
+            return;
+        }
+
+        entry_t entry = {value_, true};
+        const std::string key = key_of (entry.msg);
+        const index_t::iterator it = _index.find (key);
+        if (it != _index.end ()) {
+            //  Replace the pending value, keeping its position.
+            const int rc = it->second->msg.close ();
+            errno_assert (rc == 0);
+            it->second->msg = entry.msg;
+            return;
+        }
+        _index.insert (
+          index_t::value_type (key, _entries.insert (_entries.end (), entry)));
+    }
+
+    // There are no incomplete items for conflate ypipe
+    bool unwrite (msg_t *)
+    {
+        return false;
+    }
+
+    //  Returns false if the reader thread is sleeping. In that case,
+    //  caller is obliged to wake the reader up before using the pipe again.
+    bool flush ()
+    {
+        scoped_lock_t lock (_sync);
+        if (_reader_awake)
+            return true;
+        _reader_awake = true;
+        return false;
+    }
+
+    //  Check whether item is available for reading.
+    bool check_read ()
+    {
+        scoped_lock_t lock (_sync);
+        const bool res = !_entries.empty ();
+        if (!res)
+            _reader_awake = false;
+
+        return res;
+    }
+
+    //  Reads an item from the pipe. Returns false if there is no value.
+    //  available.
+    bool read (msg_t *value_)
+    {
+        if (!value_)
+            return false;
+
+        scoped_lock_t lock (_sync);
+        if (_entries.empty ()) {
+            _reader_awake = false;
+            return false;
+        }
+
+        entry_t &front = _entries.front ();
+        zmq_assert (front.msg.check ());
+        if (front.keyed)
+            _index.erase (key_of (front.msg));
+        *value_ = front.msg;
+        _entries.pop_front ();
+        return true;
+    }
+
+    //  Applies the function fn to the first element in the pipe
+    //  and returns the value returned by the fn.
+    //  The pipe mustn't be empty or the function crashes.
+    bool probe (bool (*fn_) (const msg_t &))
+    {
+        scoped_lock_t lock (_sync);
+        zmq_assert (!_entries.empty ());
+        return (*fn_) (_entries.front ().msg);
+    }
+
+  private:
+    struct entry_t
+    {
+        msg_t msg;
+        bool keyed;
+    };
+
+    typedef std::list<entry_t> entries_t;
+    typedef std::map<std::string, entries_t::iterator> index_t;
+
+    std::string key_of (msg_t &msg_) const
+    {
+        return std::string (static_cast<const char *> (msg_.data ()),
+                            std::min (msg_.size (), _key_size));
+    }
+
+    const size_t _key_size;
+
+    //  Pending messages in the order their keys were first written, plus
+    //  an index from key to its pending entry.
+    entries_t _entries;
+    index_t _index;
+
+    mutex_t _sync;
+    bool _reader_awake;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (ypipe_conflate_keyed_t)
+};
+}
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "err.hpp"
 #include "atomic_ptr.hpp"
+#include "chunk_cache.hpp"
 #include "platform.hpp"
 
 namespace zmq
@@ -22,8 +23,9 @@ namespace zmq
 //  element in unsynchronised manner.
 //
 //  T is the type of the object in the queue.
-//  N is granularity of the queue (how many pushes have to be done till
-//  actual memory allocation is required).
+//  N is the default granularity of the queue (how many pushes have to be
+//  done till actual memory allocation is required). A different one can
+//  be given at construction, together with a cache to take chunks from.
 #if defined HAVE_POSIX_MEMALIGN
 // ALIGN is the memory alignment size to use in the case where we have
 // posix_memalign available. Default value is 64, this alignment will
@@ -37,9 +39,17 @@ template <typename T, int N> class yqueue_t
 #endif
 {
   public:
-    //  Create the queue.
-    inline yqueue_t ()
+    //  Create the queue. If a cache is given, its chunk size must match
+    //  chunk_size (granularity_).
+    inline explicit yqueue_t (int granularity_ = N,
+                              chunk_cache_t *cache_ = NULL) :
+        _granularity (granularity_),
+        _links_offset (links_offset (granularity_)),
+        _cache (cache_)
     {
+        zmq_assert (_granularity > 0);
+        zmq_assert (!_cache
+                    || _cache->chunk_size () == chunk_size (_granularity));
         _begin_chunk = allocate_chunk ();
         alloc_assert (_begin_chunk);
         _begin_pos = 0;
@@ -54,25 +64,31 @@ template <typename T, int N> class yqueue_t
     {
         while (true) {
             if (_begin_chunk == _end_chunk) {
-                free (_begin_chunk);
+                free_chunk (_begin_chunk);
                 break;
             }
             chunk_t *o = _begin_chunk;
-            _begin_chunk = _begin_chunk->next;
-            free (o);
+            _begin_chunk = next (_begin_chunk);
+            free_chunk (o);
         }
 
         chunk_t *sc = _spare_chunk.xchg (NULL);
-        free (sc);
+        free_chunk (sc);
+    }
+
+    //  Size of a chunk holding granularity_ elements.
+    static size_t chunk_size (int granularity_)
+    {
+        return links_offset (granularity_) + sizeof (links_t);
     }
 
     //  Returns reference to the front element of the queue.
     //  If the queue is empty, behaviour is undefined.
-    inline T &front () { return _begin_chunk->values[_begin_pos]; }
+    inline T &front () { return values (_begin_chunk)[_begin_pos]; }
 
     //  Returns reference to the back element of the queue.
     //  If the queue is empty, behaviour is undefined.
-    inline T &back () { return _back_chunk->values[_back_pos]; }
+    inline T &back () { return values (_back_chunk)[_back_pos]; }
 
     //  Adds an element to the back end of the queue.
     inline void push ()
@@ -80,19 +96,20 @@ template <typename T, int N> class yqueue_t
         _back_chunk = _end_chunk;
         _back_pos = _end_pos;
 
-        if (++_end_pos != N)
+        if (++_end_pos != _granularity)
             return;
 
         chunk_t *sc = _spare_chunk.xchg (NULL);
         if (sc) {
-            _end_chunk->next = sc;
-            sc->prev = _end_chunk;
+            next (_end_chunk) = sc;
+            prev (sc) = _end_chunk;
         } else {
-            _end_chunk->next = allocate_chunk ();
-            alloc_assert (_end_chunk->next);
-            _end_chunk->next->prev = _end_chunk;
+            chunk_t *chunk = allocate_chunk ();
+            alloc_assert (chunk);
+            next (_end_chunk) = chunk;
+            prev (chunk) = _end_chunk;
         }
-        _end_chunk = _end_chunk->next;
+        _end_chunk = next (_end_chunk);
         _end_pos = 0;
     }
 
@@ -109,8 +126,8 @@ template <typename T, int N> class yqueue_t
         if (_back_pos)
             --_back_pos;
         else {
-            _back_pos = N - 1;
-            _back_chunk = _back_chunk->prev;
+            _back_pos = _granularity - 1;
+            _back_chunk = prev (_back_chunk);
         }
 
         //  Now, move 'end' position backwards. Note that obsolete end chunk
@@ -120,51 +137,89 @@ template <typename T, int N> class yqueue_t
         if (_end_pos)
             --_end_pos;
         else {
-            _end_pos = N - 1;
-            _end_chunk = _end_chunk->prev;
-            free (_end_chunk->next);
-            _end_chunk->next = NULL;
+            _end_pos = _granularity - 1;
+            _end_chunk = prev (_end_chunk);
+            free_chunk (next (_end_chunk));
+            next (_end_chunk) = NULL;
         }
     }
 
     //  Removes an element from the front end of the queue.
     inline void pop ()
     {
-        if (++_begin_pos == N) {
+        if (++_begin_pos == _granularity) {
             chunk_t *o = _begin_chunk;
-            _begin_chunk = _begin_chunk->next;
-            _begin_chunk->prev = NULL;
+            _begin_chunk = next (_begin_chunk);
+            prev (_begin_chunk) = NULL;
             _begin_pos = 0;
 
             //  'o' has been more recently used than _spare_chunk,
             //  so for cache reasons we'll get rid of the spare and
             //  use 'o' as the spare.
             chunk_t *cs = _spare_chunk.xchg (o);
-            free (cs);
+            free_chunk (cs);
         }
     }
 
   private:
-    //  Individual memory chunk to hold N elements.
-    struct chunk_t
+    //  Individual memory chunk to hold _granularity elements, followed by
+    //  the links to the neighbouring chunks.
+    struct chunk_t;
+    struct links_t
     {
-        T values[N];
         chunk_t *prev;
         chunk_t *next;
     };
 
-    static inline chunk_t *allocate_chunk ()
+    static size_t links_offset (int granularity_)
+    {
+        const size_t align = sizeof (links_t *);
+        return (granularity_ * sizeof (T) + align - 1) / align * align;
+    }
+
+    static inline T *values (chunk_t *chunk_)
     {
+        return reinterpret_cast<T *> (chunk_);
+    }
+
+    inline links_t &links (chunk_t *chunk_)
+    {
+        return *reinterpret_cast<links_t *> (
+          reinterpret_cast<unsigned char *> (chunk_) + _links_offset);
+    }
+
+    inline chunk_t *&prev (chunk_t *chunk_) { return links (chunk_).prev; }
+
+    inline chunk_t *&next (chunk_t *chunk_) { return links (chunk_).next; }
+
+    inline chunk_t *allocate_chunk ()
+    {
+        if (_cache)
+            return static_cast<chunk_t *> (_cache->allocate ());
 #if defined HAVE_POSIX_MEMALIGN
         void *pv;
-        if (posix_memalign (&pv, ALIGN, sizeof (chunk_t)) == 0)
+        if (posix_memalign (&pv, ALIGN, chunk_size (_granularity)) == 0)
             return (chunk_t *) pv;
         return NULL;
 #else
-        return static_cast<chunk_t *> (malloc (sizeof (chunk_t)));
+        return static_cast<chunk_t *> (malloc (chunk_size (_granularity)));
 #endif
     }
 
+    inline void free_chunk (chunk_t *chunk_)
+    {
+        if (_cache)
+            _cache->deallocate (chunk_);
+        else
+            free (chunk_);
+    }
+
+    const int _granularity;
+    const size_t _links_offset;
+
+    //  Where chunks come from and go to, NULL to use the heap.
+    chunk_cache_t *const _cache;
+
     //  Back position may point to invalid memory if the queue is empty,
     //  while begin & end positions are always valid. Begin position is
     //  accessed exclusively be queue reader (front/pop), while back and
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "precompiled.hpp"
+#include "zap_cache.hpp"
+#include "clock.hpp"
+
+zmq::zap_cache_t::zap_cache_t ()
+{
+}
+
+bool zmq::zap_cache_t::find (const std::string &request_, reply_t *reply_)
+{
+    scoped_lock_t locker (_sync);
+
+    const entries_t::iterator it = _entries.find (request_);
+    if (it == _entries.end ())
+        return false;
+    if (it->second.expiry <= clock_t::now_us () / 1000) {
+        _ages.erase (it->second.age);
+        _entries.erase (it);
+        return false;
+    }
+    *reply_ = it->second.reply;
+    return true;
+}
+
+void zmq::zap_cache_t::insert (const std::string &request_,
+                               const reply_t &reply_,
+                               int ttl_,
+                               int size_)
+{
+    scoped_lock_t locker (_sync);
+
+    entries_t::iterator it = _entries.find (request_);
+    if (it != _entries.end ()) {
+        _ages.erase (it->second.age);
+        _entries.erase (it);
+    }
+    while (!_ages.empty () && _entries.size () >= static_cast<size_t> (size_)) {
+        _entries.erase (_ages.front ());
+        _ages.pop_front ();
+    }
+    if (size_ <= 0)
+        return;
+
+    _ages.push_back (request_);
+    entry_t &entry = _entries[request_];
+    entry.reply = reply_;
+    entry.expiry = clock_t::now_us () / 1000 + ttl_;
+    entry.age = --_ages.end ();
+}
+
+void zmq::zap_cache_t::clear ()
+{
+    scoped_lock_t locker (_sync);
+
+    _entries.clear ();
+    _ages.clear ();
+}
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZMQ_ZAP_CACHE_HPP_INCLUDED__
+#define __ZMQ_ZAP_CACHE_HPP_INCLUDED__
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "macros.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Replies of the ZAP handler that a socket keeps for a while, so that a
+//  peer that authenticates again with the same request, e.g. once it
+//  reconnects, need not wait for the handler.
+//
+//  Requests are looked up by everything the handler gets to see except
+//  the request id. Once full, the cache drops the oldest reply. All the
+//  functions are thread safe, as the sessions of a socket may run in
+//  different io threads.
+
+class zap_cache_t
+{
+  public:
+    struct reply_t
+    {
+        std::string status_code;
+        std::string user_id;
+        std::string metadata;
+    };
+
+    zap_cache_t ();
+
+    //  Copies the reply to request_ to reply_, if there is one that has
+    //  not expired.
+    bool find (const std::string &request_, reply_t *reply_);
+
+    //  Keeps reply_ to request_ for ttl_ msec, dropping the oldest reply
+    //  if there are size_ already.
+    void insert (const std::string &request_,
+                 const reply_t &reply_,
+                 int ttl_,
+                 int size_);
+
+    //  Forgets all replies.
+    void clear ();
+
+  private:
+    struct entry_t
+    {
+        reply_t reply;
+        uint64_t expiry;
+        std::list<std::string>::iterator age;
+    };
+    typedef std::map<std::string, entry_t> entries_t;
+
+    entries_t _entries;
+
+    //  Requests, the oldest first.
+    std::list<std::string> _ages;
+
+    mutex_t _sync;
+
+    ZMQ_NON_COPYABLE_NOR_MOVABLE (zap_cache_t)
+};
+}
+
+#endif
@@ -17,10 +17,21 @@ const size_t id_len = sizeof (id) - 1;
 zap_client_t::zap_client_t (session_base_t *const session_,
                             const std::string &peer_address_,
                             const options_t &options_) :
-    mechanism_base_t (session_, options_), peer_address (peer_address_)
+    mechanism_base_t (session_, options_),
+    peer_address (peer_address_),
+    _zap_reply_cached (false)
 {
 }
 
+//  Adds a frame of a request to its cache key, prefixed with its size.
+static void
+add_cached_frame (std::string *request_, const void *data_, size_t size_)
+{
+    const uint32_t size = static_cast<uint32_t> (size_);
+    request_->append (reinterpret_cast<const char *> (&size), sizeof size);
+    request_->append (static_cast<const char *> (data_), size_);
+}
+
 void zap_client_t::send_zap_request (const char *mechanism_,
                                      size_t mechanism_length_,
                                      const uint8_t *credentials_,
@@ -36,6 +47,27 @@ void zap_client_t::send_zap_request (const char *mechanism_,
                                      size_t *credentials_sizes_,
                                      size_t credentials_count_)
 {
+    //  A request the handler replied to lately need not be sent again.
+    //  It is known by all its frames but the request id.
+    _cached_request.clear ();
+    if (options.zap_cache_ttl > 0) {
+        add_cached_frame (&_cached_request, options.zap_domain.c_str (),
+                          options.zap_domain.length ());
+        add_cached_frame (&_cached_request, peer_address.c_str (),
+                          peer_address.length ());
+        add_cached_frame (&_cached_request, options.routing_id,
+                          options.routing_id_size);
+        add_cached_frame (&_cached_request, mechanism_, mechanism_length_);
+        for (size_t i = 0; i < credentials_count_; ++i)
+            add_cached_frame (&_cached_request, credentials_[i],
+                              credentials_sizes_[i]);
+
+        _zap_reply_cached = session->get_socket ()->zap_cache ().find (
+          _cached_request, &_cached_reply);
+        if (_zap_reply_cached)
+            return;
+    }
+
     // write_zap_msg cannot fail. It could only fail if the HWM was exceeded,
     // but on the ZAP socket, the HWM is disabled.
 
@@ -113,6 +145,9 @@ void zap_client_t::send_zap_request (const char *mechanism_,
 
 int zap_client_t::receive_and_process_zap_reply ()
 {
+    if (_zap_reply_cached)
+        return process_cached_zap_reply ();
+
     int rc = 0;
     const size_t zap_reply_frame_count = 7;
     msg_t msg[zap_reply_frame_count];
@@ -194,6 +229,20 @@ int zap_client_t::receive_and_process_zap_reply ()
         return close_and_return (msg, -1);
     }
 
+    //  Keep what the handler decided, but not temporary failures.
+    if (!_cached_request.empty ()
+        && (status_code == "200" || status_code == "400")) {
+        zap_cache_t::reply_t reply;
+        reply.status_code = status_code;
+        reply.user_id.assign (static_cast<const char *> (msg[5].data ()),
+                              msg[5].size ());
+        reply.metadata.assign (static_cast<const char *> (msg[6].data ()),
+                               msg[6].size ());
+        session->get_socket ()->zap_cache ().insert (
+          _cached_request, reply, options.zap_cache_ttl,
+          options.zap_cache_size);
+    }
+
     //  Close all reply frames
     for (size_t i = 0; i < zap_reply_frame_count; i++) {
         const int rc2 = msg[i].close ();
@@ -205,6 +254,24 @@ int zap_client_t::receive_and_process_zap_reply ()
     return 0;
 }
 
+int zap_client_t::process_cached_zap_reply ()
+{
+    _zap_reply_cached = false;
+
+    status_code = _cached_reply.status_code;
+    set_user_id (_cached_reply.user_id.data (), _cached_reply.user_id.size ());
+
+    //  The metadata was checked when the reply came in.
+    const int rc = parse_metadata (
+      reinterpret_cast<const unsigned char *> (_cached_reply.metadata.data ()),
+      _cached_reply.metadata.size (), true);
+    zmq_assert (rc == 0);
+
+    handle_zap_status_code ();
+
+    return 0;
+}
+
 void zap_client_t::handle_zap_status_code ()
 {
     //  we can assume here that status_code is a valid ZAP status code,
@@ -4,6 +4,7 @@
 #define __ZMQ_ZAP_CLIENT_HPP_INCLUDED__
 
 #include "mechanism_base.hpp"
+#include "zap_cache.hpp"
 
 namespace zmq
 {
@@ -33,6 +34,17 @@ class zap_client_t : public virtual mechanism_base_t
 
     //  Status code as received from ZAP handler
     std::string status_code;
+
+  private:
+    //  The request as the socket's ZAP cache knows it, if it has one.
+    std::string _cached_request;
+
+    //  True if the cache had the reply to the request, which then was not
+    //  sent.
+    bool _zap_reply_cached;
+    zap_cache_t::reply_t _cached_reply;
+
+    int process_cached_zap_reply ();
 };
 
 class zap_client_common_handshake_t : public zap_client_t
@@ -171,6 +171,19 @@ int zmq_ctx_set_ext (void *ctx_,
       ->set (option_, optval_, optvallen_);
 }
 
+int zmq_ctx_set_allocator (void *ctx_,
+                           zmq_alloc_fn *alloc_fn_,
+                           zmq_free_fn *free_fn_,
+                           void *hint_)
+{
+    if (!ctx_ || !(static_cast<zmq::ctx_t *> (ctx_))->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return (static_cast<zmq::ctx_t *> (ctx_))
+      ->set_allocator (alloc_fn_, free_fn_, hint_);
+}
+
 int zmq_ctx_get (void *ctx_, int option_)
 {
     if (!ctx_ || !(static_cast<zmq::ctx_t *> (ctx_))->check_tag ()) {
@@ -599,6 +612,11 @@ int zmq_msg_init_buffer (zmq_msg_t *msg_, const void *buf_, size_t size_)
     return (reinterpret_cast<zmq::msg_t *> (msg_))->init_buffer (buf_, size_);
 }
 
+int zmq_msg_init_static (zmq_msg_t *msg_, const void *data_, size_t size_)
+{
+    return (reinterpret_cast<zmq::msg_t *> (msg_))->init_static (data_, size_);
+}
+
 int zmq_msg_init_data (
   zmq_msg_t *msg_, void *data_, size_t size_, zmq_free_fn *ffn_, void *hint_)
 {
@@ -54,6 +54,20 @@
 #define ZMQ_NORM_NUM_PARITY 122
 #define ZMQ_NORM_NUM_AUTOPARITY 123
 #define ZMQ_NORM_PUSH 124
+#define ZMQ_CONFLATE_KEY_SIZE 125
+#define ZMQ_SNDHWM_BYTES 126
+#define ZMQ_RCVHWM_BYTES 127
+#define ZMQ_XPUB_SPILL_DIR 128
+#define ZMQ_WS_DEFLATE 129
+#define ZMQ_WS_DEFLATE_THRESHOLD 130
+#define ZMQ_WS_DEFLATE_NO_CONTEXT_TAKEOVER 131
+#define ZMQ_WS_FRAGMENT_SIZE 132
+#define ZMQ_CURVE_TICKET_LIFETIME 133
+#define ZMQ_CURVE_CIPHER 134
+#define ZMQ_ZAP_CACHE_TTL 135
+#define ZMQ_ZAP_CACHE_SIZE 136
+#define ZMQ_ZMTP_V3_ONLY 137
+#define ZMQ_TCP_FASTOPEN 138
 
 /*  DRAFT ZMQ_NORM_MODE options                                               */
 #define ZMQ_NORM_FIXED 0
@@ -62,6 +76,10 @@
 #define ZMQ_NORM_CCE 3
 #define ZMQ_NORM_CCE_ECNONLY 4
 
+/*  DRAFT ZMQ_CURVE_CIPHER options                                            */
+#define ZMQ_CURVE_CIPHER_XSALSA20POLY1305 0
+#define ZMQ_CURVE_CIPHER_AES256GCM 1
+
 /*  DRAFT ZMQ_RECONNECT_STOP options                                          */
 #define ZMQ_RECONNECT_STOP_CONN_REFUSED 0x1
 #define ZMQ_RECONNECT_STOP_HANDSHAKE_FAILED 0x2
@@ -69,6 +87,14 @@
 
 /*  DRAFT Context options                                                     */
 #define ZMQ_ZERO_COPY_RECV 10
+#define ZMQ_MAX_QUEUED_BYTES 11
+#define ZMQ_HUGEPAGES 12
+#define ZMQ_MSG_PIPE_GRANULARITY 13
+#define ZMQ_CMD_PIPE_GRANULARITY 14
+#define ZMQ_PIPE_CHUNK_CACHE 15
+#define ZMQ_CRYPTO_THREADS 16
+#define ZMQ_DNS_CACHE_TTL 17
+#define ZMQ_DNS_CACHE_NEGATIVE_TTL 18
 
 /*  DRAFT Context methods.                                                    */
 int zmq_ctx_set_ext (void *context_,
@@ -80,6 +106,12 @@ int zmq_ctx_get_ext (void *context_,
                      void *optval_,
                      size_t *optvallen_);
 
+typedef void *(zmq_alloc_fn) (size_t size_, void *hint_);
+int zmq_ctx_set_allocator (void *context_,
+                           zmq_alloc_fn *alloc_fn_,
+                           zmq_free_fn *free_fn_,
+                           void *hint_);
+
 /*  DRAFT Socket methods.                                                     */
 int zmq_join (void *s_, const char *group_);
 int zmq_leave (void *s_, const char *group_);
@@ -90,6 +122,7 @@ uint32_t zmq_msg_routing_id (zmq_msg_t *msg_);
 int zmq_msg_set_group (zmq_msg_t *msg_, const char *group_);
 const char *zmq_msg_group (zmq_msg_t *msg_);
 int zmq_msg_init_buffer (zmq_msg_t *msg_, const void *buf_, size_t size_);
+int zmq_msg_init_static (zmq_msg_t *msg_, const void *data_, size_t size_);
 
 /*  DRAFT Msg property names.                                                 */
 #define ZMQ_MSG_PROPERTY_ROUTING_ID "Routing-Id"
@@ -21,6 +21,7 @@
 #include "v2_encoder.hpp"
 #include "v2_decoder.hpp"
 #include "v3_1_encoder.hpp"
+#include "v2_protocol.hpp"
 #include "null_mechanism.hpp"
 #include "plain_client.hpp"
 #include "plain_server.hpp"
@@ -39,10 +40,12 @@
 zmq::zmtp_engine_t::zmtp_engine_t (
   fd_t fd_,
   const options_t &options_,
-  const endpoint_uri_pair_t &endpoint_uri_pair_) :
+  const endpoint_uri_pair_t &endpoint_uri_pair_,
+  size_t greeting_bytes_sent_) :
     stream_engine_base_t (fd_, options_, endpoint_uri_pair_, true),
     _greeting_size (v2_greeting_size),
     _greeting_bytes_read (0),
+    _greeting_bytes_sent (greeting_bytes_sent_),
     _subscription_required (false),
     _heartbeat_timeout (0)
 {
@@ -83,8 +86,22 @@ void zmq::zmtp_engine_t::plug_internal ()
     _outsize += 8;
     _outpos[_outsize++] = 0x7f;
 
+    //  Without older peers to cater for, there is no need to wait for the
+    //  peer's version before sending the rest of the greeting.
+    if (_options.zmtp_v3_only) {
+        _outpos[_outsize++] = 3; //  Major version number
+        add_v3_greeting ();
+        add_first_command ();
+    }
+
+    //  Skip what went out on the SYN with TCP Fast Open.
+    zmq_assert (_greeting_bytes_sent <= _outsize);
+    _outpos += _greeting_bytes_sent;
+    _outsize -= _greeting_bytes_sent;
+
     set_pollin ();
-    set_pollout ();
+    if (_outsize > 0)
+        set_pollout ();
     //  Flush all the data that may have been already received downstream.
     in_event ();
 }
@@ -102,6 +119,13 @@ bool zmq::zmtp_engine_t::handshake ()
         return false;
     const bool unversioned = rc != 0;
 
+    if (_options.zmtp_v3_only
+        && (unversioned || _greeting_recv[revision_pos] == ZMTP_1_0
+            || _greeting_recv[revision_pos] == ZMTP_2_0)) {
+        error (protocol_error);
+        return false;
+    }
+
     if (!(this
             ->*select_handshake_fun (unversioned, _greeting_recv[revision_pos],
                                      _greeting_recv[minor_pos])) ())
@@ -156,6 +180,15 @@ int zmq::zmtp_engine_t::receive_greeting ()
 
 void zmq::zmtp_engine_t::receive_greeting_versioned ()
 {
+    //  The whole greeting has been sent already, just wait for the peer's.
+    if (_options.zmtp_v3_only) {
+        if (_greeting_bytes_read > signature_size
+            && _greeting_recv[revision_pos] != ZMTP_1_0
+            && _greeting_recv[revision_pos] != ZMTP_2_0)
+            _greeting_size = v3_greeting_size;
+        return;
+    }
+
     //  Send the major version number.
     if (_outpos + _outsize == _greeting_send + signature_size) {
         if (_outsize == 0)
@@ -173,31 +206,86 @@ void zmq::zmtp_engine_t::receive_greeting_versioned ()
                 || _greeting_recv[revision_pos] == ZMTP_2_0)
                 _outpos[_outsize++] = _options.type;
             else {
-                _outpos[_outsize++] = 1; //  Minor version number
-                memset (_outpos + _outsize, 0, 20);
-
-                zmq_assert (_options.mechanism == ZMQ_NULL
-                            || _options.mechanism == ZMQ_PLAIN
-                            || _options.mechanism == ZMQ_CURVE
-                            || _options.mechanism == ZMQ_GSSAPI);
-
-                if (_options.mechanism == ZMQ_NULL)
-                    memcpy (_outpos + _outsize, "NULL", 4);
-                else if (_options.mechanism == ZMQ_PLAIN)
-                    memcpy (_outpos + _outsize, "PLAIN", 5);
-                else if (_options.mechanism == ZMQ_GSSAPI)
-                    memcpy (_outpos + _outsize, "GSSAPI", 6);
-                else if (_options.mechanism == ZMQ_CURVE)
-                    memcpy (_outpos + _outsize, "CURVE", 5);
-                _outsize += 20;
-                memset (_outpos + _outsize, 0, 32);
-                _outsize += 32;
+                add_v3_greeting ();
                 _greeting_size = v3_greeting_size;
             }
         }
     }
 }
 
+void zmq::zmtp_engine_t::add_v3_greeting ()
+{
+    _outpos[_outsize++] = 1; //  Minor version number
+    memset (_outpos + _outsize, 0, 20);
+
+    zmq_assert (_options.mechanism == ZMQ_NULL
+                || _options.mechanism == ZMQ_PLAIN
+                || _options.mechanism == ZMQ_CURVE
+                || _options.mechanism == ZMQ_GSSAPI);
+
+    if (_options.mechanism == ZMQ_NULL)
+        memcpy (_outpos + _outsize, "NULL", 4);
+    else if (_options.mechanism == ZMQ_PLAIN)
+        memcpy (_outpos + _outsize, "PLAIN", 5);
+    else if (_options.mechanism == ZMQ_GSSAPI)
+        memcpy (_outpos + _outsize, "GSSAPI", 6);
+    else if (_options.mechanism == ZMQ_CURVE)
+        memcpy (_outpos + _outsize, "CURVE", 5);
+    _outsize += 20;
+    memset (_outpos + _outsize, 0, 32);
+    _outsize += 32;
+}
+
+void zmq::zmtp_engine_t::add_first_command ()
+{
+    //  Only mechanisms whose first command depends neither on the peer's
+    //  minor version nor on the ZAP handler can start this early. The
+    //  others wait for the peer's greeting as usual.
+    if (_options.mechanism == ZMQ_NULL && !session ()->zap_enabled ()) {
+        _mechanism = new (std::nothrow)
+          null_mechanism_t (session (), _peer_address, _options);
+        alloc_assert (_mechanism);
+    } else if (_options.mechanism == ZMQ_PLAIN && !_options.as_server) {
+        _mechanism = new (std::nothrow) plain_client_t (session (), _options);
+        alloc_assert (_mechanism);
+    } else
+        return;
+
+    msg_t msg;
+    int rc = msg.init ();
+    errno_assert (rc == 0);
+
+    //  The command is framed the way both the ZMTP/3.0 and ZMTP/3.1
+    //  encoders would, so it doesn't matter which one the peer's greeting
+    //  selects later.
+    if (_mechanism->next_handshake_command (&msg) == 0) {
+        const size_t size = msg.size ();
+        unsigned char header[9];
+        size_t header_size = 2;
+        header[0] = v2_protocol_t::command_flag;
+        if (size > UCHAR_MAX) {
+            header[0] |= v2_protocol_t::large_flag;
+            put_uint64 (header + 1, size);
+            header_size = 9;
+        } else
+            header[1] = static_cast<unsigned char> (size);
+
+        const unsigned char *const data =
+          static_cast<const unsigned char *> (msg.data ());
+        _first_command_send.reserve (_outsize + header_size + size);
+        _first_command_send.assign (_outpos, _outpos + _outsize);
+        _first_command_send.insert (_first_command_send.end (), header,
+                                    header + header_size);
+        _first_command_send.insert (_first_command_send.end (), data,
+                                    data + size);
+        _outpos = &_first_command_send[0];
+        _outsize = _first_command_send.size ();
+    }
+
+    rc = msg.close ();
+    errno_assert (rc == 0);
+}
+
 zmq::zmtp_engine_t::handshake_fun_t zmq::zmtp_engine_t::select_handshake_fun (
   bool unversioned_, unsigned char revision_, unsigned char minor_)
 {
@@ -231,11 +319,13 @@ bool zmq::zmtp_engine_t::handshake_v1_0_unversioned ()
         return false;
     }
 
-    _encoder = new (std::nothrow) v1_encoder_t (_options.out_batch_size);
+    _encoder = new (std::nothrow)
+      v1_encoder_t (_options.out_batch_size, _options.allocator);
     alloc_assert (_encoder);
 
     _decoder = new (std::nothrow)
-      v1_decoder_t (_options.in_batch_size, _options.maxmsgsize);
+      v1_decoder_t (_options.in_batch_size, _options.maxmsgsize,
+                    _options.allocator);
     alloc_assert (_decoder);
 
     //  We have already sent the message header.
@@ -287,11 +377,13 @@ bool zmq::zmtp_engine_t::handshake_v1_0 ()
         return false;
     }
 
-    _encoder = new (std::nothrow) v1_encoder_t (_options.out_batch_size);
+    _encoder = new (std::nothrow)
+      v1_encoder_t (_options.out_batch_size, _options.allocator);
     alloc_assert (_encoder);
 
     _decoder = new (std::nothrow)
-      v1_decoder_t (_options.in_batch_size, _options.maxmsgsize);
+      v1_decoder_t (_options.in_batch_size, _options.maxmsgsize,
+                    _options.allocator);
     alloc_assert (_decoder);
 
     return true;
@@ -305,11 +397,13 @@ bool zmq::zmtp_engine_t::handshake_v2_0 ()
         return false;
     }
 
-    _encoder = new (std::nothrow) v2_encoder_t (_options.out_batch_size);
+    _encoder = new (std::nothrow)
+      v2_encoder_t (_options.out_batch_size, _options.allocator);
     alloc_assert (_encoder);
 
-    _decoder = new (std::nothrow) v2_decoder_t (
-      _options.in_batch_size, _options.maxmsgsize, _options.zero_copy);
+    _decoder = new (std::nothrow)
+      v2_decoder_t (_options.in_batch_size, _options.maxmsgsize,
+                    _options.zero_copy, _options.allocator);
     alloc_assert (_decoder);
 
     return true;
@@ -317,7 +411,17 @@ bool zmq::zmtp_engine_t::handshake_v2_0 ()
 
 bool zmq::zmtp_engine_t::handshake_v3_x (const bool downgrade_sub_)
 {
-    if (_options.mechanism == ZMQ_NULL
+    //  The mechanism that has sent its first command along with the
+    //  greeting is kept, provided the peer uses the same one.
+    if (_mechanism) {
+        if (memcmp (_greeting_recv + 12, _greeting_send + 12, 20) != 0) {
+            socket ()->event_handshake_failed_protocol (
+              session ()->get_endpoint (),
+              ZMQ_PROTOCOL_ERROR_ZMTP_MECHANISM_MISMATCH);
+            error (protocol_error);
+            return false;
+        }
+    } else if (_options.mechanism == ZMQ_NULL
         && memcmp (_greeting_recv + 12, "NULL\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0",
                    20)
              == 0) {
@@ -342,8 +446,9 @@ bool zmq::zmtp_engine_t::handshake_v3_x (const bool downgrade_sub_)
                         "CURVE\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 20)
                   == 0) {
         if (_options.as_server)
-            _mechanism = new (std::nothrow) curve_server_t (
-              session (), _peer_address, _options, downgrade_sub_);
+            _mechanism = new (std::nothrow)
+              curve_server_t (session (), _peer_address, _options,
+                              downgrade_sub_, _crypto_notifier);
         else
             _mechanism = new (std::nothrow)
               curve_client_t (session (), _options, downgrade_sub_);
@@ -382,11 +487,13 @@ bool zmq::zmtp_engine_t::handshake_v3_x (const bool downgrade_sub_)
 
 bool zmq::zmtp_engine_t::handshake_v3_0 ()
 {
-    _encoder = new (std::nothrow) v2_encoder_t (_options.out_batch_size);
+    _encoder = new (std::nothrow)
+      v2_encoder_t (_options.out_batch_size, _options.allocator);
     alloc_assert (_encoder);
 
-    _decoder = new (std::nothrow) v2_decoder_t (
-      _options.in_batch_size, _options.maxmsgsize, _options.zero_copy);
+    _decoder = new (std::nothrow)
+      v2_decoder_t (_options.in_batch_size, _options.maxmsgsize,
+                    _options.zero_copy, _options.allocator);
     alloc_assert (_decoder);
 
     return zmq::zmtp_engine_t::handshake_v3_x (true);
@@ -394,11 +501,13 @@ bool zmq::zmtp_engine_t::handshake_v3_0 ()
 
 bool zmq::zmtp_engine_t::handshake_v3_1 ()
 {
-    _encoder = new (std::nothrow) v3_1_encoder_t (_options.out_batch_size);
+    _encoder = new (std::nothrow)
+      v3_1_encoder_t (_options.out_batch_size, _options.allocator);
     alloc_assert (_encoder);
 
-    _decoder = new (std::nothrow) v2_decoder_t (
-      _options.in_batch_size, _options.maxmsgsize, _options.zero_copy);
+    _decoder = new (std::nothrow)
+      v2_decoder_t (_options.in_batch_size, _options.maxmsgsize,
+                    _options.zero_copy, _options.allocator);
     alloc_assert (_decoder);
 
     return zmq::zmtp_engine_t::handshake_v3_x (false);
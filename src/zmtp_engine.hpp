@@ -4,6 +4,7 @@
 #define __ZMQ_ZMTP_ENGINE_HPP_INCLUDED__
 
 #include <stddef.h>
+#include <vector>
 
 #include "fd.hpp"
 #include "i_engine.hpp"
@@ -38,7 +39,8 @@ class zmtp_engine_t ZMQ_FINAL : public stream_engine_base_t
   public:
     zmtp_engine_t (fd_t fd_,
                    const options_t &options_,
-                   const endpoint_uri_pair_t &endpoint_uri_pair_);
+                   const endpoint_uri_pair_t &endpoint_uri_pair_,
+                   size_t greeting_bytes_sent_ = 0);
     ~zmtp_engine_t ();
 
   protected:
@@ -57,6 +59,14 @@ class zmtp_engine_t ZMQ_FINAL : public stream_engine_base_t
     int receive_greeting ();
     void receive_greeting_versioned ();
 
+    //  Add the part of the ZMTP/3.x greeting that follows the major
+    //  version number to the output.
+    void add_v3_greeting ();
+
+    //  Add the mechanism's first command to the output, if it can be sent
+    //  before the peer's greeting has arrived.
+    void add_first_command ();
+
     typedef bool (zmtp_engine_t::*handshake_fun_t) ();
     static handshake_fun_t select_handshake_fun (bool unversioned,
                                                  unsigned char revision,
@@ -95,6 +105,12 @@ class zmtp_engine_t ZMQ_FINAL : public stream_engine_base_t
     //  Size of greeting received so far
     unsigned int _greeting_bytes_read;
 
+    //  Number of leading greeting bytes the connecter has sent already.
+    const size_t _greeting_bytes_sent;
+
+    //  Greeting and first handshake command, if they are sent together.
+    std::vector<unsigned char> _first_command_send;
+
     //  Indicates whether the engine is to inject a phantom
     //  subscription message into the incoming stream.
     //  Needed to support old peers.
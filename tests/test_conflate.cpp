@@ -39,11 +39,62 @@ void test_conflate ()
     test_context_socket_close (s_out);
 }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+void test_conflate_keyed ()
+{
+    char my_endpoint[MAX_SOCKET_STRING];
+
+    void *s_in = test_context_socket (ZMQ_PULL);
+
+    int conflate = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (s_in, ZMQ_CONFLATE, &conflate, sizeof (conflate)));
+    int key_size = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (s_in, ZMQ_CONFLATE_KEY_SIZE,
+                                               &key_size, sizeof (key_size)));
+    bind_loopback_ipv4 (s_in, my_endpoint, sizeof my_endpoint);
+
+    void *s_out = test_context_socket (ZMQ_PUSH);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (s_out, my_endpoint));
+
+    //  Interleave updates for three keys, 'A', 'B' and 'C'.
+    const char keys[] = "ABC";
+    const int update_count = 10;
+    for (int j = 0; j < update_count; ++j) {
+        for (int k = 0; k < 3; ++k) {
+            const char update[] = {keys[k], static_cast<char> ('0' + j), 0};
+            send_string_expect_success (s_out, update, 0);
+        }
+    }
+    msleep (SETTLE_TIME);
+
+    //  The last update of each key is kept, in first-written key order.
+    for (int k = 0; k < 3; ++k) {
+        const char last[] = {keys[k],
+                             static_cast<char> ('0' + update_count - 1), 0};
+        recv_string_expect_success (s_in, last, 0);
+    }
+
+    int rcvtimeo = 0;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (s_in, ZMQ_RCVTIMEO, &rcvtimeo, sizeof (rcvtimeo)));
+    char buf[2];
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN, zmq_recv (s_in, buf, sizeof buf, 0));
+
+    test_context_socket_close (s_in);
+    test_context_socket_close (s_out);
+}
+#endif
+
 int main (int, char *[])
 {
     setup_test_environment ();
 
     UNITY_BEGIN ();
     RUN_TEST (test_conflate);
+#ifdef ZMQ_BUILD_DRAFT_API
+    RUN_TEST (test_conflate_keyed);
+#endif
     return UNITY_END ();
 }
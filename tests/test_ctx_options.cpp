@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: MPL-2.0 */
 
 #include <limits>
+#include <string.h>
 #include "testutil.hpp"
 #include "testutil_unity.hpp"
 
@@ -178,6 +179,484 @@ void test_ctx_zero_copy ()
 #endif
 }
 
+void test_ctx_max_queued_bytes ()
+{
+#ifdef ZMQ_MAX_QUEUED_BYTES
+    TEST_ASSERT_EQUAL_INT (
+      0, zmq_ctx_get (get_test_context (), ZMQ_MAX_QUEUED_BYTES));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_MAX_QUEUED_BYTES, 10000));
+    TEST_ASSERT_EQUAL_INT (
+      10000, zmq_ctx_get (get_test_context (), ZMQ_MAX_QUEUED_BYTES));
+
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://budget"));
+    void *push = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://budget"));
+
+    //  The pipe HWM is far away, the budget stops the sender after about
+    //  10000 bytes plus the accounting batch.
+    char buf[1000];
+    memset (buf, 0, sizeof (buf));
+    int send_count = 0;
+    while (send_count < 1000
+           && zmq_send (push, buf, sizeof (buf), ZMQ_DONTWAIT)
+                == (int) sizeof (buf))
+        ++send_count;
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT (10, send_count);
+    TEST_ASSERT_LESS_THAN_INT (100, send_count);
+
+    //  Draining the queue releases the budget.
+    for (int i = 0; i < send_count; ++i)
+        TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                               zmq_recv (pull, buf, sizeof (buf), 0));
+    TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                           zmq_send (push, buf, sizeof (buf), ZMQ_DONTWAIT));
+
+    //  So does lifting the budget, without any bytes moving.
+    while (zmq_send (push, buf, sizeof (buf), ZMQ_DONTWAIT)
+           == (int) sizeof (buf))
+        ;
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_MAX_QUEUED_BYTES, 0));
+    TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                           zmq_send (push, buf, sizeof (buf), ZMQ_DONTWAIT));
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+#endif
+}
+
+void test_ctx_max_queued_bytes_lossy ()
+{
+#ifdef ZMQ_MAX_QUEUED_BYTES
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_MAX_QUEUED_BYTES, 30000));
+
+    void *pub = test_context_socket (ZMQ_XPUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://budget-lossy"));
+    void *sub = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://budget-lossy"));
+    const int timeout = 1000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_RCVTIMEO, &timeout, sizeof (timeout)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    recv_string_expect_success (pub, "\1", 0);
+
+    //  Messages above the accounting batch are counted as they are sent,
+    //  so the third one uses up the budget and the fourth is dropped.
+    char buf[10000];
+    for (char i = 0; i < 4; ++i) {
+        buf[0] = i;
+        TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                               zmq_send (pub, buf, sizeof (buf), 0));
+    }
+
+    //  Lifting the budget lets messages through again right away.
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_MAX_QUEUED_BYTES, 0));
+    buf[0] = 4;
+    TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                           zmq_send (pub, buf, sizeof (buf), 0));
+
+    const char expected[] = {0, 1, 2, 4};
+    for (size_t i = 0; i < sizeof (expected); ++i) {
+        TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                               zmq_recv (sub, buf, sizeof (buf), 0));
+        TEST_ASSERT_EQUAL_INT (expected[i], buf[0]);
+    }
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                               zmq_recv (sub, buf, sizeof (buf), ZMQ_DONTWAIT));
+
+    test_context_socket_close (sub);
+    test_context_socket_close (pub);
+#endif
+}
+
+void test_ctx_max_queued_bytes_unread_input ()
+{
+#ifdef ZMQ_MAX_QUEUED_BYTES
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_MAX_QUEUED_BYTES, 100000));
+
+    void *a = test_context_socket (ZMQ_DEALER);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (a, endpoint, sizeof endpoint);
+    void *b = test_context_socket (ZMQ_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (b, endpoint));
+    const int timeout = 2000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (a, ZMQ_SNDTIMEO, &timeout, sizeof (timeout)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (b, ZMQ_SNDTIMEO, &timeout, sizeof (timeout)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (b, ZMQ_RCVTIMEO, &timeout, sizeof (timeout)));
+
+    //  What a hasn't read yet is bounded by its receive HWM, not by the
+    //  budget, so b keeps going well past it and a can still reply.
+    char buf[10000];
+    memset (buf, 0, sizeof (buf));
+    const int count = 30;
+    for (int i = 0; i < count; ++i)
+        TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                               zmq_send (b, buf, sizeof (buf), 0));
+    send_string_expect_success (a, "x", 0);
+    recv_string_expect_success (b, "x", 0);
+
+    for (int i = 0; i < count; ++i)
+        TEST_ASSERT_EQUAL_INT ((int) sizeof (buf),
+                               zmq_recv (a, buf, sizeof (buf), 0));
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_MAX_QUEUED_BYTES, 0));
+    test_context_socket_close (b);
+    test_context_socket_close (a);
+#endif
+}
+
+#ifdef ZMQ_HUGEPAGES
+//  Mostly small messages, every hundredth one larger than a pool region.
+static size_t hugepages_msg_size (int i_)
+{
+    if (i_ % 100 == 99)
+        return 3 * 1000 * 1000;
+    const size_t sizes[] = {10, 1000, 100 * 1000};
+    return sizes[i_ % 3];
+}
+#endif
+
+void test_ctx_hugepages ()
+{
+#ifdef ZMQ_HUGEPAGES
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (get_test_context (), ZMQ_HUGEPAGES));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_HUGEPAGES, 1));
+    TEST_ASSERT_EQUAL_INT (1, zmq_ctx_get (get_test_context (), ZMQ_HUGEPAGES));
+
+    //  Works whether or not the system provides hugepages. Enough messages
+    //  to span several pipe chunks, some larger than a pool region.
+    const char *endpoints[] = {"inproc://hugepages", "tcp://127.0.0.1:*"};
+    for (size_t e = 0; e < sizeof endpoints / sizeof endpoints[0]; e++) {
+        void *pull = test_context_socket (ZMQ_PULL);
+        char endpoint[MAX_SOCKET_STRING];
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, endpoints[e]));
+        size_t len = sizeof endpoint;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &len));
+        void *push = test_context_socket (ZMQ_PUSH);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+        const size_t max_size = hugepages_msg_size (99);
+        const int count = 1000;
+        char *buf = static_cast<char *> (malloc (max_size));
+        TEST_ASSERT_NOT_NULL (buf);
+        for (int i = 0; i < count; i++) {
+            const size_t size = hugepages_msg_size (i);
+            memset (buf, 'a' + i % 26, size);
+            TEST_ASSERT_EQUAL_INT ((int) size, zmq_send (push, buf, size, 0));
+        }
+        for (int i = 0; i < count; i++) {
+            const size_t size = hugepages_msg_size (i);
+            TEST_ASSERT_EQUAL_INT ((int) size,
+                                   zmq_recv (pull, buf, max_size, 0));
+            TEST_ASSERT_EQUAL_INT ('a' + i % 26, buf[size - 1]);
+        }
+        free (buf);
+
+        test_context_socket_close (push);
+        test_context_socket_close (pull);
+    }
+#endif
+}
+
+void test_ctx_pipe_options ()
+{
+#ifdef ZMQ_PIPE_CHUNK_CACHE
+    void *ctx = get_test_context ();
+    TEST_ASSERT_EQUAL_INT (256, zmq_ctx_get (ctx, ZMQ_MSG_PIPE_GRANULARITY));
+    TEST_ASSERT_EQUAL_INT (16, zmq_ctx_get (ctx, ZMQ_CMD_PIPE_GRANULARITY));
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (ctx, ZMQ_PIPE_CHUNK_CACHE));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set (ctx, ZMQ_MSG_PIPE_GRANULARITY, 0));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set (ctx, ZMQ_PIPE_CHUNK_CACHE, -1));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (ctx, ZMQ_MSG_PIPE_GRANULARITY, 8));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (ctx, ZMQ_CMD_PIPE_GRANULARITY, 2));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (ctx, ZMQ_PIPE_CHUNK_CACHE, 1024 * 1024));
+    TEST_ASSERT_EQUAL_INT (8, zmq_ctx_get (ctx, ZMQ_MSG_PIPE_GRANULARITY));
+    TEST_ASSERT_EQUAL_INT (2, zmq_ctx_get (ctx, ZMQ_CMD_PIPE_GRANULARITY));
+    TEST_ASSERT_EQUAL_INT (1024 * 1024,
+                           zmq_ctx_get (ctx, ZMQ_PIPE_CHUNK_CACHE));
+
+    //  Bursts span many chunks, which are recycled between the pipes.
+    const char *endpoints[] = {"inproc://pipe-options", "tcp://127.0.0.1:*"};
+    for (int round = 0; round < 2; round++) {
+        for (size_t e = 0; e < sizeof endpoints / sizeof endpoints[0]; e++) {
+            void *pull = test_context_socket (ZMQ_PULL);
+            char endpoint[MAX_SOCKET_STRING];
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, endpoints[e]));
+            size_t len = sizeof endpoint;
+            TEST_ASSERT_SUCCESS_ERRNO (
+              zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &len));
+            void *push = test_context_socket (ZMQ_PUSH);
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+            const int count = 500;
+            for (int i = 0; i < count; i++)
+                TEST_ASSERT_EQUAL_INT (
+                  (int) sizeof i, zmq_send (push, &i, sizeof i, 0));
+            for (int i = 0; i < count; i++) {
+                int value = -1;
+                TEST_ASSERT_EQUAL_INT ((int) sizeof value,
+                                       zmq_recv (pull, &value, sizeof value, 0));
+                TEST_ASSERT_EQUAL_INT (i, value);
+            }
+
+            test_context_socket_close (push);
+            test_context_socket_close (pull);
+        }
+    }
+
+    //  Fixed once the first socket was created.
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set (ctx, ZMQ_MSG_PIPE_GRANULARITY, 16));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set (ctx, ZMQ_PIPE_CHUNK_CACHE, 0));
+    TEST_ASSERT_EQUAL_INT (8, zmq_ctx_get (ctx, ZMQ_MSG_PIPE_GRANULARITY));
+#endif
+}
+
+void test_ctx_crypto_threads ()
+{
+#ifdef ZMQ_CRYPTO_THREADS
+    void *ctx = get_test_context ();
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (ctx, ZMQ_CRYPTO_THREADS));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set (ctx, ZMQ_CRYPTO_THREADS, -1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (ctx, ZMQ_CRYPTO_THREADS, 2));
+    TEST_ASSERT_EQUAL_INT (2, zmq_ctx_get (ctx, ZMQ_CRYPTO_THREADS));
+
+    //  The pool starts with the first socket and stops with the context.
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://crypto-threads"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://crypto-threads"));
+    send_string_expect_success (push, "hello", 0);
+    recv_string_expect_success (pull, "hello", 0);
+
+    //  Fixed once the pool is started.
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set (ctx, ZMQ_CRYPTO_THREADS, 0));
+    TEST_ASSERT_EQUAL_INT (2, zmq_ctx_get (ctx, ZMQ_CRYPTO_THREADS));
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+#endif
+}
+
+void test_ctx_dns_cache ()
+{
+#ifdef ZMQ_DNS_CACHE_TTL
+    void *ctx = get_test_context ();
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (ctx, ZMQ_DNS_CACHE_TTL));
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (ctx, ZMQ_DNS_CACHE_NEGATIVE_TTL));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set (ctx, ZMQ_DNS_CACHE_TTL, -1));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_ctx_set (ctx, ZMQ_DNS_CACHE_NEGATIVE_TTL, -1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (ctx, ZMQ_DNS_CACHE_TTL, 60000));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (ctx, ZMQ_DNS_CACHE_NEGATIVE_TTL, 1000));
+    TEST_ASSERT_EQUAL_INT (60000, zmq_ctx_get (ctx, ZMQ_DNS_CACHE_TTL));
+    TEST_ASSERT_EQUAL_INT (1000,
+                           zmq_ctx_get (ctx, ZMQ_DNS_CACHE_NEGATIVE_TTL));
+
+    //  The sockets connecting to the same name share its lookup, whether
+    //  it is still running or done already.
+    void *pull = test_context_socket (ZMQ_PULL);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (pull, endpoint, sizeof endpoint);
+    const char *const port = strrchr (endpoint, ':');
+    char name[MAX_SOCKET_STRING];
+    snprintf (name, sizeof name, "tcp://localhost%s", port);
+
+    const int push_count = 4;
+    void *push[push_count];
+    for (int i = 0; i != push_count; i++) {
+        push[i] = test_context_socket (ZMQ_PUSH);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push[i], name));
+    }
+    for (int i = 0; i != push_count; i++)
+        send_string_expect_success (push[i], "hello", 0);
+    for (int i = 0; i != push_count; i++)
+        recv_string_expect_success (pull, "hello", 0);
+
+    //  A connecter that goes away while its lookup may still be running
+    //  doesn't hold up the context.
+    void *late = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (late, "tcp://localhost:5555"));
+    test_context_socket_close_zero_linger (late);
+
+    //  The running cache can't be turned off or retuned.
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_ctx_set (ctx, ZMQ_DNS_CACHE_TTL, 0));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_ctx_set (ctx, ZMQ_DNS_CACHE_NEGATIVE_TTL, 0));
+    TEST_ASSERT_EQUAL_INT (60000, zmq_ctx_get (ctx, ZMQ_DNS_CACHE_TTL));
+
+    for (int i = 0; i != push_count; i++)
+        test_context_socket_close (push[i]);
+    test_context_socket_close (pull);
+#endif
+}
+
+#ifdef ZMQ_BUILD_DRAFT_API
+struct alloc_counters_t
+{
+    void *allocated;
+    void *live;
+};
+
+static void *counting_alloc (size_t size_, void *hint_)
+{
+    alloc_counters_t *counters = static_cast<alloc_counters_t *> (hint_);
+    zmq_atomic_counter_inc (counters->allocated);
+    zmq_atomic_counter_inc (counters->live);
+    return malloc (size_);
+}
+
+static void counting_free (void *data_, void *hint_)
+{
+    alloc_counters_t *counters = static_cast<alloc_counters_t *> (hint_);
+    zmq_atomic_counter_dec (counters->live);
+    free (data_);
+}
+#endif
+
+void test_ctx_allocator ()
+{
+#ifdef ZMQ_BUILD_DRAFT_API
+    alloc_counters_t counters;
+    counters.allocated = zmq_atomic_counter_new ();
+    counters.live = zmq_atomic_counter_new ();
+
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+
+    //  Both hooks or none.
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_ctx_set_allocator (ctx, counting_alloc, NULL, &counters));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set_allocator (ctx, counting_alloc, counting_free, &counters));
+
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    TEST_ASSERT_NOT_NULL (pull);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (pull, endpoint, sizeof endpoint);
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    TEST_ASSERT_NOT_NULL (push);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    //  Larger than the decoder's buffer, so the message content is
+    //  allocated on its own.
+    const size_t size = 64 * 1024;
+    char *buf = static_cast<char *> (malloc (size));
+    TEST_ASSERT_NOT_NULL (buf);
+    memset (buf, 'x', size);
+    TEST_ASSERT_EQUAL_INT ((int) size, zmq_send (push, buf, size, 0));
+    TEST_ASSERT_EQUAL_INT ((int) size, zmq_recv (pull, buf, size, 0));
+    TEST_ASSERT_EQUAL_INT ('x', buf[size - 1]);
+    free (buf);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (push));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+
+    //  The encoder and decoder buffers and the message went through the
+    //  hooks, and everything was given back.
+    TEST_ASSERT_GREATER_OR_EQUAL_INT (
+      3, zmq_atomic_counter_value (counters.allocated));
+    TEST_ASSERT_EQUAL_INT (0, zmq_atomic_counter_value (counters.live));
+
+    //  Removing the hooks again leaves sockets created afterwards with the
+    //  built-in allocation.
+    zmq_atomic_counter_set (counters.allocated, 0);
+    ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set_allocator (ctx, counting_alloc, counting_free, &counters));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set_allocator (ctx, NULL, NULL, NULL));
+    pull = zmq_socket (ctx, ZMQ_PULL);
+    TEST_ASSERT_NOT_NULL (pull);
+    bind_loopback_ipv4 (pull, endpoint, sizeof endpoint);
+    push = zmq_socket (ctx, ZMQ_PUSH);
+    TEST_ASSERT_NOT_NULL (push);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+    send_string_expect_success (push, "hello", 0);
+    recv_string_expect_success (pull, "hello", 0);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (push));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+    TEST_ASSERT_EQUAL_INT (0, zmq_atomic_counter_value (counters.allocated));
+
+    zmq_atomic_counter_destroy (&counters.allocated);
+    zmq_atomic_counter_destroy (&counters.live);
+#endif
+}
+
+void test_ctx_allocator_idle_buffers ()
+{
+#ifdef ZMQ_BUILD_DRAFT_API
+    alloc_counters_t counters;
+    counters.allocated = zmq_atomic_counter_new ();
+    counters.live = zmq_atomic_counter_new ();
+
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set_allocator (ctx, counting_alloc, counting_free, &counters));
+
+    void *server = zmq_socket (ctx, ZMQ_PAIR);
+    TEST_ASSERT_NOT_NULL (server);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (server, endpoint, sizeof endpoint);
+    void *client = zmq_socket (ctx, ZMQ_PAIR);
+    TEST_ASSERT_NOT_NULL (client);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    char buf[32];
+    send_string_expect_success (client, "ping", 0);
+    TEST_ASSERT_EQUAL_INT (4, zmq_recv (server, buf, sizeof buf, 0));
+    send_string_expect_success (server, "pong", 0);
+    TEST_ASSERT_EQUAL_INT (4, zmq_recv (client, buf, sizeof buf, 0));
+    TEST_ASSERT_GREATER_THAN_INT (0, zmq_atomic_counter_value (counters.live));
+
+    //  Idle connections give their buffers back...
+    for (int i = 0; i < 1000 && zmq_atomic_counter_value (counters.live) != 0;
+         i++)
+        msleep (10);
+    TEST_ASSERT_EQUAL_INT (0, zmq_atomic_counter_value (counters.live));
+
+    //  ...and get new ones once there is traffic again.
+    send_string_expect_success (client, "ping", 0);
+    TEST_ASSERT_EQUAL_INT (4, zmq_recv (server, buf, sizeof buf, 0));
+    send_string_expect_success (server, "pong", 0);
+    TEST_ASSERT_EQUAL_INT (4, zmq_recv (client, buf, sizeof buf, 0));
+    TEST_ASSERT_GREATER_THAN_INT (0, zmq_atomic_counter_value (counters.live));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (client));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (server));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+    TEST_ASSERT_EQUAL_INT (0, zmq_atomic_counter_value (counters.live));
+
+    zmq_atomic_counter_destroy (&counters.allocated);
+    zmq_atomic_counter_destroy (&counters.live);
+#endif
+}
+
 void test_ctx_option_max_sockets ()
 {
     TEST_ASSERT_EQUAL_INT (ZMQ_MAX_SOCKETS_DFLT,
@@ -277,6 +756,15 @@ int main (void)
     RUN_TEST (test_ctx_option_ipv6_set);
     RUN_TEST (test_ctx_thread_opts);
     RUN_TEST (test_ctx_zero_copy);
+    RUN_TEST (test_ctx_max_queued_bytes);
+    RUN_TEST (test_ctx_max_queued_bytes_lossy);
+    RUN_TEST (test_ctx_max_queued_bytes_unread_input);
+    RUN_TEST (test_ctx_hugepages);
+    RUN_TEST (test_ctx_pipe_options);
+    RUN_TEST (test_ctx_crypto_threads);
+    RUN_TEST (test_ctx_dns_cache);
+    RUN_TEST (test_ctx_allocator);
+    RUN_TEST (test_ctx_allocator_idle_buffers);
     RUN_TEST (test_ctx_option_blocky);
     RUN_TEST (test_ctx_option_invalid);
     return UNITY_END ();
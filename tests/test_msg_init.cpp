@@ -47,6 +47,50 @@ void test_msg_init_buffer ()
     TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg2));
 }
 
+void test_msg_init_static ()
+{
+#ifdef ZMQ_BUILD_DRAFT_API
+    static const char data[] = "a payload too long to be stored inline";
+    const size_t size = sizeof data - 1;
+
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_static (&msg, data, size));
+    TEST_ASSERT_EQUAL_INT (size, zmq_msg_size (&msg));
+    TEST_ASSERT_EQUAL_PTR (data, zmq_msg_data (&msg));
+    TEST_ASSERT_EQUAL_INT (1, zmq_msg_get (&msg, ZMQ_SHARED));
+
+    //  Copies refer to the same data.
+    zmq_msg_t copy;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&copy));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_copy (&copy, &msg));
+    TEST_ASSERT_EQUAL_PTR (data, zmq_msg_data (&copy));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&copy));
+
+    //  Fan-out over inproc hands the same data to every subscriber.
+    void *pub = test_context_socket (ZMQ_PUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://static"));
+    void *subs[3];
+    for (int i = 0; i < 3; i++) {
+        subs[i] = test_context_socket (ZMQ_SUB);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (subs[i], ZMQ_SUBSCRIBE, "", 0));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (subs[i], "inproc://static"));
+    }
+    msleep (SETTLE_TIME);
+
+    TEST_ASSERT_EQUAL_INT (size, zmq_msg_send (&msg, pub, 0));
+    for (int i = 0; i < 3; i++) {
+        zmq_msg_t received;
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&received));
+        TEST_ASSERT_EQUAL_INT (size, zmq_msg_recv (&received, subs[i], 0));
+        TEST_ASSERT_EQUAL_PTR (data, zmq_msg_data (&received));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&received));
+        test_context_socket_close (subs[i]);
+    }
+    test_context_socket_close (pub);
+#endif
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -55,5 +99,6 @@ int main (void)
     RUN_TEST (test_msg_init);
     RUN_TEST (test_msg_init_size);
     RUN_TEST (test_msg_init_buffer);
+    RUN_TEST (test_msg_init_static);
     return UNITY_END ();
 }
@@ -87,6 +87,59 @@ void test_pair_tcp_fastpath ()
 }
 #endif
 
+static void fill (unsigned char *data_, size_t size_, size_t seed_)
+{
+    for (size_t i = 0; i < size_; i++)
+        data_[i] = static_cast<unsigned char> ((seed_ * 7 + i) % 251);
+}
+
+static int more (size_t index_, size_t count_)
+{
+    return index_ % 3 == 0 && index_ + 1 < count_;
+}
+
+void test_pair_tcp_mixed_sizes ()
+{
+    //  Large bodies are read straight into the message while the frames
+    //  after them land in the decoder's buffer, check both halves survive.
+    const size_t sizes[] = {100000, 5, 3000,    1024 * 1024, 40,
+                            9000,   34, 8192, 8193,        0};
+    const size_t count = sizeof sizes / sizeof sizes[0];
+
+    void *sb = test_context_socket (ZMQ_PAIR);
+    char my_endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (sb, my_endpoint, sizeof my_endpoint);
+    void *sc = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sc, my_endpoint));
+
+    unsigned char *buf = static_cast<unsigned char *> (malloc (1024 * 1024));
+    TEST_ASSERT_NOT_NULL (buf);
+    for (int round = 0; round < 3; round++)
+        for (size_t i = 0; i < count; i++) {
+            fill (buf, sizes[i], i);
+            TEST_ASSERT_EQUAL_INT (
+              (int) sizes[i],
+              zmq_send (sc, buf, sizes[i], more (i, count) ? ZMQ_SNDMORE : 0));
+        }
+
+    for (int round = 0; round < 3; round++)
+        for (size_t i = 0; i < count; i++) {
+            zmq_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+            TEST_ASSERT_EQUAL_INT ((int) sizes[i],
+                                   zmq_msg_recv (&msg, sb, 0));
+            TEST_ASSERT_EQUAL_INT (more (i, count), zmq_msg_more (&msg));
+            fill (buf, sizes[i], i);
+            if (sizes[i] > 0)
+                TEST_ASSERT_EQUAL_MEMORY (buf, zmq_msg_data (&msg), sizes[i]);
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+        }
+    free (buf);
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
 #ifdef _WIN32
 void test_io_completion_port ()
 {
@@ -123,6 +176,7 @@ int main ()
     UNITY_BEGIN ();
     RUN_TEST (test_pair_tcp_regular);
     RUN_TEST (test_pair_tcp_connect_by_name);
+    RUN_TEST (test_pair_tcp_mixed_sizes);
 #ifdef ZMQ_BUILD_DRAFT
     RUN_TEST (test_pair_tcp_fastpath);
 #endif
@@ -22,6 +22,12 @@
 #include "../src/curve_client_tools.hpp"
 #include "../src/random.hpp"
 
+#include <string>
+
+#ifdef ZMQ_HAVE_LINUX
+#include <dirent.h>
+#endif
+
 char error_message_buffer[256];
 
 void *handler;
@@ -30,9 +36,16 @@ void *server;
 void *server_mon;
 char my_endpoint[MAX_SOCKET_STRING];
 
+//  Threads of the context's crypto pool, 0 to handshake in the io thread.
+int crypto_threads = 0;
+
 void setUp ()
 {
     setup_test_context ();
+#ifdef ZMQ_CRYPTO_THREADS
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_CRYPTO_THREADS, crypto_threads));
+#endif
     setup_context_and_server_side (&handler, &zap_thread, &server, &server_mon,
                                    my_endpoint);
 }
@@ -125,6 +138,40 @@ void test_curve_security_with_valid_credentials ()
     test_context_socket_close (client_mon);
 }
 
+#ifdef ZMQ_HAVE_LINUX
+static int count_open_fds ()
+{
+    DIR *dir = opendir ("/proc/self/fd");
+    TEST_ASSERT_NOT_NULL (dir);
+    int count = 0;
+    while (readdir (dir))
+        ++count;
+    closedir (dir);
+    return count;
+}
+
+//  Once the handshake is done, a connection holds no more descriptors
+//  than without the crypto pool: the client's mailbox and the two ends
+//  of the TCP connection.
+void test_curve_crypto_pool_releases_signaler ()
+{
+    const int fds_before = count_open_fds ();
+
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *client = create_and_connect_client (
+      my_endpoint, socket_config_curve_client, &curve_client_data, NULL);
+    bounce (server, client);
+
+    TEST_ASSERT_EQUAL_INT (fds_before + 3, count_open_fds ());
+
+    test_context_socket_close (client);
+
+    int event = get_monitor_event_with_timeout (server_mon, NULL, NULL, -1);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED, event);
+}
+#endif
+
 void test_curve_security_with_bogus_client_credentials ()
 {
     //  This must be caught by the ZAP handler
@@ -493,6 +540,380 @@ void test_curve_security_invalid_keysize (void *ctx_)
     TEST_ASSERT_SUCCESS_ERRNO (zmq_close (client));
 }
 
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+//  Binds a server that issues tickets valid for lifetime_ msec, with a
+//  monitor of its handshakes.
+static void *
+bind_resuming_server (int lifetime_, char *endpoint_, void **server_mon_)
+{
+    void *resuming_server = test_context_socket (ZMQ_DEALER);
+    socket_config_curve_server (resuming_server, valid_server_secret);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (resuming_server, ZMQ_ROUTING_ID, "IDENT", 5));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (resuming_server, ZMQ_CURVE_TICKET_LIFETIME, &lifetime_,
+                      sizeof (lifetime_)));
+    bind_loopback_ipv4 (resuming_server, endpoint_, MAX_SOCKET_STRING);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_socket_monitor (
+      resuming_server, "inproc://monitor-resuming",
+      ZMQ_EVENT_HANDSHAKE_SUCCEEDED | ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL));
+    *server_mon_ = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_connect (*server_mon_, "inproc://monitor-resuming"));
+    return resuming_server;
+}
+
+static void *connect_resuming_client (const char *endpoint_)
+{
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *client = test_context_socket (ZMQ_DEALER);
+    socket_config_curve_client (client, &curve_client_data);
+    int lifetime = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      client, ZMQ_CURVE_TICKET_LIFETIME, &lifetime, sizeof (lifetime)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint_));
+    return client;
+}
+
+//  Drops the server's connections, so that its clients reconnect.
+static void rebind (void *server_, const char *endpoint_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_unbind (server_, endpoint_));
+
+    //  The listener is closed in the background
+    while (zmq_bind (server_, endpoint_) != 0) {
+        TEST_ASSERT_EQUAL_INT (EADDRINUSE, zmq_errno ());
+        msleep (10);
+    }
+}
+
+static void expect_handshake_event (void *server_,
+                                    void *server_mon_,
+                                    int expected_event_,
+                                    int expected_value_ = 0)
+{
+    //  Keep the server processing commands meanwhile, as dropping its
+    //  connections involves the socket.
+    int event;
+    int value;
+    do {
+        int events;
+        size_t events_size = sizeof (events);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_getsockopt (server_, ZMQ_EVENTS, &events, &events_size));
+        event = get_monitor_event_with_timeout (server_mon_, &value, NULL, 50);
+    } while (event == -1);
+
+    TEST_ASSERT_EQUAL_INT (expected_event_, event);
+    if (expected_value_)
+        TEST_ASSERT_EQUAL_INT (expected_value_, value);
+}
+
+void test_curve_session_resumption ()
+{
+    char endpoint[MAX_SOCKET_STRING];
+    void *resuming_server_mon;
+    void *resuming_server =
+      bind_resuming_server (60000, endpoint, &resuming_server_mon);
+    void *client = connect_resuming_client (endpoint);
+    bounce (resuming_server, client);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+
+    //  Resuming doesn't involve the server's long-term key, so it works
+    //  even after the key has changed.
+    char other_public[41];
+    char other_secret[41];
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_curve_keypair (other_public, other_secret));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (resuming_server, ZMQ_CURVE_SECRETKEY, other_secret, 41));
+    rebind (resuming_server, endpoint);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+    bounce (resuming_server, client);
+
+    //  The ticket is not passed on as metadata
+    send_string_expect_success (resuming_server, "ticket?", 0);
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, client, 0));
+    TEST_ASSERT_NULL (zmq_msg_gets (&msg, "Curve-Ticket"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+
+    test_context_socket_close (client);
+    zmq_socket_monitor (resuming_server, NULL, 0);
+    test_context_socket_close (resuming_server_mon);
+    test_context_socket_close (resuming_server);
+}
+
+void test_curve_session_resumption_with_expired_ticket ()
+{
+    char endpoint[MAX_SOCKET_STRING];
+    void *resuming_server_mon;
+    void *resuming_server =
+      bind_resuming_server (1, endpoint, &resuming_server_mon);
+    void *client = connect_resuming_client (endpoint);
+    bounce (resuming_server, client);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+
+    //  The server turns the ticket down, and the client falls back to the
+    //  full handshake when it reconnects once more.
+    msleep (SETTLE_TIME);
+    rebind (resuming_server, endpoint);
+    expect_handshake_event (
+      resuming_server, resuming_server_mon, ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL,
+      ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+    bounce (resuming_server, client);
+
+    test_context_socket_close (client);
+    zmq_socket_monitor (resuming_server, NULL, 0);
+    test_context_socket_close (resuming_server_mon);
+    test_context_socket_close (resuming_server);
+}
+
+//  Forwards the connections of a client to a server, keeping what the
+//  client sends on the connection after the first, which resumes the
+//  session.
+struct resume_proxy_t
+{
+    fd_t listener;
+    char server_endpoint[MAX_SOCKET_STRING];
+    std::string resumed;
+    volatile bool stop;
+};
+
+static void forward (fd_t from_, fd_t to_, std::string *recorded_, bool *open_)
+{
+    char buffer[1024];
+    const int rc = recv (from_, buffer, sizeof buffer, 0);
+    if (rc <= 0) {
+        *open_ = false;
+        return;
+    }
+    for (int sent = 0; sent < rc;) {
+        const int n = send (to_, buffer + sent, rc - sent, 0);
+        if (n <= 0) {
+            *open_ = false;
+            return;
+        }
+        sent += n;
+    }
+    if (recorded_)
+        recorded_->append (buffer, rc);
+}
+
+static void resume_proxy (void *arg_)
+{
+    resume_proxy_t *const proxy = static_cast<resume_proxy_t *> (arg_);
+
+    for (int connection = 0; connection < 2 && !proxy->stop; connection++) {
+        const fd_t client = accept (proxy->listener, NULL, NULL);
+        assert (client != retired_fd);
+        const fd_t server = connect_socket (proxy->server_endpoint);
+
+        std::string recorded;
+        zmq_pollitem_t items[] = {{NULL, client, ZMQ_POLLIN, 0},
+                                  {NULL, server, ZMQ_POLLIN, 0}};
+        bool open = true;
+        while (open && !proxy->stop) {
+            const int rc = zmq_poll (items, 2, 10);
+            assert (rc >= 0);
+            if (items[0].revents & ZMQ_POLLIN)
+                forward (client, server, &recorded, &open);
+            if (open && (items[1].revents & ZMQ_POLLIN))
+                forward (server, client, NULL, &open);
+        }
+        if (connection == 1)
+            proxy->resumed = recorded;
+
+        close (client);
+        close (server);
+    }
+}
+
+//  A RESUME captured on the wire is turned down when replayed.
+void test_curve_session_resumption_replayed ()
+{
+    resume_proxy_t proxy;
+    proxy.stop = false;
+    void *resuming_server_mon;
+    void *resuming_server =
+      bind_resuming_server (60000, proxy.server_endpoint, &resuming_server_mon);
+
+    char proxy_endpoint[MAX_SOCKET_STRING];
+    proxy.listener =
+      bind_socket_resolve_port ("127.0.0.1", "0", proxy_endpoint);
+    void *const proxy_thread = zmq_threadstart (resume_proxy, &proxy);
+
+    void *client = connect_resuming_client (proxy_endpoint);
+    bounce (resuming_server, client);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+    rebind (resuming_server, proxy.server_endpoint);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+    bounce (resuming_server, client);
+
+    proxy.stop = true;
+    zmq_threadclose (proxy_thread);
+    close (proxy.listener);
+
+    //  The greeting, then RESUME
+    const std::string &resumed = proxy.resumed;
+    TEST_ASSERT_GREATER_THAN_INT (66, resumed.size ());
+    const bool large = (resumed[64] & 0x02) != 0;
+    size_t resume_size = 0;
+    for (int i = 0; i < (large ? 8 : 1); i++)
+        resume_size = resume_size << 8 | static_cast<uint8_t> (resumed[65 + i]);
+    const size_t replay_size = 64 + (large ? 9 : 2) + resume_size;
+    TEST_ASSERT_LESS_OR_EQUAL (resumed.size (), replay_size);
+    TEST_ASSERT_EQUAL_INT (0, memcmp (resumed.data () + replay_size
+                                        - resume_size,
+                                      "\x06RESUME", 7));
+
+    const fd_t s = connect_socket (proxy.server_endpoint);
+    send_all (s, resumed.data (), static_cast<socket_size_t> (replay_size));
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL,
+                            ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+    close (s);
+
+    test_context_socket_close_zero_linger (client);
+    zmq_socket_monitor (resuming_server, NULL, 0);
+    test_context_socket_close (resuming_server_mon);
+    test_context_socket_close (resuming_server);
+}
+#endif
+
+#ifdef ZMQ_CURVE_CIPHER
+static void set_cipher (void *socket_, int cipher_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_CURVE_CIPHER, &cipher_, sizeof (cipher_)));
+}
+
+void test_curve_cipher_option ()
+{
+    void *socket = test_context_socket (ZMQ_DEALER);
+    int cipher;
+    size_t cipher_size = sizeof (cipher);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_CURVE_CIPHER, &cipher, &cipher_size));
+    TEST_ASSERT_EQUAL_INT (ZMQ_CURVE_CIPHER_XSALSA20POLY1305, cipher);
+
+    set_cipher (socket, ZMQ_CURVE_CIPHER_AES256GCM);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_CURVE_CIPHER, &cipher, &cipher_size));
+    TEST_ASSERT_EQUAL_INT (ZMQ_CURVE_CIPHER_AES256GCM, cipher);
+
+    cipher = 2;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_setsockopt (socket, ZMQ_CURVE_CIPHER,
+                                               &cipher, sizeof (cipher)));
+    test_context_socket_close (socket);
+}
+
+static void *connect_cipher_client (const char *endpoint_, int cipher_)
+{
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *client = test_context_socket (ZMQ_DEALER);
+    socket_config_curve_client (client, &curve_client_data);
+    set_cipher (client, cipher_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint_));
+    return client;
+}
+
+//  AES-256-GCM is used where both sides ask for it, and the CPU can run
+//  it, and either way the peers understand each other.
+void test_curve_cipher_negotiation ()
+{
+    void *aes_server = test_context_socket (ZMQ_DEALER);
+    socket_config_curve_server (aes_server, valid_server_secret);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (aes_server, ZMQ_ROUTING_ID, "IDENT", 5));
+    set_cipher (aes_server, ZMQ_CURVE_CIPHER_AES256GCM);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (aes_server, endpoint, sizeof endpoint);
+
+    void *client = connect_cipher_client (endpoint, ZMQ_CURVE_CIPHER_AES256GCM);
+    bounce (aes_server, client);
+
+    //  The cipher is not passed on as metadata
+    send_string_expect_success (aes_server, "cipher?", 0);
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, client, 0));
+    TEST_ASSERT_NULL (zmq_msg_gets (&msg, "Curve-Cipher"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+    test_context_socket_close (client);
+
+    client =
+      connect_cipher_client (endpoint, ZMQ_CURVE_CIPHER_XSALSA20POLY1305);
+    bounce (aes_server, client);
+    test_context_socket_close (client);
+    test_context_socket_close (aes_server);
+
+    //  A server that sticks to the default turns the offer down.
+    client = connect_cipher_client (my_endpoint, ZMQ_CURVE_CIPHER_AES256GCM);
+    bounce (server, client);
+    test_context_socket_close (client);
+}
+
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+void test_curve_cipher_with_session_resumption ()
+{
+    void *resuming_server = test_context_socket (ZMQ_DEALER);
+    socket_config_curve_server (resuming_server, valid_server_secret);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (resuming_server, ZMQ_ROUTING_ID, "IDENT", 5));
+    int lifetime = 60000;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (resuming_server,
+                                               ZMQ_CURVE_TICKET_LIFETIME,
+                                               &lifetime, sizeof (lifetime)));
+    set_cipher (resuming_server, ZMQ_CURVE_CIPHER_AES256GCM);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (resuming_server, endpoint, sizeof endpoint);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_socket_monitor (
+      resuming_server, "inproc://monitor-resuming",
+      ZMQ_EVENT_HANDSHAKE_SUCCEEDED | ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL));
+    void *resuming_server_mon = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_connect (resuming_server_mon, "inproc://monitor-resuming"));
+
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *client = test_context_socket (ZMQ_DEALER);
+    socket_config_curve_client (client, &curve_client_data);
+    lifetime = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      client, ZMQ_CURVE_TICKET_LIFETIME, &lifetime, sizeof (lifetime)));
+    set_cipher (client, ZMQ_CURVE_CIPHER_AES256GCM);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    bounce (resuming_server, client);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+
+    rebind (resuming_server, endpoint);
+    expect_handshake_event (resuming_server, resuming_server_mon,
+                            ZMQ_EVENT_HANDSHAKE_SUCCEEDED);
+    bounce (resuming_server, client);
+
+    test_context_socket_close (client);
+    zmq_socket_monitor (resuming_server, NULL, 0);
+    test_context_socket_close (resuming_server_mon);
+    test_context_socket_close (resuming_server);
+}
+#endif
+#endif
+
 // TODO why isn't this const?
 char null_key[] = "0000000000000000000000000000000000000000";
 
@@ -554,6 +975,39 @@ int main (void)
     RUN_TEST (test_curve_security_invalid_initiate_command_encrypted_cookie);
     RUN_TEST (test_curve_security_invalid_initiate_command_encrypted_content);
 
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+    RUN_TEST (test_curve_session_resumption);
+    RUN_TEST (test_curve_session_resumption_with_expired_ticket);
+    RUN_TEST (test_curve_session_resumption_replayed);
+#endif
+
+#ifdef ZMQ_CURVE_CIPHER
+    RUN_TEST (test_curve_cipher_option);
+    RUN_TEST (test_curve_cipher_negotiation);
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+    RUN_TEST (test_curve_cipher_with_session_resumption);
+#endif
+#endif
+
+#ifdef ZMQ_CRYPTO_THREADS
+    //  The same with the server's handshakes run on the crypto pool
+    crypto_threads = 2;
+    RUN_TEST (test_curve_security_with_valid_credentials);
+    RUN_TEST (test_null_server_key);
+    RUN_TEST (test_curve_security_with_bogus_client_credentials);
+    RUN_TEST (test_curve_security_unauthenticated_message);
+    RUN_TEST (test_curve_security_invalid_hello_version);
+    RUN_TEST (test_curve_security_invalid_initiate_command_encrypted_cookie);
+    RUN_TEST (test_curve_security_invalid_initiate_command_encrypted_content);
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+    RUN_TEST (test_curve_session_resumption);
+#endif
+#ifdef ZMQ_HAVE_LINUX
+    RUN_TEST (test_curve_crypto_pool_releases_signaler);
+#endif
+    crypto_threads = 0;
+#endif
+
     // TODO this requires a deviating test setup, must be moved to a separate executable/fixture
     //  test with a large routing id (resulting in large metadata)
     fprintf (stderr,
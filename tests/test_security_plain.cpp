@@ -6,6 +6,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+//  Requests the handler has replied to
+void *zap_requests;
+
 static void zap_handler (void *zap_)
 {
     //  Process ZAP requests forever
@@ -13,6 +16,7 @@ static void zap_handler (void *zap_)
         char *version = s_recv (zap_);
         if (!version)
             break; //  Terminating
+        zmq_atomic_counter_inc (zap_requests);
         char *sequence = s_recv (zap_);
         char *domain = s_recv (zap_);
         char *address = s_recv (zap_);
@@ -60,6 +64,7 @@ static void setup_zap_handler ()
     //  Spawn ZAP handler
     //  We create and bind ZAP socket in main thread to avoid case
     //  where child thread does not start up fast enough.
+    zap_requests = zmq_atomic_counter_new ();
     void *handler = zmq_socket (get_test_context (), ZMQ_REP);
     TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (handler, "inproc://zeromq.zap.01"));
     zap_thread = zmq_threadstart (&zap_handler, handler);
@@ -69,6 +74,7 @@ static void teardown_zap_handler ()
 {
     //  Wait until ZAP handler terminates
     zmq_threadclose (zap_thread);
+    zmq_atomic_counter_destroy (&zap_requests);
 }
 
 const char domain[] = "test";
@@ -171,6 +177,79 @@ void test_plain_vanilla_socket ()
     close (s);
 }
 
+#ifdef ZMQ_ZAP_CACHE_TTL
+static void *connect_plain_client (const char *endpoint_,
+                                   const char *username_,
+                                   const char *password_)
+{
+    void *client = test_context_socket (ZMQ_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (client, ZMQ_PLAIN_USERNAME,
+                                               username_, strlen (username_)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (client, ZMQ_PLAIN_PASSWORD,
+                                               password_, strlen (password_)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint_));
+    return client;
+}
+
+static void expect_user_id (void *server_, void *client_)
+{
+    send_string_expect_success (client_, "user?", 0);
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, server_, 0));
+    TEST_ASSERT_EQUAL_STRING ("anonymous", zmq_msg_gets (&msg, "User-Id"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+}
+
+void test_plain_zap_cache ()
+{
+    void *caching_server = test_context_socket (ZMQ_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (caching_server, ZMQ_ROUTING_ID, "IDENT", 6));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (caching_server, ZMQ_ZAP_DOMAIN,
+                                               domain, strlen (domain)));
+    const int as_server = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      caching_server, ZMQ_PLAIN_SERVER, &as_server, sizeof (int)));
+    int ttl = 60000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (caching_server, ZMQ_ZAP_CACHE_TTL, &ttl, sizeof (ttl)));
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (caching_server, endpoint, sizeof endpoint);
+
+    void *client = connect_plain_client (endpoint, "admin", "password");
+    bounce (caching_server, client);
+    expect_user_id (caching_server, client);
+    test_context_socket_close (client);
+    TEST_ASSERT_EQUAL_INT (1, zmq_atomic_counter_value (zap_requests));
+
+    //  The same credentials get the same reply, without the handler. The
+    //  server may not have dropped the previous client's pipe yet, so
+    //  only messages towards the server are checked from here on.
+    client = connect_plain_client (endpoint, "admin", "password");
+    expect_user_id (caching_server, client);
+    test_context_socket_close (client);
+    TEST_ASSERT_EQUAL_INT (1, zmq_atomic_counter_value (zap_requests));
+
+    //  Other credentials are another request. A refusal is kept as well,
+    //  so the handler sees the client's reconnects meanwhile only once.
+    client = connect_plain_client (endpoint, "admin", "wrongpass");
+    expect_bounce_fail (caching_server, client);
+    test_context_socket_close_zero_linger (client);
+    TEST_ASSERT_EQUAL_INT (2, zmq_atomic_counter_value (zap_requests));
+
+    //  Setting the TTL drops what has been cached.
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (caching_server, ZMQ_ZAP_CACHE_TTL, &ttl, sizeof (ttl)));
+    client = connect_plain_client (endpoint, "admin", "password");
+    expect_user_id (caching_server, client);
+    test_context_socket_close (client);
+    TEST_ASSERT_EQUAL_INT (3, zmq_atomic_counter_value (zap_requests));
+
+    test_context_socket_close (caching_server);
+}
+#endif
+
 int main (void)
 {
     setup_test_environment ();
@@ -180,5 +259,8 @@ int main (void)
     RUN_TEST (test_plain_client_as_server_fails);
     RUN_TEST (test_plain_wrong_credentials_fails);
     RUN_TEST (test_plain_vanilla_socket);
+#ifdef ZMQ_ZAP_CACHE_TTL
+    RUN_TEST (test_plain_zap_cache);
+#endif
     return UNITY_END ();
 }
@@ -3,6 +3,8 @@
 #include "testutil.hpp"
 #include "testutil_unity.hpp"
 
+#include <string.h>
+
 SETUP_TEARDOWN_TESTCONTEXT
 
 const int MAX_SENDS = 10000;
@@ -160,6 +162,108 @@ void test_decrease_when_full ()
 }
 
 
+#ifdef ZMQ_BUILD_DRAFT_API
+void test_bytes_limit ()
+{
+    void *bind_socket = test_context_socket (ZMQ_PUSH);
+    void *connect_socket = test_context_socket (ZMQ_PULL);
+
+    uint64_t val = 1000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (bind_socket, ZMQ_SNDHWM_BYTES, &val, sizeof (val)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (connect_socket, ZMQ_RCVHWM_BYTES, &val, sizeof (val)));
+
+    size_t placeholder = sizeof (val);
+    val = 0;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (bind_socket, ZMQ_SNDHWM_BYTES, &val, &placeholder));
+    TEST_ASSERT_EQUAL_UINT64 (1000, val);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (bind_socket, "inproc://a"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (connect_socket, "inproc://a"));
+
+    //  The message limits are far away, the byte limits of both sides add
+    //  up to 2000 bytes, i.e. 20 messages of 100 bytes.
+    char buf[100];
+    memset (buf, 0, sizeof (buf));
+    int send_count = 0;
+    while (send_count < MAX_SENDS
+           && zmq_send (bind_socket, buf, sizeof (buf), ZMQ_DONTWAIT)
+                == (int) sizeof (buf))
+        ++send_count;
+    TEST_ASSERT_EQUAL_INT (20, send_count);
+
+    //  Draining the queue lets the writer continue.
+    for (int i = 0; i < send_count; ++i)
+        TEST_ASSERT_EQUAL_INT (
+          (int) sizeof (buf),
+          TEST_ASSERT_SUCCESS_ERRNO (zmq_recv (connect_socket, buf,
+                                               sizeof (buf), ZMQ_DONTWAIT)));
+    msleep (SETTLE_TIME);
+    TEST_ASSERT_EQUAL_INT (
+      (int) sizeof (buf),
+      TEST_ASSERT_SUCCESS_ERRNO (
+        zmq_send (bind_socket, buf, sizeof (buf), ZMQ_DONTWAIT)));
+
+    test_context_socket_close (bind_socket);
+    test_context_socket_close (connect_socket);
+}
+
+//  The frames of a message that were still being written when the
+//  connection dropped go with the old pipe, and no longer count towards
+//  the byte limit.
+void test_bytes_limit_reconnect_mid_message ()
+{
+    void *pub = test_context_socket (ZMQ_XPUB);
+    void *sub = test_context_socket (ZMQ_XSUB);
+
+    uint64_t val = 1000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_SNDHWM_BYTES, &val, sizeof (val)));
+    int timeout = 1000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_SNDTIMEO, &timeout, sizeof (timeout)));
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_RCVTIMEO, &timeout, sizeof (timeout)));
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (pub, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, endpoint));
+    send_string_expect_success (sub, "hello", 0);
+    recv_string_expect_success (pub, "hello", 0);
+
+    char buf[1000];
+    memset (buf, 'x', sizeof (buf));
+    TEST_ASSERT_EQUAL_INT (
+      (int) sizeof (buf), TEST_ASSERT_SUCCESS_ERRNO (
+                            zmq_send (sub, buf, sizeof (buf), ZMQ_SNDMORE)));
+
+    test_context_socket_close (pub);
+    msleep (SETTLE_TIME);
+    pub = test_context_socket (ZMQ_XPUB);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_RCVTIMEO, &timeout, sizeof (timeout)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, endpoint));
+
+    send_string_expect_success (sub, "end", 0);
+    recv_string_expect_success (pub, "end", 0);
+
+    //  Without the dropped frame counted, 900 more bytes fit in before the
+    //  peer's first credit. An XSUB drops what doesn't fit.
+    for (int i = 0; i < 9; ++i) {
+        TEST_ASSERT_EQUAL_INT (
+          100, TEST_ASSERT_SUCCESS_ERRNO (zmq_send (sub, buf, 100, 0)));
+        TEST_ASSERT_EQUAL_INT (
+          100, TEST_ASSERT_SUCCESS_ERRNO (zmq_recv (pub, buf, 100, 0)));
+    }
+
+    test_context_socket_close (sub);
+    test_context_socket_close (pub);
+}
+#endif
+
 int main ()
 {
     setup_test_environment ();
@@ -168,6 +272,10 @@ int main ()
     RUN_TEST (test_change_before_connected);
     RUN_TEST (test_change_after_connected);
     RUN_TEST (test_decrease_when_full);
+#ifdef ZMQ_BUILD_DRAFT_API
+    RUN_TEST (test_bytes_limit);
+    RUN_TEST (test_bytes_limit_reconnect_mid_message);
+#endif
 
     return UNITY_END ();
 }
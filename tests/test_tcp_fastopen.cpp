@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_monitoring.hpp"
+#include "testutil_unity.hpp"
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static void set_fastopen (void *socket_)
+{
+    int value = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_TCP_FASTOPEN, &value, sizeof value));
+}
+
+void test_option ()
+{
+    void *socket = test_context_socket (ZMQ_DEALER);
+
+    int value = -1;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_TCP_FASTOPEN, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+
+    value = 2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (socket, ZMQ_TCP_FASTOPEN, &value, sizeof value));
+
+    set_fastopen (socket);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_TCP_FASTOPEN, &value, &size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+
+    test_context_socket_close (socket);
+}
+
+static void test_roundtrip (bool listener_, bool connecter_)
+{
+    void *server = test_context_socket (ZMQ_DEALER);
+    void *client = test_context_socket (ZMQ_DEALER);
+    if (listener_)
+        set_fastopen (server);
+    if (connecter_)
+        set_fastopen (client);
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (server, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    bounce (server, client);
+
+    test_context_socket_close (client);
+    test_context_socket_close (server);
+}
+
+void test_roundtrip_both ()
+{
+    test_roundtrip (true, true);
+}
+
+void test_roundtrip_listener_only ()
+{
+    test_roundtrip (true, false);
+}
+
+void test_roundtrip_connecter_only ()
+{
+    test_roundtrip (false, true);
+}
+
+//  The first connection fetches a Fast Open cookie, where the system allows
+//  Fast Open at all, and the reconnection sends the greeting on the SYN.
+void test_reconnect ()
+{
+    void *server = test_context_socket (ZMQ_DEALER);
+    void *client = test_context_socket (ZMQ_DEALER);
+    set_fastopen (server);
+    set_fastopen (client);
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (server, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    bounce (server, client);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_unbind (server, endpoint));
+    expect_bounce_fail (server, client);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (server, endpoint));
+
+    bounce (server, client);
+
+    test_context_socket_close (client);
+    test_context_socket_close (server);
+}
+
+//  Connecting before anyone listens fails the usual way, and is retried.
+void test_connect_before_bind ()
+{
+    void *server = test_context_socket (ZMQ_DEALER);
+    void *client = test_context_socket (ZMQ_DEALER);
+    set_fastopen (server);
+    set_fastopen (client);
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (server, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_unbind (server, endpoint));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+    msleep (SETTLE_TIME);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (server, endpoint));
+
+    bounce (server, client);
+
+    test_context_socket_close (client);
+    test_context_socket_close (server);
+}
+
+static void *monitored_client (void **monitor_)
+{
+    void *client = test_context_socket (ZMQ_DEALER);
+    set_fastopen (client);
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_socket_monitor (client, "inproc://monitor-client", ZMQ_EVENT_ALL));
+    *monitor_ = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_connect (*monitor_, "inproc://monitor-client"));
+    return client;
+}
+
+static void closed_port_endpoint (char *endpoint_, size_t len_)
+{
+    void *server = test_context_socket (ZMQ_DEALER);
+    bind_loopback_ipv4 (server, endpoint_, len_);
+    test_context_socket_close (server);
+}
+
+//  Connecting to a port nobody listens on is refused, and never reported as
+//  connected.
+void test_connect_refused_events ()
+{
+    char endpoint[MAX_SOCKET_STRING];
+    closed_port_endpoint (endpoint, sizeof endpoint);
+
+    void *monitor;
+    void *client = monitored_client (&monitor);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    expect_monitor_event (monitor, ZMQ_EVENT_CONNECT_DELAYED);
+    expect_monitor_event (monitor, ZMQ_EVENT_CLOSED);
+    expect_monitor_event (monitor, ZMQ_EVENT_CONNECT_RETRIED);
+    expect_monitor_event (monitor, ZMQ_EVENT_CONNECT_DELAYED);
+    expect_monitor_event (monitor, ZMQ_EVENT_CLOSED);
+
+    test_context_socket_close_zero_linger (client);
+    test_context_socket_close_zero_linger (monitor);
+}
+
+void test_reconnect_stop_conn_refused ()
+{
+    char endpoint[MAX_SOCKET_STRING];
+    closed_port_endpoint (endpoint, sizeof endpoint);
+
+    void *monitor;
+    void *client = monitored_client (&monitor);
+    int value = ZMQ_RECONNECT_STOP_CONN_REFUSED;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (client, ZMQ_RECONNECT_STOP, &value, sizeof value));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    expect_monitor_event (monitor, ZMQ_EVENT_CONNECT_DELAYED);
+    expect_monitor_event (monitor, ZMQ_EVENT_CLOSED);
+
+    //  No further attempts are made.
+    int event;
+    TEST_ASSERT_EQUAL_INT (
+      -1, get_monitor_event_with_timeout (monitor, &event, NULL, 500));
+
+    test_context_socket_close_zero_linger (client);
+    test_context_socket_close_zero_linger (monitor);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_roundtrip_both);
+    RUN_TEST (test_roundtrip_listener_only);
+    RUN_TEST (test_roundtrip_connecter_only);
+    RUN_TEST (test_reconnect);
+    RUN_TEST (test_connect_before_bind);
+    RUN_TEST (test_connect_refused_events);
+    RUN_TEST (test_reconnect_stop_conn_refused);
+    return UNITY_END ();
+}
@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: MPL-2.0 */
 
 #include <string.h>
+#include <stdlib.h>
+#include <string>
 #include "testutil.hpp"
 #include "testutil_unity.hpp"
 
@@ -272,6 +274,266 @@ void test_pub_sub ()
     test_context_socket_close (sb);
 }
 
+//  Sends messages of several sizes both ways between a pair of dealers,
+//  each after a short frame of the same multipart message.
+static void exchange_messages (void *sb_, void *sc_)
+{
+    const size_t sizes[] = {0, 1, 63, 64, 1000, 100000};
+    for (int round = 0; round < 3; round++)
+        for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+            const size_t size = sizes[i];
+            //  Text-like data that compresses well, but differs between
+            //  rounds so that earlier messages don't predict it fully.
+            char *data = static_cast<char *> (malloc (size + 1));
+            for (size_t j = 0; j < size; j++)
+                data[j] = "{\"key\": \"value\"}, "[(j + round) % 20];
+
+            for (int direction = 0; direction < 2; direction++) {
+                void *from = direction ? sb_ : sc_;
+                void *to = direction ? sc_ : sb_;
+                send_string_expect_success (from, "header", ZMQ_SNDMORE);
+                TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                                       zmq_send (from, data, size, 0));
+
+                recv_string_expect_success (to, "header", 0);
+                zmq_msg_t msg;
+                TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+                TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                                       zmq_msg_recv (&msg, to, 0));
+                TEST_ASSERT_FALSE (zmq_msg_more (&msg));
+                if (size)
+                    TEST_ASSERT_EQUAL_MEMORY (data, zmq_msg_data (&msg), size);
+                TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+            }
+            free (data);
+        }
+}
+
+static void set_ws_fragment_size (void *socket_, int fragment_size_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      socket_, ZMQ_WS_FRAGMENT_SIZE, &fragment_size_, sizeof (int)));
+}
+
+void test_fragments ()
+{
+    char connect_address[MAX_SOCKET_STRING];
+    size_t addr_length = sizeof (connect_address);
+    void *sb = test_context_socket (ZMQ_DEALER);
+    set_ws_fragment_size (sb, 1000);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (sb, "ws://127.0.0.1:*/fragments"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, connect_address, &addr_length));
+
+    void *sc = test_context_socket (ZMQ_DEALER);
+    set_ws_fragment_size (sc, 64);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sc, connect_address));
+
+    exchange_messages (sb, sc);
+
+    int value = 0;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sc, ZMQ_WS_FRAGMENT_SIZE, &value, &size));
+    TEST_ASSERT_EQUAL_INT (64, value);
+    value = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL,
+      zmq_setsockopt (sc, ZMQ_WS_FRAGMENT_SIZE, &value, sizeof value));
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
+#ifdef ZMQ_HAVE_WS_DEFLATE
+static void set_ws_deflate (void *socket_, int threshold_, int no_takeover_)
+{
+    const int enabled = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_WS_DEFLATE, &enabled, sizeof (int)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      socket_, ZMQ_WS_DEFLATE_THRESHOLD, &threshold_, sizeof (int)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_WS_DEFLATE_NO_CONTEXT_TAKEOVER,
+                      &no_takeover_, sizeof (int)));
+}
+
+//  Exchanges messages between a pair of dealers, of which those given a
+//  threshold compress.
+static void test_deflate_roundtrip (int server_threshold_,
+                                    int client_threshold_,
+                                    int no_takeover_,
+                                    int fragment_size_ = 0)
+{
+    char connect_address[MAX_SOCKET_STRING];
+    size_t addr_length = sizeof (connect_address);
+    void *sb = test_context_socket (ZMQ_DEALER);
+    if (server_threshold_ >= 0)
+        set_ws_deflate (sb, server_threshold_, no_takeover_);
+    set_ws_fragment_size (sb, fragment_size_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (sb, "ws://127.0.0.1:*/deflate"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, connect_address, &addr_length));
+
+    void *sc = test_context_socket (ZMQ_DEALER);
+    if (client_threshold_ >= 0)
+        set_ws_deflate (sc, client_threshold_, no_takeover_);
+    set_ws_fragment_size (sc, fragment_size_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sc, connect_address));
+
+    exchange_messages (sb, sc);
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
+void test_deflate ()
+{
+    test_deflate_roundtrip (64, 64, 0);
+}
+
+void test_deflate_everything ()
+{
+    test_deflate_roundtrip (0, 0, 0);
+}
+
+void test_deflate_no_context_takeover ()
+{
+    test_deflate_roundtrip (0, 64, 1);
+}
+
+void test_deflate_fragments ()
+{
+    test_deflate_roundtrip (0, 0, 0, 100);
+}
+
+void test_deflate_server_only ()
+{
+    test_deflate_roundtrip (0, -1, 0);
+}
+
+void test_deflate_client_only ()
+{
+    test_deflate_roundtrip (-1, 0, 0);
+}
+
+void test_deflate_options ()
+{
+    void *socket = test_context_socket (ZMQ_DEALER);
+    int value = -1;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_WS_DEFLATE, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_WS_DEFLATE_THRESHOLD, &value, &size));
+    TEST_ASSERT_EQUAL_INT (64, value);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_getsockopt (
+      socket, ZMQ_WS_DEFLATE_NO_CONTEXT_TAKEOVER, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+
+    set_ws_deflate (socket, 128, 1);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_WS_DEFLATE, &value, &size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_WS_DEFLATE_THRESHOLD, &value, &size));
+    TEST_ASSERT_EQUAL_INT (128, value);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_getsockopt (
+      socket, ZMQ_WS_DEFLATE_NO_CONTEXT_TAKEOVER, &value, &size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+
+    value = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (socket, ZMQ_WS_DEFLATE_THRESHOLD, &value,
+                              sizeof value));
+    value = 2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL,
+      zmq_setsockopt (socket, ZMQ_WS_DEFLATE, &value, sizeof value));
+
+    test_context_socket_close (socket);
+}
+
+static void recv_all (fd_t fd_, unsigned char *buf_, size_t size_)
+{
+    for (size_t received = 0; received < size_;) {
+        const int rc = static_cast<int> (
+          recv (fd_, reinterpret_cast<char *> (buf_) + received,
+                static_cast<int> (size_ - received), 0));
+        TEST_ASSERT_GREATER_THAN_INT (0, rc);
+        received += rc;
+    }
+}
+
+//  A client that offers the extension gets it agreed on in the response
+//  and compressed frames from then on.
+void test_deflate_handshake ()
+{
+    char my_endpoint[MAX_SOCKET_STRING];
+    size_t my_endpoint_size = sizeof (my_endpoint);
+    void *server = test_context_socket (ZMQ_DEALER);
+    set_ws_deflate (server, 64, 0);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (server, "ws://127.0.0.1:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_getsockopt (server, ZMQ_LAST_ENDPOINT,
+                                               my_endpoint, &my_endpoint_size));
+    //  Remove trailing /
+    my_endpoint[my_endpoint_size - 2] = '\0';
+    const fd_t client = connect_socket (my_endpoint, AF_INET, IPPROTO_WS);
+
+    const char request[] =
+      "GET / HTTP/1.1\r\n"
+      "Host: 127.0.0.1\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+      "Sec-WebSocket-Protocol: ZWS2.0\r\n"
+      "Sec-WebSocket-Extensions: x-unknown, permessage-deflate; "
+      "server_max_window_bits=8, permessage-deflate; "
+      "server_max_window_bits=10; client_max_window_bits\r\n"
+      "Sec-WebSocket-Version: 13\r\n\r\n";
+    TEST_ASSERT_EQUAL_INT (
+      static_cast<int> (sizeof request - 1),
+      send (client, request, static_cast<int> (sizeof request - 1), 0));
+
+    std::string response;
+    while (response.find ("\r\n\r\n") == std::string::npos) {
+        unsigned char c;
+        recv_all (client, &c, 1);
+        response += static_cast<char> (c);
+    }
+    TEST_ASSERT_TRUE (
+      response.find ("Sec-WebSocket-Extensions: permessage-deflate; "
+                     "server_max_window_bits=10\r\n")
+      != std::string::npos);
+
+    //  Our routing id, an empty masked binary frame.
+    const unsigned char routing_id[] = {0x82, 0x81, 0, 0, 0, 0, 0};
+    TEST_ASSERT_EQUAL_INT (
+      static_cast<int> (sizeof routing_id),
+      send (client, reinterpret_cast<const char *> (routing_id),
+            static_cast<int> (sizeof routing_id), 0));
+
+    //  The server's routing id is below the threshold.
+    unsigned char frame[2];
+    recv_all (client, frame, 2);
+    TEST_ASSERT_EQUAL_UINT8 (0x82, frame[0]);
+    TEST_ASSERT_EQUAL_UINT8 (1, frame[1]);
+    recv_all (client, frame, 1);
+
+    //  A thousand repeated bytes compress to a short frame with RSV1 set.
+    char data[1000];
+    memset (data, 'x', sizeof data);
+    TEST_ASSERT_EQUAL_INT (1000, zmq_send (server, data, sizeof data, 0));
+    recv_all (client, frame, 2);
+    TEST_ASSERT_EQUAL_UINT8 (0xC2, frame[0]);
+    TEST_ASSERT_LESS_THAN_UINT8 (126, frame[1]);
+
+    close (client);
+    test_context_socket_close_zero_linger (server);
+}
+#endif
+
 
 int main ()
 {
@@ -285,9 +547,21 @@ int main ()
     RUN_TEST (test_heartbeat);
     RUN_TEST (test_mask_shared_msg);
     RUN_TEST (test_pub_sub);
+    RUN_TEST (test_fragments);
 
     if (zmq_has ("curve"))
         RUN_TEST (test_curve);
 
+#ifdef ZMQ_HAVE_WS_DEFLATE
+    RUN_TEST (test_deflate);
+    RUN_TEST (test_deflate_everything);
+    RUN_TEST (test_deflate_no_context_takeover);
+    RUN_TEST (test_deflate_fragments);
+    RUN_TEST (test_deflate_server_only);
+    RUN_TEST (test_deflate_client_only);
+    RUN_TEST (test_deflate_options);
+    RUN_TEST (test_deflate_handshake);
+#endif
+
     return UNITY_END ();
 }
@@ -3,6 +3,15 @@
 #include "testutil.hpp"
 #include "testutil_unity.hpp"
 
+#if defined ZMQ_BUILD_DRAFT_API && !defined ZMQ_HAVE_WINDOWS
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 SETUP_TEARDOWN_TESTCONTEXT
 
 void test ()
@@ -90,10 +99,188 @@ void test ()
     test_context_socket_close (sub);
 }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+void test_spill ()
+{
+    void *pub = test_context_socket (ZMQ_XPUB);
+
+    int hwm = 10;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, 4));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (pub, ZMQ_XPUB_SPILL_DIR, ".", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://spill"));
+
+    void *sub = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, 4));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://spill"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    recv_string_expect_success (pub, "\1", 0);
+
+    //  Far more than the HWMs allow, the overflow goes to the spill file
+    //  rather than being dropped.
+    const int msg_count = 1000;
+    for (int i = 0; i < msg_count; i++) {
+        TEST_ASSERT_EQUAL_INT (
+          (int) sizeof (i),
+          TEST_ASSERT_SUCCESS_ERRNO (zmq_send (pub, &i, sizeof (i), ZMQ_SNDMORE)));
+        send_string_expect_success (pub, "part", 0);
+    }
+
+    //  Everything arrives, in order and with the parts intact. Spilled
+    //  messages are replayed as the publisher processes its commands.
+    for (int i = 0; i < msg_count; i++) {
+        int value = -1;
+        while (zmq_recv (sub, &value, sizeof (value), ZMQ_DONTWAIT) == -1) {
+            TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+            int events;
+            size_t events_size = sizeof (events);
+            TEST_ASSERT_SUCCESS_ERRNO (
+              zmq_getsockopt (pub, ZMQ_EVENTS, &events, &events_size));
+            msleep (1);
+        }
+        TEST_ASSERT_EQUAL_INT (i, value);
+        recv_string_expect_success (sub, "part", 0);
+    }
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+#ifndef ZMQ_HAVE_WINDOWS
+//  A message whose frames don't all make it to disk is dropped whole, and
+//  no later frame of it is replayed as a message of its own.
+void test_spill_write_error ()
+{
+    void *pub = test_context_socket (ZMQ_XPUB);
+
+    int hwm = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, 4));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (pub, ZMQ_XPUB_SPILL_DIR, ".", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://spill-error"));
+
+    void *sub = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, 4));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://spill-error"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    recv_string_expect_success (pub, "\1", 0);
+
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT (
+          (int) sizeof (i),
+          TEST_ASSERT_SUCCESS_ERRNO (zmq_send (pub, &i, sizeof (i), ZMQ_SNDMORE)));
+        send_string_expect_success (pub, "part", 0);
+    }
+
+    //  Files may not grow past 4 kB while the first two frames are sent,
+    //  so they fail to go to disk, while the third would go to a new file.
+    struct rlimit limit;
+    TEST_ASSERT_SUCCESS_ERRNO (getrlimit (RLIMIT_FSIZE, &limit));
+    const rlim_t fsize = limit.rlim_cur;
+    void (*const sigxfsz) (int) = signal (SIGXFSZ, SIG_IGN);
+    limit.rlim_cur = 4096;
+    TEST_ASSERT_SUCCESS_ERRNO (setrlimit (RLIMIT_FSIZE, &limit));
+
+    const size_t frame_size = 100000;
+    char *const frame = static_cast<char *> (malloc (frame_size));
+    memset (frame, 'x', frame_size);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_send (pub, frame, frame_size, ZMQ_SNDMORE));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_send (pub, frame, frame_size, ZMQ_SNDMORE));
+
+    limit.rlim_cur = fsize;
+    TEST_ASSERT_SUCCESS_ERRNO (setrlimit (RLIMIT_FSIZE, &limit));
+    signal (SIGXFSZ, sigxfsz);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_send (pub, frame, frame_size, 0));
+
+    const int last = 10;
+    TEST_ASSERT_EQUAL_INT (
+      (int) sizeof (last),
+      TEST_ASSERT_SUCCESS_ERRNO (zmq_send (pub, &last, sizeof (last), ZMQ_SNDMORE)));
+    send_string_expect_success (pub, "part", 0);
+
+    //  What was in the pipe arrives, then the last message, all whole.
+    int value = -1;
+    while (value != last) {
+        int rc;
+        while ((rc = zmq_recv (sub, frame, frame_size, ZMQ_DONTWAIT)) == -1) {
+            TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+            int events;
+            size_t events_size = sizeof (events);
+            TEST_ASSERT_SUCCESS_ERRNO (
+              zmq_getsockopt (pub, ZMQ_EVENTS, &events, &events_size));
+            msleep (1);
+        }
+        TEST_ASSERT_EQUAL_INT ((int) sizeof (value), rc);
+        memcpy (&value, frame, sizeof (value));
+        recv_string_expect_success (sub, "part", 0);
+    }
+    free (frame);
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+#ifdef ZMQ_HAVE_LINUX
+//  Others may not read what is spilled, whatever the umask.
+void test_spill_file_mode ()
+{
+    const mode_t mask = umask (0);
+
+    void *pub = test_context_socket (ZMQ_XPUB);
+    int hwm = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, 4));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (pub, ZMQ_XPUB_SPILL_DIR, ".", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://spill-mode"));
+
+    void *sub = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, 4));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://spill-mode"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    recv_string_expect_success (pub, "\1", 0);
+
+    for (int i = 0; i < 10; i++)
+        send_string_expect_success (pub, "spilled", 0);
+    umask (mask);
+
+    //  The file is removed as soon as it is open, so find it among the
+    //  open files.
+    int found = 0;
+    for (int fd = 0; fd < 1024; fd++) {
+        char link[64];
+        char target[256];
+        snprintf (link, sizeof link, "/proc/self/fd/%d", fd);
+        const ssize_t size = readlink (link, target, sizeof target - 1);
+        if (size <= 0)
+            continue;
+        target[size] = 0;
+        if (!strstr (target, "zmq-spill-"))
+            continue;
+        struct stat st;
+        TEST_ASSERT_SUCCESS_ERRNO (stat (link, &st));
+        TEST_ASSERT_EQUAL_INT (0600, st.st_mode & 0777);
+        found++;
+    }
+    TEST_ASSERT_GREATER_THAN_INT (0, found);
+
+    test_context_socket_close_zero_linger (pub);
+    test_context_socket_close (sub);
+}
+#endif
+#endif
+#endif
+
 int main ()
 {
     setup_test_environment ();
     UNITY_BEGIN ();
     RUN_TEST (test);
+#ifdef ZMQ_BUILD_DRAFT_API
+    RUN_TEST (test_spill);
+#ifndef ZMQ_HAVE_WINDOWS
+    RUN_TEST (test_spill_write_error);
+#endif
+#ifdef ZMQ_HAVE_LINUX
+    RUN_TEST (test_spill_file_mode);
+#endif
+#endif
     return UNITY_END ();
 }
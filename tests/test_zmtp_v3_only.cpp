@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <string.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static void recv_with_retry (fd_t fd_, char *buffer_, int bytes_)
+{
+    int received = 0;
+    while (received < bytes_) {
+        const int rc = TEST_ASSERT_SUCCESS_RAW_ERRNO (
+          recv (fd_, buffer_ + received, bytes_ - received, 0));
+        TEST_ASSERT_GREATER_THAN_INT (0, rc);
+        received += rc;
+    }
+}
+
+static void set_v3_only (void *socket_)
+{
+    int value = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_ZMTP_V3_ONLY, &value, sizeof value));
+}
+
+void test_option ()
+{
+    void *socket = test_context_socket (ZMQ_DEALER);
+
+    int value = -1;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_ZMTP_V3_ONLY, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+
+    value = 2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (socket, ZMQ_ZMTP_V3_ONLY, &value, sizeof value));
+
+    set_v3_only (socket);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_ZMTP_V3_ONLY, &value, &size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+
+    test_context_socket_close (socket);
+}
+
+//  The whole greeting and the first command arrive without the peer
+//  saying anything.
+static void test_first_flight (int mechanism_,
+                               const uint8_t *command_,
+                               size_t command_size_)
+{
+    char endpoint[MAX_SOCKET_STRING];
+    const fd_t listener = bind_socket_resolve_port ("127.0.0.1", "0", endpoint);
+
+    void *dealer = test_context_socket (ZMQ_DEALER);
+    set_v3_only (dealer);
+    if (mechanism_ == ZMQ_PLAIN) {
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (dealer, ZMQ_PLAIN_USERNAME, "admin", 5));
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (dealer, ZMQ_PLAIN_PASSWORD, "password", 8));
+    }
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (dealer, endpoint));
+
+    const fd_t peer =
+      TEST_ASSERT_SUCCESS_RAW_ERRNO (accept (listener, NULL, NULL));
+
+    char buffer[128];
+    recv_with_retry (peer, buffer, 64 + static_cast<int> (command_size_));
+    TEST_ASSERT_EQUAL_UINT8 (0xff, buffer[0]);
+    TEST_ASSERT_EQUAL_UINT8 (0x7f, buffer[9]);
+    TEST_ASSERT_EQUAL_INT (3, buffer[10]);
+    TEST_ASSERT_EQUAL_INT (1, buffer[11]);
+    TEST_ASSERT_EQUAL_STRING (mechanism_ == ZMQ_PLAIN ? "PLAIN" : "NULL",
+                              buffer + 12);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (command_, buffer + 64, command_size_);
+
+    close (peer);
+    close (listener);
+    test_context_socket_close_zero_linger (dealer);
+}
+
+void test_first_flight_null ()
+{
+    test_first_flight (ZMQ_NULL, zmtp_ready_dealer, sizeof zmtp_ready_dealer);
+}
+
+void test_first_flight_plain ()
+{
+    const uint8_t hello[] = {4,   21,  5,   'H', 'E', 'L', 'L', 'O',
+                             5,   'a', 'd', 'm', 'i', 'n', 8,   'p',
+                             'a', 's', 's', 'w', 'o', 'r', 'd'};
+    test_first_flight (ZMQ_PLAIN, hello, sizeof hello);
+}
+
+//  A peer that speaks ZMTP/2.0 is disconnected.
+void test_v2_peer ()
+{
+    void *router = test_context_socket (ZMQ_ROUTER);
+    set_v3_only (router);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (router, endpoint, sizeof endpoint);
+
+    const fd_t peer = connect_socket (endpoint);
+    const char greeting[12] = {'\xff', 0, 0, 0, 0, 0, 0, 0, 1, 0x7f, 1,
+                               ZMQ_DEALER};
+    TEST_ASSERT_EQUAL_INT (sizeof greeting,
+                           TEST_ASSERT_SUCCESS_RAW_ERRNO (
+                             send (peer, greeting, sizeof greeting, 0)));
+
+    //  The connection is closed, whether the router's greeting has made it
+    //  out or not.
+    char buffer[64];
+    int rc;
+    do
+        rc = TEST_ASSERT_SUCCESS_RAW_ERRNO (
+          recv (peer, buffer, sizeof buffer, 0));
+    while (rc > 0);
+
+    close (peer);
+    test_context_socket_close (router);
+}
+
+static void test_roundtrip (bool server_v3_only_)
+{
+    void *server = test_context_socket (ZMQ_DEALER);
+    void *client = test_context_socket (ZMQ_DEALER);
+    set_v3_only (client);
+    if (server_v3_only_)
+        set_v3_only (server);
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (server, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    bounce (server, client);
+
+    test_context_socket_close (client);
+    test_context_socket_close (server);
+}
+
+void test_roundtrip_v3_only ()
+{
+    test_roundtrip (true);
+}
+
+void test_roundtrip_default_server ()
+{
+    test_roundtrip (false);
+}
+
+//  The first command sent along doesn't save a mechanism mismatch.
+void test_mechanism_mismatch ()
+{
+    void *server = test_context_socket (ZMQ_DEALER);
+    void *client = test_context_socket (ZMQ_DEALER);
+    set_v3_only (client);
+    set_v3_only (server);
+    int as_server = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (server, ZMQ_PLAIN_SERVER,
+                                               &as_server, sizeof as_server));
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (server, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+
+    expect_bounce_fail (server, client);
+
+    test_context_socket_close_zero_linger (client);
+    test_context_socket_close_zero_linger (server);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_first_flight_null);
+    RUN_TEST (test_first_flight_plain);
+    RUN_TEST (test_v2_peer);
+    RUN_TEST (test_roundtrip_v3_only);
+    RUN_TEST (test_roundtrip_default_server);
+    RUN_TEST (test_mechanism_mismatch);
+    return UNITY_END ();
+}
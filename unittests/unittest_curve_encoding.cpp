@@ -23,7 +23,7 @@ void tearDown ()
 {
 }
 
-void test_roundtrip (zmq::msg_t *msg_)
+void test_roundtrip (zmq::msg_t *msg_, bool aes256gcm_ = false)
 {
 #ifdef ZMQ_HAVE_CURVE
     const std::vector<uint8_t> original (static_cast<uint8_t *> (msg_->data ()),
@@ -51,6 +51,10 @@ void test_roundtrip (zmq::msg_t *msg_)
     TEST_ASSERT_SUCCESS_ERRNO (
       crypto_box_beforenm (encoding_server.get_writable_precom_buffer (),
                            client_public, server_secret));
+    if (aes256gcm_) {
+        encoding_client.use_aes256gcm ();
+        encoding_server.use_aes256gcm ();
+    }
 
     TEST_ASSERT_SUCCESS_ERRNO (encoding_client.encode (msg_));
 
@@ -67,6 +71,7 @@ void test_roundtrip (zmq::msg_t *msg_)
     }
 #else
     LIBZMQ_UNUSED (msg_);
+    LIBZMQ_UNUSED (aes256gcm_);
 #endif
 }
 
@@ -129,6 +134,94 @@ void test_roundtrip_empty_more ()
     msg.close ();
 }
 
+//  Encryption happens in the new message, the data sent stays as it is.
+void test_roundtrip_constant ()
+{
+#ifndef ZMQ_HAVE_CURVE
+    TEST_IGNORE_MESSAGE ("CURVE support is disabled");
+#endif
+    static const char data[] = "0123456789ABCDEF0123456789ABCDEF0123456789";
+    zmq::msg_t msg;
+    msg.init_data (const_cast<char *> (data), sizeof data - 1, NULL, NULL);
+
+    test_roundtrip (&msg);
+    TEST_ASSERT_EQUAL_STRING ("0123456789ABCDEF0123456789ABCDEF0123456789",
+                              data);
+
+    msg.close ();
+}
+
+void test_roundtrip_aes256gcm ()
+{
+#ifdef ZMQ_HAVE_CURVE
+    if (!zmq::curve_encoding_t::aes256gcm_available ())
+        TEST_IGNORE_MESSAGE ("AES-256-GCM is not available");
+
+    zmq::msg_t msg;
+    msg.init_size (2048);
+    for (size_t pos = 0; pos < 2048; pos += 32) {
+        memcpy (static_cast<char *> (msg.data ()) + pos,
+                "0123456789ABCDEF0123456789ABCDEF", 32);
+    }
+
+    test_roundtrip (&msg, true);
+
+    msg.close ();
+
+    msg.init ();
+    msg.set_flags (zmq::msg_t::more);
+
+    test_roundtrip (&msg, true);
+    TEST_ASSERT_TRUE (msg.flags () & zmq::msg_t::more);
+
+    msg.close ();
+#else
+    TEST_IGNORE_MESSAGE ("CURVE support is disabled");
+#endif
+}
+
+void test_tampered ()
+{
+#ifdef ZMQ_HAVE_CURVE
+    zmq::curve_encoding_t encoding_client ("CurveZMQMESSAGEC",
+                                           "CurveZMQMESSAGES", false);
+    zmq::curve_encoding_t encoding_server ("CurveZMQMESSAGES",
+                                           "CurveZMQMESSAGEC", false);
+
+    uint8_t client_public[32];
+    uint8_t client_secret[32];
+    TEST_ASSERT_SUCCESS_ERRNO (
+      crypto_box_keypair (client_public, client_secret));
+    uint8_t server_public[32];
+    uint8_t server_secret[32];
+    TEST_ASSERT_SUCCESS_ERRNO (
+      crypto_box_keypair (server_public, server_secret));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      crypto_box_beforenm (encoding_client.get_writable_precom_buffer (),
+                           server_public, client_secret));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      crypto_box_beforenm (encoding_server.get_writable_precom_buffer (),
+                           client_public, server_secret));
+
+    zmq::msg_t msg;
+    msg.init_size (100);
+    memset (msg.data (), 'x', 100);
+    TEST_ASSERT_SUCCESS_ERRNO (encoding_client.encode (&msg));
+    static_cast<uint8_t *> (msg.data ())[msg.size () - 1] ^= 1;
+
+    encoding_server.set_peer_nonce (0);
+    int error_event_code = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EPROTO, encoding_server.decode (&msg, &error_event_code));
+    TEST_ASSERT_EQUAL_INT (ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC,
+                           error_event_code);
+
+    msg.close ();
+#else
+    TEST_IGNORE_MESSAGE ("CURVE support is disabled");
+#endif
+}
+
 int main ()
 {
     setup_test_environment ();
@@ -141,6 +234,9 @@ int main ()
     RUN_TEST (test_roundtrip_large);
 
     RUN_TEST (test_roundtrip_empty_more);
+    RUN_TEST (test_roundtrip_constant);
+    RUN_TEST (test_roundtrip_aes256gcm);
+    RUN_TEST (test_tampered);
 
     zmq::random_close ();
 
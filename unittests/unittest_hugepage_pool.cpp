@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include <hugepage_pool.hpp>
+
+#include <string.h>
+#include <unity.h>
+#include <vector>
+
+#ifdef ZMQ_HAVE_LINUX
+#include <sys/mman.h>
+#endif
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_allocate_sizes ()
+{
+    //  Covers the smallest classes, quarter steps, the largest class and
+    //  blocks with a mapping of their own.
+    const size_t sizes[] = {0,    1,     64,     65,         300,
+                            8192, 16400, 524288, 524289, 5 * 1024 * 1024};
+    for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+        unsigned char *block = static_cast<unsigned char *> (
+          zmq::hugepage_pool_t::allocate (sizes[i], NULL));
+        TEST_ASSERT_NOT_NULL (block);
+#ifndef ZMQ_HAVE_WINDOWS
+        TEST_ASSERT_EQUAL_UINT (0, reinterpret_cast<size_t> (block) % 64);
+#endif
+        if (sizes[i] > 0) {
+            memset (block, 0xab, sizes[i]);
+            TEST_ASSERT_EQUAL_UINT8 (0xab, block[sizes[i] - 1]);
+        }
+        zmq::hugepage_pool_t::deallocate (block, NULL);
+    }
+}
+
+void test_deallocate_null ()
+{
+    zmq::hugepage_pool_t::deallocate (NULL, NULL);
+}
+
+void test_blocks_do_not_overlap ()
+{
+    //  More blocks of a class than fit in one region.
+    const size_t size = 20000;
+    const size_t count = 300;
+    std::vector<unsigned char *> blocks (count);
+    for (size_t i = 0; i < count; i++) {
+        blocks[i] = static_cast<unsigned char *> (
+          zmq::hugepage_pool_t::allocate (size, NULL));
+        TEST_ASSERT_NOT_NULL (blocks[i]);
+        memset (blocks[i], static_cast<int> (i), size);
+    }
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT8 (static_cast<unsigned char> (i),
+                                 blocks[i][0]);
+        TEST_ASSERT_EQUAL_UINT8 (static_cast<unsigned char> (i),
+                                 blocks[i][size - 1]);
+        zmq::hugepage_pool_t::deallocate (blocks[i], NULL);
+    }
+}
+
+void test_reuse ()
+{
+#ifndef ZMQ_HAVE_WINDOWS
+    void *block = zmq::hugepage_pool_t::allocate (1000, NULL);
+    TEST_ASSERT_NOT_NULL (block);
+    zmq::hugepage_pool_t::deallocate (block, NULL);
+
+    //  Freed blocks are handed out again, also for other sizes of the
+    //  same class.
+    void *again = zmq::hugepage_pool_t::allocate (900, NULL);
+    TEST_ASSERT_EQUAL_PTR (block, again);
+    zmq::hugepage_pool_t::deallocate (again, NULL);
+#endif
+}
+
+static void free_blocks (void *blocks_)
+{
+    std::vector<void *> &blocks = *static_cast<std::vector<void *> *> (blocks_);
+    for (size_t i = 0; i < blocks.size (); i++)
+        zmq::hugepage_pool_t::deallocate (blocks[i], NULL);
+}
+
+void test_free_on_other_thread ()
+{
+    std::vector<void *> blocks (100);
+    for (size_t i = 0; i < blocks.size (); i++) {
+        blocks[i] = zmq::hugepage_pool_t::allocate (5000, NULL);
+        TEST_ASSERT_NOT_NULL (blocks[i]);
+    }
+    void *thread = zmq_threadstart (free_blocks, &blocks);
+    zmq_threadclose (thread);
+
+    //  The blocks are handed out again once the thread has exited.
+    for (size_t i = 0; i < blocks.size (); i++) {
+        blocks[i] = zmq::hugepage_pool_t::allocate (5000, NULL);
+        TEST_ASSERT_NOT_NULL (blocks[i]);
+    }
+    free_blocks (&blocks);
+}
+
+#ifdef ZMQ_HAVE_LINUX
+static bool is_mapped (void *ptr_)
+{
+    const uintptr_t page_size = static_cast<uintptr_t> (getpagesize ());
+    void *const page = reinterpret_cast<void *> (
+      reinterpret_cast<uintptr_t> (ptr_) & ~(page_size - 1));
+    unsigned char resident;
+    return mincore (page, 1, &resident) == 0;
+}
+
+void test_release_free_regions ()
+{
+    //  Three blocks of the largest class fit in a region.
+    const size_t count = 30;
+    std::vector<void *> blocks (count);
+    for (size_t i = 0; i < count; i++) {
+        blocks[i] = zmq::hugepage_pool_t::allocate (500000, NULL);
+        TEST_ASSERT_NOT_NULL (blocks[i]);
+    }
+    free_blocks (&blocks);
+
+    //  What stays mapped are the regions of the few blocks in this
+    //  thread's cache and one free region.
+    size_t mapped = 0;
+    for (size_t i = 0; i < count; i++)
+        if (is_mapped (blocks[i]))
+            mapped++;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT (9, mapped);
+}
+#endif
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_allocate_sizes);
+    RUN_TEST (test_deallocate_null);
+    RUN_TEST (test_blocks_do_not_overlap);
+    RUN_TEST (test_reuse);
+    RUN_TEST (test_free_on_other_thread);
+#ifdef ZMQ_HAVE_LINUX
+    RUN_TEST (test_release_free_regions);
+#endif
+    return UNITY_END ();
+}
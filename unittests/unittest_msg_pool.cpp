@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include <msg_pool.hpp>
+
+#include <string.h>
+#include <unity.h>
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_allocate_sizes ()
+{
+    //  Covers the smallest class, a class boundary and the malloc path.
+    const size_t sizes[] = {1, 64, 100, 8192, 1024 * 1024};
+    for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+        unsigned char *block =
+          static_cast<unsigned char *> (zmq::msg_pool_t::allocate (sizes[i]));
+        TEST_ASSERT_NOT_NULL (block);
+        memset (block, 0xab, sizes[i]);
+        TEST_ASSERT_EQUAL_UINT8 (0xab, block[sizes[i] - 1]);
+        zmq::msg_pool_t::deallocate (block);
+    }
+}
+
+void test_deallocate_null ()
+{
+    zmq::msg_pool_t::deallocate (NULL);
+}
+
+void test_reuse_on_same_thread ()
+{
+#ifndef ZMQ_HAVE_WINDOWS
+    void *block = zmq::msg_pool_t::allocate (1000);
+    TEST_ASSERT_NOT_NULL (block);
+    zmq::msg_pool_t::deallocate (block);
+
+    //  The block comes back from the thread's cache, also for other sizes
+    //  of the same class.
+    void *again = zmq::msg_pool_t::allocate (900);
+    TEST_ASSERT_EQUAL_PTR (block, again);
+    zmq::msg_pool_t::deallocate (again);
+#endif
+}
+
+static const size_t cross_thread_blocks = 10000;
+
+static void free_blocks (void *blocks_)
+{
+    std::vector<void *> &blocks = *static_cast<std::vector<void *> *> (blocks_);
+    for (size_t i = 0; i < blocks.size (); i++) {
+        TEST_ASSERT_EQUAL_UINT32 (i, *static_cast<uint32_t *> (blocks[i]));
+        zmq::msg_pool_t::deallocate (blocks[i]);
+    }
+}
+
+void test_free_on_other_thread ()
+{
+    //  Allocate on this thread, free on another, then allocate again so
+    //  that blocks come back through the shared lists.
+    for (int round = 0; round < 3; round++) {
+        std::vector<void *> blocks (cross_thread_blocks);
+        for (size_t i = 0; i < cross_thread_blocks; i++) {
+            blocks[i] = zmq::msg_pool_t::allocate (512);
+            TEST_ASSERT_NOT_NULL (blocks[i]);
+            *static_cast<uint32_t *> (blocks[i]) = static_cast<uint32_t> (i);
+        }
+        void *thread = zmq_threadstart (free_blocks, &blocks);
+        zmq_threadclose (thread);
+    }
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_allocate_sizes);
+    RUN_TEST (test_deallocate_null);
+    RUN_TEST (test_reuse_on_same_thread);
+    RUN_TEST (test_free_on_other_thread);
+    return UNITY_END ();
+}
@@ -0,0 +1,287 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil_unity.hpp"
+
+// TODO: remove this ugly hack
+#ifdef close
+#undef close
+#endif
+
+#include <msg.hpp>
+#include <random.hpp>
+
+#ifdef ZMQ_HAVE_WS
+#include <ws_decoder.hpp>
+#include <ws_encoder.hpp>
+#include <ws_mask.hpp>
+#endif
+
+#include <unity.h>
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+void setUp ()
+{
+}
+
+void tearDown ()
+{
+}
+
+#ifdef ZMQ_HAVE_WS
+static const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+
+static void mask_bytewise (unsigned char *dest_,
+                           const unsigned char *src_,
+                           size_t size_,
+                           size_t offset_)
+{
+    for (size_t i = 0; i < size_; i++)
+        dest_[i] = src_[i] ^ mask[(offset_ + i) % 4];
+}
+#endif
+
+//  Every combination of length, phase and alignment of both buffers.
+void test_mask_matches_bytewise ()
+{
+#ifdef ZMQ_HAVE_WS
+    const size_t max_size = 200;
+    const size_t max_misalignment = 32;
+    std::vector<unsigned char> src (max_size + max_misalignment);
+    std::vector<unsigned char> expected (max_size);
+    std::vector<unsigned char> dest (max_size + max_misalignment + 1);
+    for (size_t i = 0; i < src.size (); i++)
+        src[i] = static_cast<unsigned char> (i * 7 + 3);
+
+    for (size_t size = 0; size <= max_size; size++)
+        for (size_t offset = 0; offset < 4; offset++)
+            for (size_t misalignment = 0; misalignment < max_misalignment;
+                 misalignment += 3) {
+                const unsigned char *in = &src[misalignment];
+                unsigned char *out = &dest[max_misalignment - misalignment];
+                mask_bytewise (&expected[0], in, size, offset);
+                memset (&dest[0], 0xee, dest.size ());
+                zmq::ws_mask (out, in, size, mask, offset);
+                if (size)
+                    TEST_ASSERT_EQUAL_MEMORY (&expected[0], out, size);
+                TEST_ASSERT_EQUAL_UINT8 (0xee, out[size]);
+            }
+#endif
+}
+
+void test_mask_in_place ()
+{
+#ifdef ZMQ_HAVE_WS
+    const size_t size = 1000;
+    std::vector<unsigned char> data (size + 1);
+    std::vector<unsigned char> expected (size);
+    for (size_t i = 0; i < data.size (); i++)
+        data[i] = static_cast<unsigned char> (i);
+
+    for (size_t offset = 0; offset < 4; offset++) {
+        mask_bytewise (&expected[0], &data[1], size, offset);
+        zmq::ws_mask (&data[1], &data[1], size, mask, offset);
+        TEST_ASSERT_EQUAL_MEMORY (&expected[0], &data[1], size);
+        zmq::ws_mask (&data[1], &data[1], size, mask, offset);
+    }
+#endif
+}
+
+//  Frames from an encoder decode back to the message, whether masked by
+//  a client or not and whether split into fragments or not.
+static void test_encoder_to_decoder (size_t size_,
+                                     bool must_mask_ = true,
+                                     size_t fragment_size_ = 0,
+                                     size_t expected_frames_ = 1)
+{
+#ifdef ZMQ_HAVE_WS
+    const zmq::allocator_t hooks = {NULL, NULL, NULL};
+    zmq::ws_encoder_t encoder (8192, must_mask_, hooks, NULL, 0,
+                               fragment_size_);
+    zmq::ws_decoder_t decoder (8192, -1, false, must_mask_, hooks);
+
+    zmq::msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (msg.init_size (size_));
+    for (size_t i = 0; i < size_; i++)
+        static_cast<unsigned char *> (msg.data ())[i] =
+          static_cast<unsigned char> (i * 13);
+    msg.set_flags (zmq::msg_t::more);
+    encoder.load_msg (&msg);
+
+    std::vector<unsigned char> stream;
+    unsigned char *data = NULL;
+    size_t size;
+    while ((size = encoder.encode (&data, 0)) > 0) {
+        stream.insert (stream.end (), data, data + size);
+        data = NULL;
+    }
+
+    //  Walk the frame headers: all but the last lack FIN, all but the
+    //  first are continuations.
+    size_t frames = 0;
+    for (size_t pos = 0; pos < stream.size (); frames++) {
+        uint64_t payload = stream[pos + 1] & 0x7f;
+        size_t header = 2;
+        if (payload == 126) {
+            payload = (stream[pos + 2] << 8) | stream[pos + 3];
+            header = 4;
+        } else if (payload == 127) {
+            payload = 0;
+            for (size_t i = 0; i < 8; i++)
+                payload = (payload << 8) | stream[pos + 2 + i];
+            header = 10;
+        }
+        if (must_mask_)
+            header += 4;
+        if (fragment_size_)
+            TEST_ASSERT_LESS_OR_EQUAL_UINT64 (fragment_size_, payload);
+        const bool last = pos + header + payload == stream.size ();
+        TEST_ASSERT_EQUAL_UINT8 ((last ? 0x80 : 0x00) | (frames ? 0x00 : 0x02),
+                                 stream[pos]);
+        pos += header + static_cast<size_t> (payload);
+    }
+    TEST_ASSERT_EQUAL_UINT (expected_frames_, frames);
+
+    //  Feed the decoder in pieces that end anywhere in a frame.
+    size_t pos = 0;
+    int rc = 0;
+    while (rc == 0 && pos < stream.size ()) {
+        size_t used = 0;
+        const size_t piece = std::min<size_t> (777, stream.size () - pos);
+        rc = decoder.decode (&stream[pos], piece, used);
+        pos += used;
+    }
+    TEST_ASSERT_EQUAL_INT (1, rc);
+    TEST_ASSERT_EQUAL_UINT (stream.size (), pos);
+    TEST_ASSERT_EQUAL_UINT (size_, decoder.msg ()->size ());
+    TEST_ASSERT_TRUE (decoder.msg ()->flags () & zmq::msg_t::more);
+    for (size_t i = 0; i < size_; i++)
+        TEST_ASSERT_EQUAL_UINT8 (
+          static_cast<unsigned char> (i * 13),
+          static_cast<unsigned char *> (decoder.msg ()->data ())[i]);
+#else
+    LIBZMQ_UNUSED (size_);
+    LIBZMQ_UNUSED (must_mask_);
+    LIBZMQ_UNUSED (fragment_size_);
+    LIBZMQ_UNUSED (expected_frames_);
+#endif
+}
+
+void test_encoder_to_decoder_small ()
+{
+    test_encoder_to_decoder (5);
+}
+
+void test_encoder_to_decoder_large ()
+{
+    test_encoder_to_decoder (100003);
+}
+
+void test_fragments_masked ()
+{
+    //  The flags byte goes into the first fragment.
+    test_encoder_to_decoder (100003, true, 1000, 101);
+    test_encoder_to_decoder (999, true, 1000, 1);
+    test_encoder_to_decoder (1000, true, 1000, 2);
+    test_encoder_to_decoder (1000, true, 1, 1001);
+}
+
+void test_fragments_unmasked ()
+{
+    test_encoder_to_decoder (100003, false, 70000, 2);
+    test_encoder_to_decoder (5, false, 2, 3);
+    test_encoder_to_decoder (0, false, 1, 1);
+}
+
+#ifdef ZMQ_HAVE_WS
+//  Decodes unmasked frames as a client would, returns the result of the
+//  last call to decode.
+static int decode_frames (zmq::ws_decoder_t *decoder_,
+                          const unsigned char *frames_,
+                          size_t size_)
+{
+    size_t pos = 0;
+    int rc = 0;
+    while (rc == 0 && pos < size_) {
+        size_t used = 0;
+        rc = decoder_->decode (frames_ + pos, size_ - pos, used);
+        pos += used;
+    }
+    return rc;
+}
+#endif
+
+//  Control frames may come between the fragments of a message.
+void test_ping_between_fragments ()
+{
+#ifdef ZMQ_HAVE_WS
+    const zmq::allocator_t hooks = {NULL, NULL, NULL};
+    zmq::ws_decoder_t decoder (8192, -1, false, false, hooks);
+
+    const unsigned char first[] = {0x02, 3, 0, 'a', 'b'};
+    const unsigned char ping[] = {0x89, 2, 'h', 'i'};
+    const unsigned char last[] = {0x80, 2, 'c', 'd'};
+
+    TEST_ASSERT_EQUAL_INT (0, decode_frames (&decoder, first, sizeof first));
+    TEST_ASSERT_EQUAL_INT (1, decode_frames (&decoder, ping, sizeof ping));
+    TEST_ASSERT_TRUE (decoder.msg ()->is_ping ());
+    TEST_ASSERT_EQUAL_UINT (2, decoder.msg ()->size ());
+    TEST_ASSERT_EQUAL_INT (1, decode_frames (&decoder, last, sizeof last));
+    TEST_ASSERT_FALSE (decoder.msg ()->is_ping ());
+    TEST_ASSERT_EQUAL_UINT (4, decoder.msg ()->size ());
+    TEST_ASSERT_EQUAL_MEMORY ("abcd", decoder.msg ()->data (), 4);
+#endif
+}
+
+#ifdef ZMQ_HAVE_WS
+static void test_rejected (const unsigned char *frames_, size_t size_)
+{
+    const zmq::allocator_t hooks = {NULL, NULL, NULL};
+    zmq::ws_decoder_t decoder (8192, -1, false, false, hooks);
+    TEST_ASSERT_EQUAL_INT (-1, decode_frames (&decoder, frames_, size_));
+}
+#endif
+
+void test_bad_fragments ()
+{
+#ifdef ZMQ_HAVE_WS
+    //  A continuation of nothing.
+    const unsigned char continuation[] = {0x80, 2, 0, 'a'};
+    test_rejected (continuation, sizeof continuation);
+
+    //  A new message before the last one is complete.
+    const unsigned char interrupted[] = {0x02, 2, 0, 'a', 0x82, 2, 0, 'b'};
+    test_rejected (interrupted, sizeof interrupted);
+
+    //  A fragmented ping.
+    const unsigned char ping[] = {0x09, 1, 'a', 0x80, 1, 'b'};
+    test_rejected (ping, sizeof ping);
+
+    //  A message without its flags byte.
+    const unsigned char empty[] = {0x02, 0, 0x80, 0};
+    test_rejected (empty, sizeof empty);
+#endif
+}
+
+int main ()
+{
+    setup_test_environment ();
+    zmq::random_open ();
+
+    UNITY_BEGIN ();
+
+    RUN_TEST (test_mask_matches_bytewise);
+    RUN_TEST (test_mask_in_place);
+    RUN_TEST (test_encoder_to_decoder_small);
+    RUN_TEST (test_encoder_to_decoder_large);
+    RUN_TEST (test_fragments_masked);
+    RUN_TEST (test_fragments_unmasked);
+    RUN_TEST (test_ping_between_fragments);
+    RUN_TEST (test_bad_fragments);
+
+    zmq::random_close ();
+
+    return UNITY_END ();
+}
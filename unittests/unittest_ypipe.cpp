@@ -3,6 +3,8 @@
 #include "../tests/testutil.hpp"
 
 #include <ypipe.hpp>
+#include <ypipe_conflate.hpp>
+#include <chunk_cache.hpp>
 
 #include <unity.h>
 
@@ -55,6 +57,99 @@ void test_write_complete_and_flush_and_check_read_and_read ()
     TEST_ASSERT_EQUAL_INT (value, read_value);
 }
 
+static void write_and_read (zmq::ypipe_t<int, 1> &ypipe_, int count_)
+{
+    for (int i = 0; i != count_; ++i)
+        ypipe_.write (i, false);
+    ypipe_.flush ();
+    for (int i = 0; i != count_; ++i) {
+        int read_value = -1;
+        TEST_ASSERT_TRUE (ypipe_.read (&read_value));
+        TEST_ASSERT_EQUAL_INT (i, read_value);
+    }
+    TEST_ASSERT_FALSE (ypipe_.check_read ());
+}
+
+void test_runtime_granularity ()
+{
+    zmq::ypipe_t<int, 1> ypipe (7);
+    write_and_read (ypipe, 100);
+    write_and_read (ypipe, 3);
+}
+
+void test_chunk_cache ()
+{
+    const int granularity = 5;
+    const size_t chunk_size = zmq::yqueue_t<int, 1>::chunk_size (granularity);
+    zmq::chunk_cache_t cache (chunk_size, 4 * chunk_size, false);
+    TEST_ASSERT_EQUAL_UINT (chunk_size, cache.chunk_size ());
+
+    //  Chunks freed by a drained pipe are handed to the next one.
+    void *chunk = cache.allocate ();
+    TEST_ASSERT_NOT_NULL (chunk);
+    cache.deallocate (chunk);
+    TEST_ASSERT_EQUAL_PTR (chunk, cache.allocate ());
+    cache.deallocate (chunk);
+
+    //  More chunks than the cache holds.
+    {
+        zmq::ypipe_t<int, 1> ypipe1 (granularity, &cache);
+        zmq::ypipe_t<int, 1> ypipe2 (granularity, &cache);
+        write_and_read (ypipe1, 100);
+        write_and_read (ypipe2, 100);
+        write_and_read (ypipe1, 7);
+    }
+}
+
+static void write_int (zmq::ypipe_conflate_t<zmq::msg_t> &ypipe_, int value_)
+{
+    zmq::msg_t msg;
+    TEST_ASSERT_EQUAL_INT (0, msg.init_size (sizeof (value_)));
+    memcpy (msg.data (), &value_, sizeof (value_));
+    ypipe_.write (msg, false);
+}
+
+static int read_int (zmq::ypipe_conflate_t<zmq::msg_t> &ypipe_)
+{
+    zmq::msg_t msg;
+    TEST_ASSERT_TRUE (ypipe_.read (&msg));
+    TEST_ASSERT_EQUAL_UINT (sizeof (int), msg.size ());
+    int value;
+    memcpy (&value, msg.data (), sizeof (value));
+    TEST_ASSERT_EQUAL_INT (0, msg.close ());
+    return value;
+}
+
+void test_conflate_check_read_empty ()
+{
+    zmq::ypipe_conflate_t<zmq::msg_t> ypipe;
+    TEST_ASSERT_FALSE (ypipe.check_read ());
+    zmq::msg_t msg;
+    TEST_ASSERT_FALSE (ypipe.read (&msg));
+}
+
+void test_conflate_keeps_last ()
+{
+    zmq::ypipe_conflate_t<zmq::msg_t> ypipe;
+    for (int i = 0; i != 3; ++i)
+        write_int (ypipe, i);
+    TEST_ASSERT_TRUE (ypipe.check_read ());
+    TEST_ASSERT_EQUAL_INT (2, read_int (ypipe));
+    TEST_ASSERT_FALSE (ypipe.check_read ());
+}
+
+void test_conflate_write_after_check_read ()
+{
+    zmq::ypipe_conflate_t<zmq::msg_t> ypipe;
+    write_int (ypipe, 1);
+    TEST_ASSERT_TRUE (ypipe.check_read ());
+    write_int (ypipe, 2);
+    TEST_ASSERT_EQUAL_INT (2, read_int (ypipe));
+    TEST_ASSERT_FALSE (ypipe.check_read ());
+    write_int (ypipe, 3);
+    TEST_ASSERT_EQUAL_INT (3, read_int (ypipe));
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -65,6 +160,11 @@ int main (void)
     RUN_TEST (test_read_empty);
     RUN_TEST (test_write_complete_and_check_read_and_read);
     RUN_TEST (test_write_complete_and_flush_and_check_read_and_read);
+    RUN_TEST (test_runtime_granularity);
+    RUN_TEST (test_chunk_cache);
+    RUN_TEST (test_conflate_check_read_empty);
+    RUN_TEST (test_conflate_keeps_last);
+    RUN_TEST (test_conflate_write_after_check_read);
 
     return UNITY_END ();
 }